@@ -0,0 +1,207 @@
+#include "access-log.h"
+#include "logger.h"
+#include "utils.h"
+#include <chrono>
+#include <charconv>
+#include <ctime>
+#include <limits>
+#include <algorithm>
+#include <cstring>
+
+static constexpr size_t BATCH_BYTES = 32 * 1024; // Batched bytes handed to the Logger at once
+static constexpr size_t MAX_TARGET = 2048;       // Target bytes kept per record
+static constexpr size_t MAX_ADDRESS = 64;        // Client address bytes kept per record
+static constexpr size_t PHASE_COUNT = 7;         // headers, body, queue, handler, wait, send, total
+static constexpr size_t BINARY_FIXED = 24 + PHASE_COUNT * 4; // Binary record bytes before its strings
+static constexpr size_t MAX_RECORD = MAX_TARGET + MAX_ADDRESS + 320; // Longest record in either format
+
+static const std::string_view PHASE_NAMES[PHASE_COUNT] = {
+    " headers=", " body=", " queue=", " handler=", " wait=", " send=", " total="
+};
+
+static AccessLogFormat logFormat = AccessLogFormat::Text; // Set from the command line before the reactors start
+static thread_local std::string batch;                    // Records of this thread not yet handed to the Logger
+
+/**
+ * @brief Returns the time between two stamps, 0 if either is missing or they are out of order.
+ */
+static uint64_t span(uint64_t from, uint64_t to) {
+    return from != 0 && to > from ? to - from : 0;
+}
+
+/**
+ * @brief Copies text to out and returns the position after it.
+ */
+static char* put(char* out, std::string_view text) {
+    std::memcpy(out, text.data(), text.size());
+    return out + text.size();
+}
+
+/**
+ * @brief Writes a number in decimal and returns the position after it.
+ */
+static char* putNumber(char* out, uint64_t value) {
+    return std::to_chars(out, out + 20, value).ptr;
+}
+
+/**
+ * @brief Writes the low bytes of a value in little-endian order and returns the position after them.
+ * @param out Output position
+ * @param value Value to write
+ * @param bytes Number of bytes (1 to 8)
+ */
+static char* putLittleEndian(char* out, uint64_t value, size_t bytes) {
+    for (size_t i = 0; i < bytes; ++i) {
+        out[i] = static_cast<char>((value >> (8 * i)) & 0xff);
+    }
+    return out + bytes;
+}
+
+/**
+ * @brief Writes a timestamp as YYYY-MM-DD HH:MM:SS.mmm and returns the position after it.
+ * @details The seconds part is cached per thread, so strftime runs at most once per second.
+ */
+static char* putTimestamp(char* out, std::chrono::system_clock::time_point time) {
+    using namespace std::chrono;
+    static thread_local std::time_t cachedSecond = -1;
+    static thread_local char cachedText[32];
+    static thread_local size_t cachedLength = 0;
+    std::time_t now_c = system_clock::to_time_t(time);
+    if (now_c != cachedSecond) {
+        tm timeInfo;
+#ifdef _WIN32
+        localtime_s(&timeInfo, &now_c);
+#else
+        localtime_r(&now_c, &timeInfo);
+#endif
+        cachedLength = std::strftime(cachedText, sizeof(cachedText), "%Y-%m-%d %H:%M:%S", &timeInfo);
+        cachedSecond = now_c;
+    }
+    long long ms = duration_cast<milliseconds>(time.time_since_epoch()).count() % 1000;
+    out = put(out, std::string_view(cachedText, cachedLength));
+    *out++ = '.';
+    *out++ = static_cast<char>('0' + ms / 100);
+    *out++ = static_cast<char>('0' + ms / 10 % 10);
+    *out++ = static_cast<char>('0' + ms % 10);
+    return out;
+}
+
+/**
+ * @brief Sets the access log format.
+ * @details Call before the reactors start; the format is read without synchronization.
+ * @param format Off, Text or Binary
+ */
+void AccessLog::setFormat(AccessLogFormat format) {
+    logFormat = format;
+}
+
+/**
+ * @brief Returns true if requests are logged.
+ */
+bool AccessLog::enabled() {
+    return logFormat != AccessLogFormat::Off;
+}
+
+/**
+ * @brief Appends the record of a completed response to the calling thread's batch.
+ * @details The batch goes to the Logger once it holds BATCH_BYTES; flush() sends the rest.
+ *          Bytes of the target that could break a text line are written as '?'.
+ * @param clientAddr Client address ("ip:port")
+ * @param entry Stamps and outcome of the request
+ */
+void AccessLog::record(const std::string& clientAddr, const AccessRecord& entry) {
+    uint64_t phases[PHASE_COUNT] = {
+        span(entry.firstByteUs, entry.headersUs), span(entry.headersUs, entry.bodyUs),
+        span(entry.bodyUs, entry.dispatchUs), span(entry.dispatchUs, entry.handledUs),
+        span(entry.handledUs, entry.firstSentUs), span(entry.firstSentUs, entry.lastSentUs),
+        span(entry.firstByteUs, entry.lastSentUs)
+    };
+    std::string_view address(clientAddr.data(), (std::min)(clientAddr.size(), MAX_ADDRESS));
+    std::string_view target(entry.target.data(), (std::min)(entry.target.size(), MAX_TARGET));
+    std::chrono::system_clock::time_point now = std::chrono::system_clock::now();
+    // Built on the stack and appended once: cheaper than growing the batch field by field
+    char line[MAX_RECORD];
+    char* out = line;
+    if (logFormat == AccessLogFormat::Binary) {
+        uint64_t wallUs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(now.time_since_epoch()).count());
+        out = putLittleEndian(out, BINARY_FIXED + address.size() + target.size(), 2);
+        out = putLittleEndian(out, entry.status, 2);
+        out = putLittleEndian(out, static_cast<uint8_t>(entry.method), 1);
+        out = putLittleEndian(out, address.size(), 1);
+        out = putLittleEndian(out, target.size(), 2);
+        out = putLittleEndian(out, wallUs, 8);
+        out = putLittleEndian(out, entry.bytes, 8);
+        for (uint64_t phase : phases) {
+            out = putLittleEndian(out, (std::min)(phase, uint64_t(std::numeric_limits<uint32_t>::max())), 4);
+        }
+        out = put(out, address);
+        out = put(out, target);
+    }
+    else {
+        *out++ = '[';
+        out = putTimestamp(out, now);
+        out = put(out, "] [");
+        out = put(out, address);
+        out = put(out, "] ");
+        std::string_view method = methodName(entry.method);
+        out = put(out, method.empty() ? std::string_view("-") : method);
+        *out++ = ' ';
+        if (target.empty()) {
+            *out++ = '-';
+        }
+        for (char c : target) {
+            unsigned char byte = static_cast<unsigned char>(c);
+            *out++ = byte <= ' ' || byte == 0x7f ? '?' : c;
+        }
+        *out++ = ' ';
+        out = putNumber(out, entry.status);
+        *out++ = ' ';
+        out = putNumber(out, entry.bytes);
+        for (size_t i = 0; i < PHASE_COUNT; ++i) {
+            out = put(out, PHASE_NAMES[i]);
+            out = putNumber(out, phases[i]);
+        }
+        *out++ = '\n';
+    }
+    batch.append(line, static_cast<size_t>(out - line));
+    if (batch.size() >= BATCH_BYTES) {
+        flush();
+    }
+}
+
+/**
+ * @brief Hands the calling thread's batch to the Logger.
+ * @details Called when the batch fills, from the housekeeping timer and when a reactor stops,
+ *          so records reach the file within a housekeeping interval.
+ */
+void AccessLog::flush() {
+    if (batch.empty()) {
+        return;
+    }
+    LogRecord record;
+    record.binary = logFormat == AccessLogFormat::Binary;
+    record.path = logSink() + (record.binary ? "/web-server-access.bin" : "/web-server-access.log");
+    record.text = std::move(batch);
+    Logger::instance().submit(std::move(record));
+    batch.clear();
+    batch.reserve(BATCH_BYTES + BATCH_BYTES / 4);
+}
+
+/**
+ * @brief Parses an access log format name.
+ * @param name "off", "text" or "binary"
+ * @param format Output format
+ * @return True if the name is known
+ */
+bool parseAccessLogFormat(const std::string& name, AccessLogFormat& format) {
+    static const std::pair<const char*, AccessLogFormat> names[] = {
+        { "off", AccessLogFormat::Off }, { "text", AccessLogFormat::Text }, { "binary", AccessLogFormat::Binary }
+    };
+    for (const auto& entry : names) {
+        if (name == entry.first) {
+            format = entry.second;
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include <string>
+#include <cstdint>
+#include "router.h"
+
+/**
+ * @brief Output format of the access log.
+ */
+enum class AccessLogFormat {
+    Off,    // No access log
+    Text,   // One line per request in web-server-access.log
+    Binary  // One fixed-layout record per request in web-server-access.bin
+};
+
+/**
+ * @brief Timestamps and outcome of one request, from its first byte in to its last byte out.
+ * @details Stamps are metricsClockUs() values, 0 while a phase has not happened. The record
+ *          travels with the request: Client fills the receive side, queueResponse() moves it into
+ *          the OutboundResponse, and the send side is stamped until completeResponse() logs it.
+ */
+struct AccessRecord {
+    uint64_t firstByteUs = 0;       // First byte of the request received
+    uint64_t headersUs = 0;         // Request line and headers parsed
+    uint64_t bodyUs = 0;            // Whole message received
+    uint64_t dispatchUs = 0;        // Handler started (metrics latency starts here)
+    uint64_t handledUs = 0;         // Response queued
+    uint64_t firstSentUs = 0;       // First response byte accepted by the socket
+    uint64_t lastSentUs = 0;        // Last response byte accepted by the socket
+    uint64_t bytes = 0;             // Response bytes sent (head and body)
+    std::string target;             // Request target, captured only while the access log is on
+    Method method = Method::Unknown;
+    uint16_t status = 0;
+};
+
+/**
+ * @brief Per-request access log with phase timings.
+ * @details Each line carries the method, target, status, response bytes and, in microseconds:
+ *          headers (first byte to end of headers), body (to end of message), queue (waiting to be
+ *          dispatched, e.g. behind a pipelined request), handler, wait (queued response not yet
+ *          on the wire), send (first to last byte out) and total (first byte in to last byte out).
+ *          Phases that overlap, like a streamed body read while its handler runs, count as 0.
+ *          Records are appended to a per-thread buffer and handed to the Logger ring in batches
+ *          (when the buffer fills and from the housekeeping timer), so a request costs a clock
+ *          read and a few integer conversions rather than a ring push.
+ *
+ *          The binary format is a sequence of little-endian records:
+ *            uint16 record length (including this field), uint16 status, uint8 method (Method),
+ *            uint8 client address length A, uint16 target length T,
+ *            uint64 wall-clock time of the last byte sent (microseconds since the Unix epoch),
+ *            uint64 response bytes, uint32 headers, body, queue, handler, wait, send, total (us),
+ *            then A bytes of client address and T bytes of target.
+ */
+class AccessLog {
+public:
+    // Sets the format (call before the reactors start)
+    static void setFormat(AccessLogFormat format);
+    // Returns true if requests are logged
+    static bool enabled();
+
+    // Appends the record of a completed response to the calling thread's batch
+    static void record(const std::string& clientAddr, const AccessRecord& entry);
+    // Hands the calling thread's batch to the Logger
+    static void flush();
+};
+
+// Parses "off", "text" or "binary"; returns false if unknown
+bool parseAccessLogFormat(const std::string& name, AccessLogFormat& format);
@@ -0,0 +1,216 @@
+#include "admission.h"
+#include <atomic>
+#include <algorithm>
+#include <cmath>
+
+static constexpr size_t MAX_BUCKETS = 64 * 1024; // Addresses tracked per reactor; a new one past this evicts another
+static constexpr size_t EVICTION_SAMPLE = 8;     // Buckets compared when one must be evicted
+static constexpr size_t PRUNE_SLOTS = 4096;      // Hash-table slots pruneBuckets() visits per call
+static constexpr double LAG_SMOOTHING = 0.25;    // Weight of the latest iteration in the lag estimate
+
+static AdmissionLimits defaultLimits;            // Set from the command line before the reactors start
+static std::atomic<size_t> openConnections(0);   // Connections admitted across all reactors
+
+/**
+ * @brief Returns the address part of an "ip:port" client address.
+ * @param clientAddr Address as formatted by Client
+ */
+std::string_view addressOf(std::string_view clientAddr) {
+    size_t colon = clientAddr.rfind(':');
+    return colon == std::string_view::npos ? clientAddr : clientAddr.substr(0, colon);
+}
+
+/**
+ * @brief Creates the admission state of one reactor from the default limits.
+ * @details The 503 sent when shedding is serialized here once: requests on open connections
+ *          share its body and header lines, and refused connections get the whole message.
+ */
+AdmissionControl::AdmissionControl()
+    : settings(defaultLimits), pruneCursor(0), lag(0), wokeUs(0), doneUs(0) {
+    burst = settings.rateBurst > 0 ? settings.rateBurst : (std::max)(settings.ratePerSecond, 1.0);
+    shedBody = std::make_shared<const std::string>("Server overloaded, retry later");
+    shedHeaders = "Content-Type: text/plain\r\nRetry-After: " + std::to_string(settings.retryAfterSeconds) + "\r\n";
+    Response refused = shedResponse();
+    refused.headers["Connection"] = "close";
+    refused.serializeHead(refusalMessage);
+    refusalMessage.append(*shedBody);
+}
+
+/**
+ * @brief Sets the limits used by reactors created afterwards.
+ * @details Call before the reactors start; they copy the limits when they are created.
+ * @param limits Limits from the command line
+ */
+void AdmissionControl::setDefaultLimits(const AdmissionLimits& limits) {
+    defaultLimits = limits;
+}
+
+/**
+ * @brief Counts a new connection against the process-wide cap.
+ * @return True if the connection may be served, false if the cap is reached (nothing counted)
+ */
+bool AdmissionControl::admitConnection() {
+    size_t count = openConnections.fetch_add(1, std::memory_order_relaxed);
+    if (settings.maxConnections != 0 && count >= settings.maxConnections) {
+        openConnections.fetch_sub(1, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Releases a connection counted by admitConnection().
+ */
+void AdmissionControl::releaseConnection() {
+    openConnections.fetch_sub(1, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Adds the tokens earned since the bucket was last refilled.
+ * @param bucket Bucket to refill
+ * @param nowMs Current TimerWheel::now()
+ */
+void AdmissionControl::refill(TokenBucket& bucket, uint64_t nowMs) const {
+    if (nowMs > bucket.updatedMs) {
+        double earned = static_cast<double>(nowMs - bucket.updatedMs) * settings.ratePerSecond / 1000.0;
+        bucket.tokens = (std::min)(burst, bucket.tokens + earned);
+        bucket.updatedMs = nowMs;
+    }
+}
+
+/**
+ * @brief Takes a token from the bucket of a client address.
+ * @details A new address starts with a full bucket. Without a rate limit every request is
+ *          admitted and no bucket is kept. At MAX_BUCKETS a new address first evicts the least
+ *          recently refilled of a few sampled buckets, so the table stays bounded without a scan.
+ * @param clientAddr Client address ("ip:port"; the port is ignored)
+ * @param nowMs Current TimerWheel::now()
+ * @return True if the request may be served
+ */
+bool AdmissionControl::admitRequest(std::string_view clientAddr, uint64_t nowMs) {
+    if (settings.ratePerSecond <= 0) {
+        return true;
+    }
+    std::string_view address = addressOf(clientAddr);
+    auto it = buckets.find(address);
+    if (it == buckets.end()) {
+        if (buckets.size() >= MAX_BUCKETS) {
+            evictBucket();
+        }
+        it = buckets.emplace(std::string(address), TokenBucket{ burst, nowMs }).first;
+    }
+    TokenBucket& bucket = it->second;
+    refill(bucket, nowMs);
+    if (bucket.tokens < 1.0) {
+        return false;
+    }
+    bucket.tokens -= 1.0;
+    return true;
+}
+
+/**
+ * @brief Returns the whole seconds until a client address's bucket holds a token again.
+ * @param clientAddr Client address ("ip:port")
+ * @return Seconds to wait, at least 1
+ */
+unsigned AdmissionControl::retryAfter(std::string_view clientAddr) const {
+    auto it = buckets.find(addressOf(clientAddr));
+    if (it == buckets.end() || settings.ratePerSecond <= 0) {
+        return 1;
+    }
+    double seconds = std::ceil((1.0 - it->second.tokens) / settings.ratePerSecond);
+    return (std::max)(1u, static_cast<unsigned>(seconds));
+}
+
+/**
+ * @brief Drops the buckets that have refilled completely, a slice of the table per call.
+ * @details A full bucket is the same as no bucket, so this only bounds memory. Each call visits
+ *          PRUNE_SLOTS hash-table slots from where the previous one stopped, so a housekeeping
+ *          tick costs the same however many addresses are tracked; a rehash in between only
+ *          makes the sweep skip or revisit a few buckets.
+ * @param nowMs Current TimerWheel::now()
+ */
+void AdmissionControl::pruneBuckets(uint64_t nowMs) {
+    size_t slots = buckets.bucket_count();
+    for (size_t visited = 0; visited < PRUNE_SLOTS && visited < slots; ++visited) {
+        size_t slot = pruneCursor++ % slots;
+        for (auto it = buckets.begin(slot); it != buckets.end(slot);) {
+            auto current = it++;
+            refill(current->second, nowMs);
+            if (current->second.tokens >= burst) {
+                buckets.erase(current->first); // erase() takes no local_iterator
+            }
+        }
+    }
+    pruneCursor %= slots;
+}
+
+/**
+ * @brief Makes room for a new address by evicting a tracked one.
+ * @details Compares the first EVICTION_SAMPLE buckets from the prune cursor on and drops the
+ *          one refilled longest ago, an approximation of least recently used that needs no
+ *          ordering to be maintained per request. The evicted address starts over with a full
+ *          bucket if it returns.
+ */
+void AdmissionControl::evictBucket() {
+    size_t slots = buckets.bucket_count();
+    std::string_view victim;
+    uint64_t oldestMs = UINT64_MAX;
+    size_t sampled = 0;
+    size_t visited = 0;
+    for (; visited < slots && sampled < EVICTION_SAMPLE; ++visited) {
+        size_t slot = (pruneCursor + visited) % slots;
+        for (auto it = buckets.begin(slot); it != buckets.end(slot) && sampled < EVICTION_SAMPLE; ++it, ++sampled) {
+            if (it->second.updatedMs < oldestMs) {
+                oldestMs = it->second.updatedMs;
+                victim = it->first;
+            }
+        }
+    }
+    pruneCursor = (pruneCursor + visited) % slots;
+    if (sampled != 0) {
+        buckets.erase(buckets.find(victim));
+    }
+}
+
+/**
+ * @brief Marks the event loop waking up from its wait.
+ * @details A wait at least as long as the current estimate means the loop ran out of work,
+ *          so nothing is queued behind it: the estimate restarts from zero instead of decaying
+ *          over the next iterations.
+ * @param nowUs Current metricsClockUs()
+ */
+void AdmissionControl::loopWoke(uint64_t nowUs) {
+    if (doneUs != 0 && static_cast<double>(nowUs - doneUs) >= lag) {
+        lag = 0;
+    }
+    wokeUs = nowUs;
+}
+
+/**
+ * @brief Marks the end of an iteration's work and folds its duration into the lag estimate.
+ * @param nowUs Current metricsClockUs()
+ */
+void AdmissionControl::loopDone(uint64_t nowUs) {
+    double busy = static_cast<double>(nowUs - wokeUs);
+    lag += (busy - lag) * LAG_SMOOTHING;
+    doneUs = nowUs;
+}
+
+/**
+ * @brief Returns true while the smoothed lag is above the shedding threshold.
+ */
+bool AdmissionControl::overloaded() const {
+    return settings.shedLagMs != 0 && lag >= static_cast<double>(settings.shedLagMs) * 1000.0;
+}
+
+/**
+ * @brief Returns a 503 Service Unavailable built from the pre-serialized parts.
+ * @details No body is copied: it is shared like a cached file.
+ */
+Response AdmissionControl::shedResponse() const {
+    Response response = Response::fromCache(shedBody, shedHeaders);
+    response.statusCode = 503;
+    response.statusMessage = "Service Unavailable";
+    return response;
+}
@@ -0,0 +1,106 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+#include "response.h"
+
+/**
+ * @brief Admission-control settings shared by every reactor.
+ */
+struct AdmissionLimits {
+    int backlog = 1024;              // Listen backlog (clamped by the kernel to somaxconn)
+    size_t maxConnections = 10000;   // Open connections across all reactors, 0 = unlimited
+    double ratePerSecond = 0;        // Requests per second refilled into each client address's bucket, 0 = unlimited
+    double rateBurst = 0;            // Bucket capacity (0 = one second's worth of ratePerSecond, at least 1)
+    uint64_t shedLagMs = 250;        // Smoothed event-loop lag above which new work gets 503, 0 = never shed
+    unsigned retryAfterSeconds = 1;  // Retry-After of shed responses and refused connections
+};
+
+/**
+ * @brief Token bucket of one client address.
+ */
+struct TokenBucket {
+    double tokens = 0;      // Requests that may be made right now
+    uint64_t updatedMs = 0; // TimerWheel::now() of the last refill
+};
+
+/**
+ * @brief Per-reactor admission control: connection cap, per-address rate limits and load shedding.
+ * @details Connections are counted process-wide so the cap holds however the kernel spreads
+ *          them over the reactors; everything else is owned by one reactor and needs no lock.
+ *          Rate limits are token buckets keyed by the address part of Client::clientAddr; since
+ *          SO_REUSEPORT spreads a client's connections over the reactors by port, each reactor
+ *          enforces the rate on its own share. The event-loop lag is the time one iteration
+ *          spends working, smoothed over recent iterations: it is how long a socket that becomes
+ *          ready can wait before it is served. Once it crosses the threshold new connections
+ *          and new requests are answered with a 503 serialized once up front, until the loop
+ *          catches up or goes idle.
+ */
+class AdmissionControl {
+public:
+    // Creates the state of one reactor from the default limits
+    AdmissionControl();
+
+    AdmissionControl(const AdmissionControl&) = delete;
+    AdmissionControl& operator=(const AdmissionControl&) = delete;
+
+    // Sets the limits used by reactors created afterwards
+    static void setDefaultLimits(const AdmissionLimits& limits);
+    // Returns the limits in effect
+    const AdmissionLimits& limits() const { return settings; }
+
+    // Counts a new connection against the cap; false if the cap is reached
+    bool admitConnection();
+    // Releases a connection counted by admitConnection()
+    void releaseConnection();
+
+    // Takes a token from the bucket of clientAddr ("ip:port"); false if it is empty
+    bool admitRequest(std::string_view clientAddr, uint64_t nowMs);
+    // Returns the whole seconds until clientAddr's bucket holds a token again (at least 1)
+    unsigned retryAfter(std::string_view clientAddr) const;
+    // Drops buckets that have refilled completely, a bounded slice per call (housekeeping)
+    void pruneBuckets(uint64_t nowMs);
+
+    // Marks the event loop waking up from its wait
+    void loopWoke(uint64_t nowUs);
+    // Marks the end of an iteration's work and updates the lag estimate
+    void loopDone(uint64_t nowUs);
+    // Returns the smoothed event-loop lag in microseconds
+    uint64_t lagUs() const { return static_cast<uint64_t>(lag); }
+    // Returns true while new work should be shed
+    bool overloaded() const;
+
+    // Returns a 503 built from the pre-serialized body and headers
+    Response shedResponse() const;
+    // Returns the complete 503 message written to connections refused at accept
+    const std::string& refusal() const { return refusalMessage; }
+
+private:
+    // Hashes string_view and string keys alike, so lookups do not allocate
+    struct AddressHash {
+        using is_transparent = void;
+        size_t operator()(std::string_view key) const { return std::hash<std::string_view>()(key); }
+    };
+
+    AdmissionLimits settings;                                         // Limits in effect
+    double burst;                                                     // Bucket capacity
+    std::unordered_map<std::string, TokenBucket, AddressHash, std::equal_to<>> buckets; // By client address
+    size_t pruneCursor;                                               // Hash-table slot where the next prune or eviction starts
+    double lag;                                                       // Smoothed iteration work time in us
+    uint64_t wokeUs;                                                  // When the current iteration woke up
+    uint64_t doneUs;                                                  // When the previous iteration finished
+    std::shared_ptr<const std::string> shedBody;                      // Body of shed responses
+    std::string shedHeaders;                                          // Header lines of shed responses
+    std::string refusalMessage;                                       // Full 503 for refused connections
+
+    // Refills the bucket to nowMs
+    void refill(TokenBucket& bucket, uint64_t nowMs) const;
+    // Evicts the least recently refilled of a few sampled buckets
+    void evictBucket();
+};
+
+// Returns the address part of an "ip:port" client address
+std::string_view addressOf(std::string_view clientAddr);
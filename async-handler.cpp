@@ -0,0 +1,120 @@
+#include "async-handler.h"
+#include "poller.h"
+
+static thread_local AsyncCall* currentCall = nullptr; // Call being resumed on this thread
+
+/**
+ * @brief Returns the call whose coroutine is running on this thread.
+ */
+AsyncCall* AsyncCall::current() {
+    return currentCall;
+}
+
+/**
+ * @brief Sets the call awaitables record their waits in, around each resume.
+ * @param call Call about to be resumed, or null once resume() returned
+ */
+void AsyncCall::setCurrent(AsyncCall* call) {
+    currentCall = call;
+}
+
+/**
+ * @brief Records what the innermost coroutine waits for.
+ * @param kind Wait kind; its parameters are set by the caller
+ * @param coroutine Coroutine to resume when the wait is over
+ */
+void AsyncCall::suspend(AsyncWait kind, std::coroutine_handle<> coroutine) {
+    wait = kind;
+    armed = false;
+    waiter = coroutine;
+}
+
+/**
+ * @brief Records a timer wait.
+ */
+void SleepAwaiter::await_suspend(std::coroutine_handle<> coroutine) const {
+    AsyncCall& call = *AsyncCall::current();
+    call.delayMs = delayMs;
+    call.suspend(AsyncWait::Timer, coroutine);
+}
+
+/**
+ * @brief Records a socket readiness wait.
+ */
+void SocketAwaiter::await_suspend(std::coroutine_handle<> coroutine) const {
+    AsyncCall& call = *AsyncCall::current();
+    call.socket = socket;
+    call.events = 0;
+    call.suspend(kind, coroutine);
+}
+
+/**
+ * @brief Returns false if the socket reported an error or hang-up, or timed out, instead of readiness.
+ */
+bool SocketAwaiter::await_resume() const {
+    return (AsyncCall::current()->events & POLL_ERROR) == 0;
+}
+
+/**
+ * @brief Records a blocking operation for the I/O pool.
+ */
+void BlockingAwaiter::await_suspend(std::coroutine_handle<> coroutine) {
+    AsyncCall& call = *AsyncCall::current();
+    call.work = std::move(work);
+    call.suspend(AsyncWait::Blocking, coroutine);
+}
+
+/**
+ * @brief Records a wait for the next piece of the request body.
+ */
+void BodyChunkAwaiter::await_suspend(std::coroutine_handle<> coroutine) const {
+    AsyncCall& call = *AsyncCall::current();
+    call.chunk = std::string_view();
+    call.suspend(AsyncWait::BodyChunk, coroutine);
+}
+
+/**
+ * @brief Returns the piece of the body the server handed out (empty at the end of the body).
+ */
+std::string_view BodyChunkAwaiter::await_resume() const {
+    return AsyncCall::current()->chunk;
+}
+
+/**
+ * @brief Suspends the calling handler for a while.
+ * @param delayMs Delay in milliseconds (timer wheel resolution)
+ */
+SleepAwaiter sleepFor(uint64_t delayMs) {
+    return SleepAwaiter{ delayMs };
+}
+
+/**
+ * @brief Suspends the calling handler until socket is readable.
+ * @param socket Non-blocking socket owned by the handler
+ */
+SocketAwaiter readable(SOCKET socket) {
+    return SocketAwaiter{ socket, AsyncWait::Readable };
+}
+
+/**
+ * @brief Suspends the calling handler until socket is writable.
+ * @param socket Non-blocking socket owned by the handler
+ */
+SocketAwaiter writable(SOCKET socket) {
+    return SocketAwaiter{ socket, AsyncWait::Writable };
+}
+
+/**
+ * @brief Runs a blocking operation off the event loop.
+ * @param work Operation run on a pool thread
+ */
+BlockingAwaiter runBlocking(std::function<void()> work) {
+    return BlockingAwaiter{ std::move(work) };
+}
+
+/**
+ * @brief Waits for the next piece of the request body.
+ */
+BodyChunkAwaiter nextBodyChunk() {
+    return BodyChunkAwaiter{};
+}
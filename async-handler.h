@@ -0,0 +1,107 @@
+#pragma once
+#include <coroutine>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include "task.h"
+#include "request.h"
+#include "response.h"
+#include "router.h"
+#include "platform.h"
+
+/**
+ * @brief What a suspended coroutine handler is waiting for.
+ */
+enum class AsyncWait : uint8_t {
+    None,      // Runnable: resumed by the server as soon as it gets to it
+    Timer,     // A delay on the reactor's timer wheel
+    Readable,  // A handler-owned socket becoming readable
+    Writable,  // A handler-owned socket becoming writable
+    Blocking,  // An operation running on the blocking I/O pool
+    BodyChunk  // More of the request body
+};
+
+/**
+ * @brief A coroutine handler in flight, owned by its connection.
+ * @details The handler's Request points into head, a copy of the request head, so it stays
+ *          valid however long the handler is suspended and whatever happens to the connection
+ *          buffer. The body is not copied: it is handed out piece by piece straight from the
+ *          connection buffer by nextBodyChunk(). Awaiting one of the functions below records
+ *          the wait here and suspends; the Server sees the record when resume() returns, arms
+ *          the matching event source and resumes the innermost coroutine once it fires. Nothing
+ *          runs on another thread except the work of a Blocking wait.
+ */
+struct AsyncCall {
+    Task<Response> task;                    // Top-level handler coroutine
+    std::string head;                       // Copy of the request head the Request views point into
+    Request request;                        // Request passed to the handler (body empty; see nextBodyChunk())
+    Method method = Method::Unknown;        // Request method, for the response counters
+    uint64_t startedUs = 0;                 // metricsClockUs() when the handler was started
+    AsyncWait wait = AsyncWait::None;       // What the innermost coroutine waits for
+    bool armed = false;                     // The wait is registered with its event source
+    std::coroutine_handle<> waiter;         // Innermost suspended coroutine, resumed when the wait is over
+    uint64_t delayMs = 0;                   // Timer: delay
+    SOCKET socket = INVALID_SOCKET;         // Readable/Writable: descriptor
+    unsigned events = 0;                    // Readable/Writable: poll events reported on wake-up
+    std::function<void()> work;             // Blocking: operation for the I/O pool
+    std::string_view chunk;                 // BodyChunk: piece handed to the handler, empty at the end
+    size_t chunkLength = 0;                 // Body bytes to release from the connection buffer on the next suspension
+
+    // Returns the call being resumed on this thread (null outside a handler)
+    static AsyncCall* current();
+    // Makes call the one awaitables on this thread record their waits in
+    static void setCurrent(AsyncCall* call);
+    // Records a wait for the innermost coroutine
+    void suspend(AsyncWait kind, std::coroutine_handle<> coroutine);
+};
+
+// Awaitable of sleepFor()
+struct SleepAwaiter {
+    uint64_t delayMs;
+
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> coroutine) const;
+    void await_resume() const noexcept {}
+};
+
+// Awaitable of readable() and writable(); resumes with false if the socket reported an error or hang-up
+// or did not become ready within SOCKET_WAIT_TIMEOUT_MS
+struct SocketAwaiter {
+    SOCKET socket;
+    AsyncWait kind;
+
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> coroutine) const;
+    bool await_resume() const;
+};
+
+// Awaitable of runBlocking()
+struct BlockingAwaiter {
+    std::function<void()> work;
+
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> coroutine);
+    void await_resume() const noexcept {}
+};
+
+// Awaitable of nextBodyChunk()
+struct BodyChunkAwaiter {
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> coroutine) const;
+    std::string_view await_resume() const;
+};
+
+// Suspends the handler for delayMs milliseconds without blocking the reactor
+SleepAwaiter sleepFor(uint64_t delayMs);
+// Suspends the handler until a non-blocking socket it owns can be read
+SocketAwaiter readable(SOCKET socket);
+// Suspends the handler until a non-blocking socket it owns can be written
+SocketAwaiter writable(SOCKET socket);
+// Runs work on the blocking I/O pool (inline without one) and resumes the handler when it is done;
+// work must not touch reactor-owned state, and what it captures by reference lives in the coroutine frame
+BlockingAwaiter runBlocking(std::function<void()> work);
+// Resumes with the next piece of the request body as it arrives, or an empty view at its end;
+// the view is only valid until the handler's next co_await
+BodyChunkAwaiter nextBodyChunk();
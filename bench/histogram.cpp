@@ -0,0 +1,79 @@
+#include "histogram.h"
+#include <cmath>
+
+/**
+ * @brief Returns the bucket of a value.
+ * @details Bucket b of power p (p >= SUB_BITS) covers [2^p + b * 2^(p - SUB_BITS), 2^p + (b + 1) * 2^(p - SUB_BITS)).
+ */
+size_t Histogram::bucketOf(uint64_t value) {
+    if (value < SUB_BUCKETS) {
+        return static_cast<size_t>(value);
+    }
+    unsigned exponent = SUB_BITS;
+    while (exponent < 63 && (value >> (exponent + 1)) != 0) {
+        ++exponent;
+    }
+    size_t index = (exponent - SUB_BITS + 1) * SUB_BUCKETS + static_cast<size_t>((value >> (exponent - SUB_BITS)) & (SUB_BUCKETS - 1));
+    return index < BUCKETS ? index : BUCKETS - 1;
+}
+
+/**
+ * @brief Returns the largest value that falls into a bucket.
+ */
+uint64_t Histogram::upperBound(size_t index) {
+    if (index < SUB_BUCKETS) {
+        return index;
+    }
+    unsigned exponent = static_cast<unsigned>(index / SUB_BUCKETS) - 1 + SUB_BITS;
+    uint64_t sub = index % SUB_BUCKETS;
+    return ((SUB_BUCKETS + sub + 1) << (exponent - SUB_BITS)) - 1;
+}
+
+/**
+ * @brief Records one latency.
+ * @param nanos Latency in nanoseconds
+ */
+void Histogram::record(uint64_t nanos) {
+    counts[bucketOf(nanos)]++;
+    samples++;
+    total += nanos;
+    if (nanos > largest) {
+        largest = nanos;
+    }
+}
+
+/**
+ * @brief Adds every sample of another histogram.
+ */
+void Histogram::merge(const Histogram& other) {
+    for (size_t i = 0; i < BUCKETS; ++i) {
+        counts[i] += other.counts[i];
+    }
+    samples += other.samples;
+    total += other.total;
+    if (other.largest > largest) {
+        largest = other.largest;
+    }
+}
+
+/**
+ * @brief Returns the value at a quantile.
+ * @param q Quantile between 0 and 1 (0.99 = p99)
+ * @return Upper bound of the bucket holding the sample of rank ceil(q * count), capped at max()
+ */
+uint64_t Histogram::percentile(double q) const {
+    if (samples == 0) {
+        return 0;
+    }
+    uint64_t rank = static_cast<uint64_t>(std::ceil(q * static_cast<double>(samples)));
+    rank = rank == 0 ? 1 : rank;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < BUCKETS; ++i) {
+        seen += counts[i];
+        if (seen >= rank) {
+            uint64_t bound = upperBound(i);
+            return bound < largest ? bound : largest;
+        }
+    }
+    return largest;
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * @brief HDR-style latency histogram in nanoseconds with fixed memory.
+ * @details Values below SUB_BUCKETS ns are exact; above, every power of two is split into
+ *          SUB_BUCKETS equal buckets, so any percentile is reported within 1/SUB_BUCKETS
+ *          (about 3%) of the true value. Each load-generator thread records into its own
+ *          histogram and they are merged after the run.
+ */
+class Histogram {
+public:
+    static constexpr unsigned SUB_BITS = 5;                      // log2 of the buckets per power of two
+    static constexpr uint64_t SUB_BUCKETS = 1ull << SUB_BITS;    // Buckets per power of two
+    static constexpr unsigned MAX_EXPONENT = 40;                 // Largest power of two tracked (~18 minutes)
+    static constexpr size_t BUCKETS = (MAX_EXPONENT - SUB_BITS + 2) * SUB_BUCKETS; // Counters
+
+    // Records one latency
+    void record(uint64_t nanos);
+    // Adds every sample of other
+    void merge(const Histogram& other);
+    // Returns the value at quantile q (0..1), as the upper bound of its bucket
+    uint64_t percentile(double q) const;
+    // Returns the number of samples
+    uint64_t count() const { return samples; }
+    // Returns the largest sample
+    uint64_t max() const { return largest; }
+    // Returns the mean sample
+    double mean() const { return samples == 0 ? 0 : static_cast<double>(total) / static_cast<double>(samples); }
+
+private:
+    std::array<uint64_t, BUCKETS> counts{}; // Samples per bucket
+    uint64_t samples = 0;                   // Samples recorded
+    uint64_t total = 0;                     // Sum of the samples
+    uint64_t largest = 0;                   // Largest sample
+
+    // Returns the bucket of a value
+    static size_t bucketOf(uint64_t value);
+    // Returns the largest value of a bucket
+    static uint64_t upperBound(size_t index);
+};
@@ -0,0 +1,271 @@
+#include "json.h"
+#include <cstdlib>
+
+static constexpr int MAX_DEPTH = 64; // Nesting accepted before the document is rejected
+
+/**
+ * @brief Recursive-descent reader over one document.
+ */
+class JsonReader {
+public:
+    explicit JsonReader(std::string_view text) : text(text), pos(0) {}
+
+    /**
+     * @brief Reads the document into out; fails on trailing garbage.
+     */
+    bool document(JsonValue& out, std::string& error) {
+        if (!value(out, 0) || (skipSpace(), pos != text.size())) {
+            error = "invalid JSON near offset " + std::to_string(pos);
+            return false;
+        }
+        return true;
+    }
+
+private:
+    std::string_view text; // Whole document
+    size_t pos;            // Next character
+
+    void skipSpace() {
+        while (pos < text.size() && (text[pos] == ' ' || text[pos] == '\t' || text[pos] == '\n' || text[pos] == '\r')) {
+            ++pos;
+        }
+    }
+
+    bool literal(std::string_view word) {
+        if (text.substr(pos, word.size()) != word) {
+            return false;
+        }
+        pos += word.size();
+        return true;
+    }
+
+    bool value(JsonValue& out, int depth) {
+        skipSpace();
+        if (pos >= text.size() || depth > MAX_DEPTH) {
+            return false;
+        }
+        char c = text[pos];
+        if (c == '{') {
+            out.type = JsonValue::Type::Object;
+            return object(out, depth);
+        }
+        if (c == '[') {
+            out.type = JsonValue::Type::Array;
+            return array(out, depth);
+        }
+        if (c == '"') {
+            out.type = JsonValue::Type::String;
+            return string(out.text);
+        }
+        if (literal("true") || literal("false")) {
+            out.type = JsonValue::Type::Bool;
+            out.boolean = c == 't';
+            return true;
+        }
+        if (literal("null")) {
+            out.type = JsonValue::Type::Null;
+            return true;
+        }
+        return number(out);
+    }
+
+    bool object(JsonValue& out, int depth) {
+        ++pos;
+        skipSpace();
+        if (pos < text.size() && text[pos] == '}') {
+            ++pos;
+            return true;
+        }
+        while (true) {
+            skipSpace();
+            std::string key;
+            if (pos >= text.size() || text[pos] != '"' || !string(key)) {
+                return false;
+            }
+            skipSpace();
+            if (pos >= text.size() || text[pos++] != ':') {
+                return false;
+            }
+            out.members.emplace_back(std::move(key), JsonValue());
+            if (!value(out.members.back().second, depth + 1)) {
+                return false;
+            }
+            skipSpace();
+            if (pos >= text.size()) {
+                return false;
+            }
+            char c = text[pos++];
+            if (c == '}') {
+                return true;
+            }
+            if (c != ',') {
+                return false;
+            }
+        }
+    }
+
+    bool array(JsonValue& out, int depth) {
+        ++pos;
+        skipSpace();
+        if (pos < text.size() && text[pos] == ']') {
+            ++pos;
+            return true;
+        }
+        while (true) {
+            out.items.emplace_back();
+            if (!value(out.items.back(), depth + 1)) {
+                return false;
+            }
+            skipSpace();
+            if (pos >= text.size()) {
+                return false;
+            }
+            char c = text[pos++];
+            if (c == ']') {
+                return true;
+            }
+            if (c != ',') {
+                return false;
+            }
+        }
+    }
+
+    static void appendUtf8(std::string& out, unsigned code) {
+        if (code < 0x80) {
+            out.push_back(static_cast<char>(code));
+        }
+        else if (code < 0x800) {
+            out.push_back(static_cast<char>(0xC0 | (code >> 6)));
+            out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+        }
+        else if (code < 0x10000) {
+            out.push_back(static_cast<char>(0xE0 | (code >> 12)));
+            out.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+        }
+        else {
+            out.push_back(static_cast<char>(0xF0 | (code >> 18)));
+            out.push_back(static_cast<char>(0x80 | ((code >> 12) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+        }
+    }
+
+    bool hex4(unsigned& code) {
+        if (pos + 4 > text.size()) {
+            return false;
+        }
+        code = 0;
+        for (int i = 0; i < 4; ++i) {
+            char c = text[pos++];
+            code <<= 4;
+            if (c >= '0' && c <= '9') code |= static_cast<unsigned>(c - '0');
+            else if (c >= 'a' && c <= 'f') code |= static_cast<unsigned>(c - 'a' + 10);
+            else if (c >= 'A' && c <= 'F') code |= static_cast<unsigned>(c - 'A' + 10);
+            else return false;
+        }
+        return true;
+    }
+
+    bool string(std::string& out) {
+        ++pos;
+        while (pos < text.size()) {
+            char c = text[pos++];
+            if (c == '"') {
+                return true;
+            }
+            if (c != '\\') {
+                out.push_back(c);
+                continue;
+            }
+            if (pos >= text.size()) {
+                return false;
+            }
+            char escape = text[pos++];
+            switch (escape) {
+                case '"': out.push_back('"'); break;
+                case '\\': out.push_back('\\'); break;
+                case '/': out.push_back('/'); break;
+                case 'b': out.push_back('\b'); break;
+                case 'f': out.push_back('\f'); break;
+                case 'n': out.push_back('\n'); break;
+                case 'r': out.push_back('\r'); break;
+                case 't': out.push_back('\t'); break;
+                case 'u': {
+                    unsigned code;
+                    if (!hex4(code)) {
+                        return false;
+                    }
+                    // Surrogate pair
+                    if (code >= 0xD800 && code < 0xDC00 && literal("\\u")) {
+                        unsigned low;
+                        if (!hex4(low) || low < 0xDC00 || low > 0xDFFF) {
+                            return false;
+                        }
+                        code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                    }
+                    appendUtf8(out, code);
+                    break;
+                }
+                default:
+                    return false;
+            }
+        }
+        return false;
+    }
+
+    bool number(JsonValue& out) {
+        size_t start = pos;
+        while (pos < text.size() && (std::string_view("+-0123456789.eE").find(text[pos]) != std::string_view::npos)) {
+            ++pos;
+        }
+        if (pos == start) {
+            return false;
+        }
+        std::string digits(text.substr(start, pos - start));
+        char* end = nullptr;
+        out.type = JsonValue::Type::Number;
+        out.number = std::strtod(digits.c_str(), &end);
+        return end == digits.c_str() + digits.size();
+    }
+};
+
+/**
+ * @brief Returns the member named key.
+ * @return Member value, or null if this is not an object or the key is missing
+ */
+const JsonValue* JsonValue::find(std::string_view key) const {
+    for (const auto& member : members) {
+        if (member.first == key) {
+            return &member.second;
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * @brief Returns the string value, or fallback for any other type.
+ */
+const std::string& JsonValue::asString(const std::string& fallback) const {
+    return type == Type::String ? text : fallback;
+}
+
+/**
+ * @brief Returns the shared empty string.
+ */
+const std::string& JsonValue::empty() {
+    static const std::string none;
+    return none;
+}
+
+/**
+ * @brief Parses a JSON document.
+ * @param text Document text
+ * @param out Receives the tree
+ * @param error Receives a description on failure
+ * @return True if text is one valid JSON value
+ */
+bool parseJson(std::string_view text, JsonValue& out, std::string& error) {
+    out = JsonValue();
+    return JsonReader(text).document(out, error);
+}
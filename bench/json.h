@@ -0,0 +1,33 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <utility>
+
+/**
+ * @brief Minimal JSON document tree, enough to read Postman collections.
+ * @details Numbers are kept as doubles and strings are decoded (escapes, \u sequences as
+ *          UTF-8); object members keep their order.
+ */
+struct JsonValue {
+    enum class Type { Null, Bool, Number, String, Array, Object };
+
+    Type type = Type::Null;
+    bool boolean = false;                                  // Bool value
+    double number = 0;                                     // Number value
+    std::string text;                                      // String value
+    std::vector<JsonValue> items;                          // Array elements
+    std::vector<std::pair<std::string, JsonValue>> members; // Object members in document order
+
+    // Returns the member named key, or null if this is not an object or has no such member
+    const JsonValue* find(std::string_view key) const;
+    // Returns the string value, or fallback if this is not a string
+    const std::string& asString(const std::string& fallback = empty()) const;
+
+private:
+    // Shared empty string for asString()
+    static const std::string& empty();
+};
+
+// Parses a whole JSON document; on failure returns false and describes the problem in error
+bool parseJson(std::string_view text, JsonValue& out, std::string& error);
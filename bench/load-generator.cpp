@@ -0,0 +1,691 @@
+#include "scenario.h"
+#include "histogram.h"
+#include "response-reader.h"
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <map>
+#include <thread>
+#include <atomic>
+#include <fstream>
+#include <iostream>
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+#include <ctime>
+#ifndef __linux__
+#error "web-bench needs Linux (epoll, timerfd)"
+#endif
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <netdb.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <cerrno>
+
+static constexpr size_t READ_BUFFER_BYTES = 64 * 1024;  // Bytes read per recv()
+static constexpr size_t MAX_BACKLOG = 1u << 20;         // Open-loop requests waiting per thread before new ones are dropped
+static constexpr int MAX_EVENTS = 256;                  // Events taken per epoll_wait()
+static constexpr double QUANTILES[] = { 0.5, 0.9, 0.99, 0.999 };
+
+/**
+ * @brief Command-line settings of a run.
+ */
+struct Options {
+    std::string host = "127.0.0.1"; // Server address
+    int port = 8080;                 // Server port
+    unsigned threads = 1;            // Load-generator threads, each with its own epoll loop
+    unsigned connections = 16;       // Connections over all threads
+    double duration = 10;            // Measured seconds
+    double warmup = 1;               // Seconds run before measuring
+    double rate = 0;                 // Requests per second over all threads; 0 = closed loop
+    std::string scenario = "get";    // Built-in scenario
+    std::string collection;          // Postman collection replayed instead of a built-in scenario
+    bool close = false;              // Connection: close on every request
+    std::string jsonPath;            // Machine-readable results file
+    std::string label;               // Free-form build label copied into the results
+};
+
+/**
+ * @brief Counters of one thread, merged after the run.
+ */
+struct WorkerResult {
+    Histogram latency;                   // Measured request latencies (ns)
+    std::vector<Histogram> perRequest;   // Latencies per scenario request
+    std::map<int, uint64_t> statuses;    // Measured responses per status code
+    uint64_t completed = 0;              // Measured responses
+    uint64_t errors = 0;                 // Failed connects, resets and framing errors
+    uint64_t connects = 0;               // Connections opened
+    uint64_t bytesIn = 0;                // Bytes received while measuring
+    uint64_t bytesOut = 0;               // Bytes sent while measuring
+    uint64_t dropped = 0;                // Open loop: requests not scheduled because the backlog was full
+    uint64_t unsent = 0;                 // Open loop: requests still waiting when the run ended
+
+    // Adds another thread's counters
+    void merge(const WorkerResult& other);
+};
+
+/**
+ * @brief One client connection driven by a worker.
+ */
+struct Connection {
+    int fd = -1;                            // Socket, -1 while closed
+    bool connecting = false;                // Non-blocking connect in progress
+    bool busy = false;                      // A request is in flight (or waiting for the connect)
+    size_t next = 0;                        // Next scenario request to send
+    size_t current = 0;                     // Scenario request in flight
+    size_t sent = 0;                        // Bytes of the request already written
+    uint64_t startNs = 0;                   // Intended (open loop) or actual (closed loop) start
+    uint32_t events = 0;                    // Interest registered with epoll
+    ResponseReader reader;                  // Framer of the response in flight
+};
+
+/**
+ * @brief Returns the monotonic clock in nanoseconds.
+ */
+static uint64_t nowNs() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+/**
+ * @brief Adds another thread's counters.
+ */
+void WorkerResult::merge(const WorkerResult& other) {
+    latency.merge(other.latency);
+    if (perRequest.size() < other.perRequest.size()) {
+        perRequest.resize(other.perRequest.size());
+    }
+    for (size_t i = 0; i < other.perRequest.size(); ++i) {
+        perRequest[i].merge(other.perRequest[i]);
+    }
+    for (const auto& status : other.statuses) {
+        statuses[status.first] += status.second;
+    }
+    completed += other.completed;
+    errors += other.errors;
+    connects += other.connects;
+    bytesIn += other.bytesIn;
+    bytesOut += other.bytesOut;
+    dropped += other.dropped;
+    unsent += other.unsent;
+}
+
+/**
+ * @brief One load-generator thread: its own connections, epoll instance and timer.
+ * @details Closed loop: every connection sends its next request as soon as the previous
+ *          response is complete, and latency runs from that send. Open loop: requests are
+ *          scheduled at a fixed rate whether or not a connection is free; a request waits in
+ *          the backlog until one is, and its latency runs from the scheduled time, so a slow
+ *          server is charged for the requests it delayed (coordinated omission is corrected).
+ */
+class Worker {
+public:
+    Worker(const Options& options, const sockaddr_storage& address, socklen_t addressLength,
+        const std::vector<RequestTemplate>& requests, unsigned connectionCount, double rate)
+        : options(options), address(address), addressLength(addressLength), requests(requests),
+          connections(connectionCount), rate(rate), epollFd(-1), timerFd(-1) {
+        result.perRequest.resize(requests.size());
+    }
+
+    ~Worker() {
+        for (Connection& connection : connections) {
+            closeConnection(connection);
+        }
+        if (timerFd != -1) {
+            ::close(timerFd);
+        }
+        if (epollFd != -1) {
+            ::close(epollFd);
+        }
+    }
+
+    Worker(const Worker&) = delete;
+    Worker& operator=(const Worker&) = delete;
+
+    /**
+     * @brief Runs the warmup and the measured period.
+     * @param startNs Common start time of all threads
+     */
+    void run(uint64_t startNs) {
+        measureStart = startNs + static_cast<uint64_t>(options.warmup * 1e9);
+        uint64_t end = measureStart + static_cast<uint64_t>(options.duration * 1e9);
+        epollFd = epoll_create1(EPOLL_CLOEXEC);
+        if (rate > 0) {
+            timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+            epoll_event event{};
+            event.events = EPOLLIN;
+            event.data.u64 = UINT64_MAX;
+            epoll_ctl(epollFd, EPOLL_CTL_ADD, timerFd, &event);
+        }
+        for (size_t i = 0; i < connections.size(); ++i) {
+            connections[i].next = i % requests.size(); // Spread connections over the scenario
+            openConnection(i);
+        }
+        uint64_t scheduled = 0;
+        double interval = rate > 0 ? 1e9 / rate : 0;
+        epoll_event events[MAX_EVENTS];
+        while (true) {
+            uint64_t now = nowNs();
+            if (now >= end) {
+                break;
+            }
+            if (rate > 0) {
+                // Schedule every request whose time has come, then arm the timer for the next
+                uint64_t due = startNs + static_cast<uint64_t>(static_cast<double>(scheduled) * interval);
+                while (due <= now) {
+                    if (backlog.size() < MAX_BACKLOG) {
+                        backlog.push_back(due);
+                    }
+                    else if (due >= measureStart) {
+                        result.dropped++;
+                    }
+                    due = startNs + static_cast<uint64_t>(static_cast<double>(++scheduled) * interval);
+                }
+                for (size_t i = 0; i < connections.size() && !backlog.empty(); ++i) {
+                    if (!connections[i].busy) {
+                        uint64_t intended = backlog.front();
+                        backlog.pop_front();
+                        issue(i, intended);
+                    }
+                }
+                itimerspec spec{};
+                spec.it_value.tv_sec = static_cast<time_t>(due / 1000000000ull);
+                spec.it_value.tv_nsec = static_cast<long>(due % 1000000000ull);
+                timerfd_settime(timerFd, TFD_TIMER_ABSTIME, &spec, nullptr);
+            }
+            int timeout = static_cast<int>((end - now) / 1000000) + 1;
+            int count = epoll_wait(epollFd, events, MAX_EVENTS, timeout);
+            for (int e = 0; e < count; ++e) {
+                if (events[e].data.u64 == UINT64_MAX) {
+                    uint64_t expirations;
+                    while (::read(timerFd, &expirations, sizeof(expirations)) > 0) {
+                    }
+                    continue;
+                }
+                handle(static_cast<size_t>(events[e].data.u64), events[e].events);
+            }
+        }
+        result.unsent = backlog.size();
+    }
+
+    WorkerResult result; // Counters, read after the thread joined
+
+private:
+    const Options& options;
+    sockaddr_storage address;
+    socklen_t addressLength;
+    const std::vector<RequestTemplate>& requests;
+    std::vector<Connection> connections;
+    double rate;                   // This thread's share of the request rate (0 = closed loop)
+    int epollFd;
+    int timerFd;                   // Open-loop schedule timer
+    uint64_t measureStart = 0;     // Requests started before this are warmup
+    std::deque<uint64_t> backlog;  // Open loop: scheduled start times waiting for a free connection
+    char buffer[READ_BUFFER_BYTES];
+
+    bool measuring(uint64_t startNs) const { return startNs >= measureStart; }
+
+    /**
+     * @brief Registers the interest a connection needs (writable while connecting or sending).
+     */
+    void updateInterest(size_t index) {
+        Connection& connection = connections[index];
+        bool writing = connection.connecting || (connection.busy && connection.sent < requests[connection.current].bytes.size());
+        uint32_t wanted = EPOLLIN | (writing ? EPOLLOUT : 0u);
+        if (wanted == connection.events) {
+            return;
+        }
+        epoll_event event{};
+        event.events = wanted;
+        event.data.u64 = index;
+        epoll_ctl(epollFd, EPOLL_CTL_MOD, connection.fd, &event);
+        connection.events = wanted;
+    }
+
+    /**
+     * @brief Starts a non-blocking connect.
+     */
+    void openConnection(size_t index) {
+        Connection& connection = connections[index];
+        connection.fd = socket(address.ss_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (connection.fd == -1) {
+            result.errors++;
+            return;
+        }
+        int one = 1;
+        setsockopt(connection.fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        int status = connect(connection.fd, reinterpret_cast<const sockaddr*>(&address), addressLength);
+        connection.connecting = status != 0;
+        if (status != 0 && errno != EINPROGRESS) {
+            result.errors++;
+            ::close(connection.fd);
+            connection.fd = -1;
+            return;
+        }
+        result.connects++;
+        epoll_event event{};
+        event.events = EPOLLIN | EPOLLOUT;
+        event.data.u64 = index;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, connection.fd, &event);
+        connection.events = event.events;
+        if (!connection.connecting) {
+            connected(index);
+        }
+    }
+
+    void closeConnection(Connection& connection) {
+        if (connection.fd != -1) {
+            ::close(connection.fd);
+            connection.fd = -1;
+        }
+        connection.connecting = false;
+    }
+
+    /**
+     * @brief Drops a connection after an error or a close and opens a new one.
+     * @details A request in flight is lost and counted as an error.
+     */
+    void reconnect(size_t index, bool failed) {
+        Connection& connection = connections[index];
+        if (failed) {
+            result.errors++;
+            connection.busy = false;
+        }
+        closeConnection(connection);
+        openConnection(index);
+    }
+
+    /**
+     * @brief Sends the request a connection was holding or, in closed loop, starts the next one.
+     */
+    void connected(size_t index) {
+        Connection& connection = connections[index];
+        connection.connecting = false;
+        if (connection.busy) {
+            flush(index);
+        }
+        else if (rate == 0) {
+            issue(index, nowNs());
+        }
+        else if (!backlog.empty()) {
+            uint64_t intended = backlog.front();
+            backlog.pop_front();
+            issue(index, intended);
+        }
+        if (connection.fd != -1) {
+            updateInterest(index);
+        }
+    }
+
+    /**
+     * @brief Starts the connection's next scenario request.
+     * @param startNs Time the latency is measured from
+     */
+    void issue(size_t index, uint64_t startNs) {
+        Connection& connection = connections[index];
+        connection.busy = true;
+        connection.current = connection.next;
+        connection.next = (connection.next + 1) % requests.size();
+        connection.sent = 0;
+        connection.startNs = startNs;
+        connection.reader.reset(requests[connection.current].head);
+        if (connection.fd == -1) {
+            openConnection(index);
+            return;
+        }
+        if (!connection.connecting) {
+            flush(index);
+            if (connection.fd != -1) {
+                updateInterest(index);
+            }
+        }
+    }
+
+    /**
+     * @brief Writes as much of the request in flight as the socket takes.
+     */
+    void flush(size_t index) {
+        Connection& connection = connections[index];
+        const std::string& bytes = requests[connection.current].bytes;
+        while (connection.sent < bytes.size()) {
+            ssize_t written = send(connection.fd, bytes.data() + connection.sent, bytes.size() - connection.sent, MSG_NOSIGNAL);
+            if (written < 0) {
+                if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                    return;
+                }
+                reconnect(index, true);
+                return;
+            }
+            connection.sent += static_cast<size_t>(written);
+            if (measuring(connection.startNs)) {
+                result.bytesOut += static_cast<uint64_t>(written);
+            }
+        }
+    }
+
+    /**
+     * @brief Handles readiness of one connection.
+     */
+    void handle(size_t index, uint32_t ready) {
+        Connection& connection = connections[index];
+        if (connection.fd == -1) {
+            return;
+        }
+        if (connection.connecting) {
+            int error = 0;
+            socklen_t length = sizeof(error);
+            getsockopt(connection.fd, SOL_SOCKET, SO_ERROR, &error, &length);
+            if (error != 0 || (ready & (EPOLLERR | EPOLLHUP))) {
+                reconnect(index, connection.busy);
+                return;
+            }
+            if (ready & EPOLLOUT) {
+                connected(index);
+            }
+            return;
+        }
+        if ((ready & EPOLLOUT) && connection.busy) {
+            flush(index);
+            if (connection.fd == -1) {
+                return;
+            }
+        }
+        if (ready & (EPOLLIN | EPOLLERR | EPOLLHUP)) {
+            receive(index);
+        }
+        if (connection.fd != -1) {
+            updateInterest(index);
+        }
+    }
+
+    /**
+     * @brief Reads the response in flight and completes it.
+     */
+    void receive(size_t index) {
+        Connection& connection = connections[index];
+        while (connection.fd != -1) {
+            ssize_t received = recv(connection.fd, buffer, sizeof(buffer), 0);
+            if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                return;
+            }
+            if (received <= 0) {
+                // Closed by the server: expected only between requests
+                reconnect(index, connection.busy);
+                return;
+            }
+            if (!connection.busy) {
+                reconnect(index, true); // Bytes nobody asked for
+                return;
+            }
+            if (measuring(connection.startNs)) {
+                result.bytesIn += static_cast<uint64_t>(received);
+            }
+            size_t consumed = 0;
+            ReadStatus status = connection.reader.feed(buffer, static_cast<size_t>(received), consumed);
+            if (status == ReadStatus::Error || (status == ReadStatus::Complete && consumed != static_cast<size_t>(received))) {
+                reconnect(index, true);
+                return;
+            }
+            if (status == ReadStatus::Complete) {
+                complete(index);
+                return;
+            }
+        }
+    }
+
+    /**
+     * @brief Records a finished request and starts the next one on this connection.
+     */
+    void complete(size_t index) {
+        Connection& connection = connections[index];
+        uint64_t now = nowNs();
+        if (measuring(connection.startNs)) {
+            uint64_t latency = now - connection.startNs;
+            result.latency.record(latency);
+            result.perRequest[connection.current].record(latency);
+            result.statuses[connection.reader.status()]++;
+            result.completed++;
+        }
+        connection.busy = false;
+        if (connection.reader.closes() || requests[connection.current].close) {
+            // The next request's clock starts before its connection is opened
+            closeConnection(connection);
+            if (rate == 0) {
+                issue(index, now);
+            }
+            else {
+                openConnection(index);
+            }
+            return;
+        }
+        if (rate == 0) {
+            issue(index, now);
+        }
+        else if (!backlog.empty()) {
+            uint64_t intended = backlog.front();
+            backlog.pop_front();
+            issue(index, intended);
+        }
+    }
+};
+
+/**
+ * @brief Escapes a string for a JSON document.
+ */
+static std::string jsonString(const std::string& text) {
+    std::string out = "\"";
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            out.push_back('\\');
+            out.push_back(c);
+        }
+        else if (static_cast<unsigned char>(c) < 0x20) {
+            char escaped[8];
+            std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            out.append(escaped);
+        }
+        else {
+            out.push_back(c);
+        }
+    }
+    return out + "\"";
+}
+
+/**
+ * @brief Formats a latency in microseconds with one decimal.
+ */
+static std::string micros(uint64_t nanos) {
+    char text[32];
+    std::snprintf(text, sizeof(text), "%.1f", static_cast<double>(nanos) / 1000.0);
+    return text;
+}
+
+/**
+ * @brief Writes the machine-readable results.
+ * @return False if the file could not be written
+ */
+static bool writeJson(const Options& options, const std::string& scenario, const std::vector<RequestTemplate>& requests,
+    const WorkerResult& total) {
+    std::ofstream out(options.jsonPath);
+    if (!out) {
+        return false;
+    }
+    out << "{\n";
+    out << "  \"label\": " << jsonString(options.label) << ",\n";
+    out << "  \"scenario\": " << jsonString(scenario) << ",\n";
+    out << "  \"mode\": " << jsonString(options.rate > 0 ? "open" : "closed") << ",\n";
+    out << "  \"target_rate\": " << options.rate << ",\n";
+    out << "  \"threads\": " << options.threads << ",\n";
+    out << "  \"connections\": " << options.connections << ",\n";
+    out << "  \"duration_s\": " << options.duration << ",\n";
+    out << "  \"warmup_s\": " << options.warmup << ",\n";
+    out << "  \"requests\": " << total.completed << ",\n";
+    out << "  \"throughput_rps\": " << static_cast<double>(total.completed) / options.duration << ",\n";
+    out << "  \"errors\": " << total.errors << ",\n";
+    out << "  \"connects\": " << total.connects << ",\n";
+    out << "  \"dropped\": " << total.dropped << ",\n";
+    out << "  \"unsent\": " << total.unsent << ",\n";
+    out << "  \"bytes_in\": " << total.bytesIn << ",\n";
+    out << "  \"bytes_out\": " << total.bytesOut << ",\n";
+    out << "  \"latency_us\": {\"mean\": " << total.latency.mean() / 1000.0;
+    for (double q : QUANTILES) {
+        out << ", \"p" << q * 100 << "\": " << micros(total.latency.percentile(q));
+    }
+    out << ", \"max\": " << micros(total.latency.max()) << "},\n";
+    out << "  \"statuses\": {";
+    bool first = true;
+    for (const auto& status : total.statuses) {
+        out << (first ? "" : ", ") << "\"" << status.first << "\": " << status.second;
+        first = false;
+    }
+    out << "},\n  \"per_request\": [";
+    for (size_t i = 0; i < requests.size(); ++i) {
+        const Histogram& latency = total.perRequest[i];
+        out << (i == 0 ? "\n" : ",\n") << "    {\"name\": " << jsonString(requests[i].name) << ", \"count\": " << latency.count()
+            << ", \"p50_us\": " << micros(latency.percentile(0.5)) << ", \"p99_us\": " << micros(latency.percentile(0.99)) << "}";
+    }
+    out << "\n  ]\n}\n";
+    return out.good();
+}
+
+/**
+ * @brief Prints the human-readable summary.
+ */
+static void printReport(const Options& options, const std::string& scenario, const std::vector<RequestTemplate>& requests,
+    const WorkerResult& total) {
+    std::printf("scenario %s (%zu requests), %u threads, %u connections, %s, %.1f s measured after %.1f s warmup\n",
+        scenario.c_str(), requests.size(), options.threads, options.connections,
+        options.rate > 0 ? ("open loop at " + std::to_string(static_cast<long long>(options.rate)) + " req/s").c_str() : "closed loop",
+        options.duration, options.warmup);
+    std::printf("requests   %llu (%.1f req/s), errors %llu, connects %llu\n", static_cast<unsigned long long>(total.completed),
+        static_cast<double>(total.completed) / options.duration, static_cast<unsigned long long>(total.errors),
+        static_cast<unsigned long long>(total.connects));
+    if (options.rate > 0) {
+        std::printf("open loop  dropped %llu, unsent at end %llu\n", static_cast<unsigned long long>(total.dropped),
+            static_cast<unsigned long long>(total.unsent));
+    }
+    std::printf("transfer   in %.2f MB/s, out %.2f MB/s\n", static_cast<double>(total.bytesIn) / options.duration / 1e6,
+        static_cast<double>(total.bytesOut) / options.duration / 1e6);
+    std::printf("latency us mean %.1f  p50 %s  p90 %s  p99 %s  p99.9 %s  max %s\n", total.latency.mean() / 1000.0,
+        micros(total.latency.percentile(0.5)).c_str(), micros(total.latency.percentile(0.9)).c_str(),
+        micros(total.latency.percentile(0.99)).c_str(), micros(total.latency.percentile(0.999)).c_str(),
+        micros(total.latency.max()).c_str());
+    std::printf("statuses  ");
+    for (const auto& status : total.statuses) {
+        std::printf(" %d: %llu", status.first, static_cast<unsigned long long>(status.second));
+    }
+    std::printf("\n");
+    if (requests.size() > 1) {
+        for (size_t i = 0; i < requests.size(); ++i) {
+            const Histogram& latency = total.perRequest[i];
+            std::printf("  %-40s %10llu  p50 %10s  p99 %10s\n", requests[i].name.c_str(), static_cast<unsigned long long>(latency.count()),
+                micros(latency.percentile(0.5)).c_str(), micros(latency.percentile(0.99)).c_str());
+        }
+    }
+}
+
+/**
+ * @brief Prints the usage text.
+ */
+static void usage() {
+    std::fprintf(stderr,
+        "usage: web-bench [--host H] [--port P] [--threads T] [--connections C] [--duration S] [--warmup S]\n"
+        "                 [--rate R] [--scenario NAME | --collection FILE] [--close] [--json FILE] [--label TEXT]\n"
+        "  --rate R        open loop at R requests/s over all threads (latency from the scheduled time);\n"
+        "                  without it every connection sends its next request when the previous one completes\n"
+        "  --scenario      built-in scenario: %s\n"
+        "  --collection    replay every request of a Postman collection (e.g. pm.tests.json) in order\n"
+        "  --close         send Connection: close on every request (a new connection per request)\n",
+        builtinScenarioNames());
+}
+
+/**
+ * @brief Entry point: parses options, runs the threads and reports.
+ */
+int main(int argc, char* argv[]) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--host" && hasValue) options.host = argv[++i];
+        else if (arg == "--port" && hasValue) options.port = std::atoi(argv[++i]);
+        else if (arg == "--threads" && hasValue) options.threads = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        else if (arg == "--connections" && hasValue) options.connections = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        else if (arg == "--duration" && hasValue) options.duration = std::atof(argv[++i]);
+        else if (arg == "--warmup" && hasValue) options.warmup = std::atof(argv[++i]);
+        else if (arg == "--rate" && hasValue) options.rate = std::atof(argv[++i]);
+        else if (arg == "--scenario" && hasValue) options.scenario = argv[++i];
+        else if (arg == "--collection" && hasValue) options.collection = argv[++i];
+        else if (arg == "--close") options.close = true;
+        else if (arg == "--json" && hasValue) options.jsonPath = argv[++i];
+        else if (arg == "--label" && hasValue) options.label = argv[++i];
+        else {
+            usage();
+            return 2;
+        }
+    }
+    options.threads = options.threads == 0 ? 1 : options.threads;
+    options.connections = options.connections < options.threads ? options.threads : options.connections;
+    if (options.duration <= 0) {
+        usage();
+        return 2;
+    }
+
+    std::string hostHeader = options.host + ":" + std::to_string(options.port);
+    std::vector<RequestTemplate> requests;
+    std::string scenario = options.collection.empty() ? options.scenario : options.collection;
+    std::string error;
+    if (!options.collection.empty()) {
+        if (!loadCollection(options.collection, hostHeader, options.close, requests, error)) {
+            std::fprintf(stderr, "web-bench: %s\n", error.c_str());
+            return 1;
+        }
+    }
+    else if (!builtinScenario(options.scenario, hostHeader, options.close, requests)) {
+        std::fprintf(stderr, "web-bench: unknown scenario '%s' (%s)\n", options.scenario.c_str(), builtinScenarioNames());
+        return 1;
+    }
+
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* resolved = nullptr;
+    if (getaddrinfo(options.host.c_str(), std::to_string(options.port).c_str(), &hints, &resolved) != 0 || resolved == nullptr) {
+        std::fprintf(stderr, "web-bench: cannot resolve %s\n", options.host.c_str());
+        return 1;
+    }
+    sockaddr_storage address{};
+    std::memcpy(&address, resolved->ai_addr, resolved->ai_addrlen);
+    socklen_t addressLength = static_cast<socklen_t>(resolved->ai_addrlen);
+    freeaddrinfo(resolved);
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    for (unsigned t = 0; t < options.threads; ++t) {
+        unsigned share = options.connections / options.threads + (t < options.connections % options.threads ? 1 : 0);
+        workers.push_back(std::make_unique<Worker>(options, address, addressLength, requests, share, options.rate / options.threads));
+    }
+    uint64_t start = nowNs();
+    std::vector<std::thread> threads;
+    for (auto& worker : workers) {
+        threads.emplace_back([&worker, start]() { worker->run(start); });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    WorkerResult total;
+    for (auto& worker : workers) {
+        total.merge(worker->result);
+    }
+    printReport(options, scenario, requests, total);
+    if (!options.jsonPath.empty() && !writeJson(options, scenario, requests, total)) {
+        std::fprintf(stderr, "web-bench: cannot write %s\n", options.jsonPath.c_str());
+        return 1;
+    }
+    return total.completed > 0 ? 0 : 1;
+}
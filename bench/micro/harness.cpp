@@ -0,0 +1,140 @@
+#include "harness.h"
+#include <chrono>
+#include <algorithm>
+#include <fstream>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <utility>
+
+static thread_local uint64_t allocations = 0; // operator new calls on this thread
+static thread_local uint64_t bytes = 0;       // Bytes requested on this thread
+
+/**
+ * @brief Counts one allocation and forwards it to malloc.
+ */
+static void* countedAllocate(size_t size) {
+    allocations++;
+    bytes += size;
+    void* memory = std::malloc(size == 0 ? 1 : size);
+    if (memory == nullptr) {
+        throw std::bad_alloc();
+    }
+    return memory;
+}
+
+void* operator new(size_t size) { return countedAllocate(size); }
+void* operator new[](size_t size) { return countedAllocate(size); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    allocations++;
+    bytes += size;
+    return std::malloc(size == 0 ? 1 : size);
+}
+void* operator new[](size_t size, const std::nothrow_t& tag) noexcept { return operator new(size, tag); }
+void operator delete(void* memory) noexcept { std::free(memory); }
+void operator delete[](void* memory) noexcept { std::free(memory); }
+void operator delete(void* memory, size_t) noexcept { std::free(memory); }
+void operator delete[](void* memory, size_t) noexcept { std::free(memory); }
+void operator delete(void* memory, const std::nothrow_t&) noexcept { std::free(memory); }
+void operator delete[](void* memory, const std::nothrow_t&) noexcept { std::free(memory); }
+
+/**
+ * @brief Returns the heap allocations made by the calling thread so far.
+ */
+uint64_t allocationCount() {
+    return allocations;
+}
+
+/**
+ * @brief Returns the heap bytes requested by the calling thread so far.
+ */
+uint64_t allocatedBytes() {
+    return bytes;
+}
+
+/**
+ * @brief Creates a runner.
+ * @param filter Only benchmarks whose name contains this substring run (empty = all)
+ * @param minSeconds Minimum duration of one timed repetition
+ */
+BenchRunner::BenchRunner(std::string filter, double minSeconds)
+    : filter(std::move(filter)), minSeconds(minSeconds) {
+}
+
+/**
+ * @brief Calibrates, times and records one benchmark.
+ * @param name Benchmark name
+ * @param body One operation
+ */
+void BenchRunner::run(const std::string& name, const std::function<void()>& body) {
+    if (!filter.empty() && name.find(filter) == std::string::npos) {
+        return;
+    }
+    using Clock = std::chrono::steady_clock;
+    // Calibrate: grow the batch until it lasts a tenth of the minimum time
+    uint64_t batch = 1;
+    while (true) {
+        auto start = Clock::now();
+        for (uint64_t i = 0; i < batch; ++i) {
+            body();
+        }
+        double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        if (seconds >= minSeconds / 10 || batch >= (1ull << 40)) {
+            double scale = seconds > 0 ? minSeconds / seconds : 10;
+            batch = static_cast<uint64_t>(static_cast<double>(batch) * (scale < 1 ? 1 : scale)) + 1;
+            break;
+        }
+        batch *= 10;
+    }
+
+    BenchResult result;
+    result.name = name;
+    result.operations = batch;
+    std::vector<double> samples;
+    uint64_t allocationsBefore = allocationCount();
+    uint64_t bytesBefore = allocatedBytes();
+    for (int repetition = 0; repetition < REPETITIONS; ++repetition) {
+        auto start = Clock::now();
+        for (uint64_t i = 0; i < batch; ++i) {
+            body();
+        }
+        samples.push_back(std::chrono::duration<double, std::nano>(Clock::now() - start).count() / static_cast<double>(batch));
+    }
+    double operations = static_cast<double>(batch) * REPETITIONS;
+    result.allocsPerOp = static_cast<double>(allocationCount() - allocationsBefore) / operations;
+    result.bytesPerOp = static_cast<double>(allocatedBytes() - bytesBefore) / operations;
+    std::sort(samples.begin(), samples.end());
+    result.nsPerOp = samples[samples.size() / 2];
+    std::printf("%-44s %12.1f ns/op %8.2f allocs/op %10.1f B/op\n", name.c_str(), result.nsPerOp, result.allocsPerOp, result.bytesPerOp);
+    std::fflush(stdout);
+    gathered.push_back(result);
+}
+
+/**
+ * @brief Writes the results as JSON.
+ * @param path Output file
+ * @param label Free-form build label copied into the file
+ * @return False if the file could not be written
+ */
+bool BenchRunner::writeJson(const std::string& path, const std::string& label) const {
+    std::ofstream out(path);
+    if (!out) {
+        return false;
+    }
+    out << "{\n  \"label\": \"";
+    for (char c : label) {
+        if (c == '"' || c == '\\') {
+            out << '\\';
+        }
+        out << (static_cast<unsigned char>(c) < 0x20 ? ' ' : c);
+    }
+    out << "\",\n  \"benchmarks\": [";
+    for (size_t i = 0; i < gathered.size(); ++i) {
+        const BenchResult& result = gathered[i];
+        out << (i == 0 ? "\n" : ",\n") << "    {\"name\": \"" << result.name << "\", \"ns_per_op\": " << result.nsPerOp
+            << ", \"allocs_per_op\": " << result.allocsPerOp << ", \"bytes_per_op\": " << result.bytesPerOp
+            << ", \"operations\": " << result.operations << "}";
+    }
+    out << "\n  ]\n}\n";
+    return out.good();
+}
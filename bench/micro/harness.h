@@ -0,0 +1,60 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <functional>
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * @brief Result of one microbenchmark.
+ */
+struct BenchResult {
+    std::string name;        // Benchmark name ("parse/browser-get")
+    double nsPerOp = 0;      // Median time per operation over the repetitions
+    double allocsPerOp = 0;  // Heap allocations per operation (operator new calls)
+    double bytesPerOp = 0;   // Heap bytes requested per operation
+    uint64_t operations = 0; // Operations timed per repetition
+};
+
+/**
+ * @brief Runs microbenchmarks and collects their results.
+ * @details Each benchmark body performs one operation per call. The harness calibrates the
+ *          number of calls so a repetition lasts at least the minimum time, times REPETITIONS
+ *          repetitions and keeps the median. Allocations are counted by replacement global
+ *          operator new/delete (see harness.cpp) over the same calls.
+ */
+class BenchRunner {
+public:
+    static constexpr int REPETITIONS = 5; // Timed repetitions per benchmark
+
+    // Creates a runner that skips benchmarks whose name does not contain filter
+    BenchRunner(std::string filter, double minSeconds);
+
+    // Times body unless the filter excludes name
+    void run(const std::string& name, const std::function<void()>& body);
+    // Returns the results gathered so far
+    const std::vector<BenchResult>& results() const { return gathered; }
+    // Writes the results as JSON; returns false if the file could not be written
+    bool writeJson(const std::string& path, const std::string& label) const;
+
+private:
+    std::string filter;               // Substring a benchmark name must contain
+    double minSeconds;                // Minimum duration of one repetition
+    std::vector<BenchResult> gathered; // Results in run order
+};
+
+// Returns the heap allocations made by the calling thread so far
+uint64_t allocationCount();
+// Returns the heap bytes requested by the calling thread so far
+uint64_t allocatedBytes();
+
+// Keeps the compiler from discarding a computed value
+template <typename T>
+inline void doNotOptimize(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    const volatile char* sink = reinterpret_cast<const volatile char*>(&value);
+    (void)*sink;
+#endif
+}
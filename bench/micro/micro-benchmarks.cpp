@@ -0,0 +1,323 @@
+#include "harness.h"
+#include "../scenario.h"
+#include "../../request-parser.h"
+#include "../../response.h"
+#include "../../http-utils.h"
+#include "../../content-cache.h"
+#include "../../utils.h"
+#include "../../access-log.h"
+#include "../../metrics.h"
+#include "../../platform.h"
+#include <string>
+#include <vector>
+#include <fstream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+static const std::string HOST = "127.0.0.1:8080";                  // Host header of the built-in corpus
+static const char* FIXTURE_NAMES[] = { "microbench.html", "microbench.fr.html", "microbench-notes.txt" }; // Files created in CONTENT_DIR
+
+/**
+ * @brief A raw request used as parser input.
+ */
+struct CorpusEntry {
+    std::string name;  // Benchmark suffix
+    std::string bytes; // Request as received
+};
+
+/**
+ * @brief Builds the built-in request corpus: what curl, a browser and the Postman tests send.
+ */
+static std::vector<CorpusEntry> builtinCorpus() {
+    std::vector<CorpusEntry> corpus;
+    corpus.push_back({ "curl-get", makeRequest("GET", "/", { { "User-Agent", "curl/8.5.0" }, { "Accept", "*/*" } }, "", HOST, false).bytes });
+    corpus.push_back({ "browser-get", makeRequest("GET", "/index.html?lang=fr", {
+        { "User-Agent", "Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/124.0.0.0 Safari/537.36" },
+        { "Accept", "text/html,application/xhtml+xml,application/xml;q=0.9,image/avif,image/webp,*/*;q=0.8" },
+        { "Accept-Language", "fr-FR,fr;q=0.9,en-US;q=0.8,en;q=0.7" },
+        { "Accept-Encoding", "gzip, deflate, br, zstd" },
+        { "Cache-Control", "max-age=0" },
+        { "Sec-Ch-Ua", "\"Chromium\";v=\"124\", \"Google Chrome\";v=\"124\", \"Not-A.Brand\";v=\"99\"" },
+        { "Sec-Ch-Ua-Mobile", "?0" },
+        { "Sec-Ch-Ua-Platform", "\"Linux\"" },
+        { "Sec-Fetch-Dest", "document" },
+        { "Sec-Fetch-Mode", "navigate" },
+        { "Sec-Fetch-Site", "none" },
+        { "Sec-Fetch-User", "?1" },
+        { "Upgrade-Insecure-Requests", "1" },
+        { "If-None-Match", "\"18f2a3c4d5e6f7a8-1c4-gzip\"" },
+        { "Cookie", "session=6f1c2e9b4a7d3f80; theme=dark; consent=1" } }, "", HOST, false).bytes });
+    corpus.push_back({ "put-1k", makeRequest("PUT", "/notes.txt", { { "Content-Type", "text/plain" } }, std::string(1024, 'p'), HOST, false).bytes });
+    corpus.push_back({ "post-16k", makeRequest("POST", "/echo", { { "Content-Type", "text/plain" } }, std::string(16 * 1024, 'e'), HOST, false).bytes });
+    std::string chunked = "POST /echo HTTP/1.1\r\nHost: " + HOST + "\r\nContent-Type: text/plain\r\nTransfer-Encoding: chunked\r\n\r\n";
+    for (int i = 0; i < 8; ++i) {
+        chunked += "200\r\n" + std::string(512, 'c') + "\r\n";
+    }
+    chunked += "0\r\n\r\n";
+    corpus.push_back({ "post-chunked-4k", chunked });
+    return corpus;
+}
+
+/**
+ * @brief Parses one whole message the way Server::receiveMessage() does and builds its Request.
+ * @param scratch Writable copy target, used when parsing decodes the message in place
+ */
+static void parseOnce(const std::string& bytes, std::string& scratch, bool inPlace) {
+    RequestParser parser;
+    char* data = const_cast<char*>(bytes.data());
+    if (inPlace) {
+        std::memcpy(&scratch[0], bytes.data(), bytes.size()); // Chunked bodies are decoded over their framing
+        data = &scratch[0];
+    }
+    ParseStatus status = parser.parse(data, bytes.size());
+    Request request;
+    parser.request(std::string_view(data, bytes.size()), request);
+    doNotOptimize(status);
+    doNotOptimize(request);
+}
+
+/**
+ * @brief RequestParser: whole messages and messages arriving in pieces.
+ */
+static void benchParser(BenchRunner& runner, const std::vector<CorpusEntry>& corpus, const std::vector<RequestTemplate>& collection) {
+    std::string scratch(64 * 1024, '\0');
+    for (const CorpusEntry& entry : corpus) {
+        bool inPlace = entry.bytes.find("chunked") != std::string::npos;
+        runner.run("parse/" + entry.name, [&]() { parseOnce(entry.bytes, scratch, inPlace); });
+    }
+    if (!collection.empty()) {
+        // One operation = one request of the collection, in order
+        size_t next = 0;
+        runner.run("parse/collection", [&]() {
+            const std::string& bytes = collection[next].bytes;
+            next = (next + 1) % collection.size();
+            parseOnce(bytes, scratch, true);
+        });
+    }
+    // Completion detection as the buffer grows by one recv() at a time
+    for (size_t step : { size_t(1), size_t(64), size_t(1460) }) {
+        for (const CorpusEntry& entry : corpus) {
+            if (entry.name != "browser-get" && entry.name != "post-16k") {
+                continue;
+            }
+            runner.run("parse-incremental/" + entry.name + "/step-" + std::to_string(step), [&]() {
+                std::memcpy(&scratch[0], entry.bytes.data(), entry.bytes.size());
+                RequestParser parser;
+                ParseStatus status = ParseStatus::Incomplete;
+                for (size_t size = step; status == ParseStatus::Incomplete; size += step) {
+                    status = parser.parse(&scratch[0], size < entry.bytes.size() ? size : entry.bytes.size());
+                }
+                doNotOptimize(status);
+            });
+        }
+    }
+}
+
+/**
+ * @brief Request::getQparams on a typical query string.
+ */
+static void benchQuery(BenchRunner& runner) {
+    std::string bytes = makeRequest("GET", "/search?q=hello+world&lang=fr&page=2&sort=asc&filter=recent", {}, "", HOST, false).bytes;
+    RequestParser parser;
+    parser.parse(&bytes[0], bytes.size());
+    Request request;
+    parser.request(bytes, request);
+    runner.run("getQparams/first", [&]() { doNotOptimize(request.getQparams("q")); });
+    runner.run("getQparams/last", [&]() { doNotOptimize(request.getQparams("filter")); });
+    runner.run("getQparams/absent", [&]() { doNotOptimize(request.getQparams("missing")); });
+}
+
+/**
+ * @brief Response::toString and Response::serializeHead over header counts and body sizes.
+ */
+static void benchResponse(BenchRunner& runner) {
+    for (size_t headerCount : { size_t(2), size_t(8), size_t(16) }) {
+        for (size_t bodySize : { size_t(0), size_t(1024), size_t(64 * 1024) }) {
+            Response response = Response::ok(std::string(bodySize, 'b'));
+            response.headers["Content-Type"] = "text/html";
+            for (size_t i = 1; i < headerCount; ++i) {
+                response.headers["X-Bench-Header-" + std::to_string(i)] = "value-" + std::to_string(i);
+            }
+            std::string suffix = std::to_string(headerCount) + "-headers/" + std::to_string(bodySize) + "-bytes";
+            runner.run("toString/" + suffix, [&]() { doNotOptimize(response.toString()); });
+            if (bodySize == 0) {
+                // The server path: the head is appended to a reused buffer and the body sent separately
+                std::string out;
+                out.reserve(4096);
+                runner.run("serializeHead/" + std::to_string(headerCount) + "-headers", [&]() {
+                    out.clear();
+                    response.serializeHead(out);
+                    doNotOptimize(out);
+                });
+            }
+        }
+    }
+}
+
+/**
+ * @brief Creates the files resolveFilePath() finds in CONTENT_DIR.
+ * @return False if CONTENT_DIR is not writable
+ */
+static bool createFixtures() {
+    for (const char* name : FIXTURE_NAMES) {
+        std::ofstream file(std::string(CONTENT_DIR) + name, std::ios::binary);
+        file << "<html><body>microbenchmark fixture " << name << "</body></html>\n";
+        if (!file) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Removes the fixture files.
+ */
+static void removeFixtures() {
+    for (const char* name : FIXTURE_NAMES) {
+        std::remove((std::string(CONTENT_DIR) + name).c_str());
+    }
+}
+
+/**
+ * @brief resolveFilePath() probing the disk (cold) against a content cache hit (warm).
+ */
+static void benchResolve(BenchRunner& runner) {
+    if (!createFixtures()) {
+        std::fprintf(stderr, "micro-benchmarks: cannot write fixtures to %s, skipping resolve\n", CONTENT_DIR);
+        return;
+    }
+    struct Case {
+        const char* name;
+        const char* path;
+        const char* lang;
+    };
+    const Case cases[] = {
+        { "lang-hit", "/microbench", "fr" },      // First probe succeeds
+        { "txt-fallback", "/microbench-notes", "de" }, // Falls through every .html probe
+        { "missing", "/microbench-none", "" },     // Every probe fails
+        { "invalid", "/../etc/passwd", "" },       // Rejected before probing
+    };
+    for (const Case& c : cases) {
+        std::string path = c.path;
+        std::string lang = c.lang;
+        runner.run(std::string("resolve/cold/") + c.name, [&]() { doNotOptimize(resolveFilePath(path, lang)); });
+    }
+    ContentCache cache(64 * 1024 * 1024, 1024 * 1024);
+    for (const Case& c : cases) {
+        runner.run(std::string("resolve/cache-miss/") + c.name, [&]() {
+            cache.clear();
+            doNotOptimize(cache.lookup(c.path, c.lang));
+        });
+        runner.run(std::string("resolve/warm/") + c.name, [&]() { doNotOptimize(cache.lookup(c.path, c.lang)); });
+    }
+    removeFixtures();
+}
+
+/**
+ * @brief trim() and isValidPutPath() on typical and worst-case inputs.
+ */
+static void benchStrings(BenchRunner& runner) {
+    const std::string padded = "   text/plain; charset=utf-8 \t";
+    const std::string clean = "text/plain";
+    const std::string blank(64, ' ');
+    const std::string longValue(256, 'v');
+    runner.run("trim/padded", [&]() { doNotOptimize(trim(padded)); });
+    runner.run("trim/clean", [&]() { doNotOptimize(trim(clean)); });
+    runner.run("trim/blank", [&]() { doNotOptimize(trim(blank)); });
+    runner.run("trim/long", [&]() { doNotOptimize(trim(longValue)); });
+
+    std::string baseName, extension;
+    const std::string paths[][2] = {
+        { "notes", "/notes.txt" },
+        { "no-extension", "/index" },
+        { "traversal", "/../etc/passwd" },
+        { "long", "/" + std::string(200, 'n') + ".html" },
+    };
+    for (const auto& path : paths) {
+        runner.run("isValidPutPath/" + path[0], [&]() { doNotOptimize(isValidPutPath(path[1], baseName, extension)); });
+    }
+}
+
+/**
+ * @brief The per-request cost of the access log: one phase stamp and one record in each format.
+ * @details Records go to log/microbench/ through the Logger like a reactor's would.
+ */
+static void benchAccessLog(BenchRunner& runner) {
+    setLogSink("microbench");
+    const std::string clientAddr = "127.0.0.1:54321";
+    AccessRecord entry;
+    entry.firstByteUs = 1000;
+    entry.headersUs = 1003;
+    entry.bodyUs = 1003;
+    entry.dispatchUs = 1004;
+    entry.handledUs = 1015;
+    entry.firstSentUs = 1016;
+    entry.lastSentUs = 1020;
+    entry.bytes = 5321;
+    entry.target = "/microbench.html?lang=fr";
+    entry.method = Method::Get;
+    entry.status = 200;
+    runner.run("access-log/stamp", [&]() { doNotOptimize(metricsClockUs()); });
+    AccessLog::setFormat(AccessLogFormat::Text);
+    runner.run("access-log/text", [&]() { AccessLog::record(clientAddr, entry); });
+    AccessLog::flush();
+    AccessLog::setFormat(AccessLogFormat::Binary);
+    runner.run("access-log/binary", [&]() { AccessLog::record(clientAddr, entry); });
+    AccessLog::flush();
+    AccessLog::setFormat(AccessLogFormat::Text);
+    setLogSink("");
+}
+
+/**
+ * @brief Prints the usage text.
+ */
+static void usage() {
+    std::fprintf(stderr,
+        "usage: web-micro [--filter TEXT] [--min-time S] [--collection FILE] [--json FILE] [--label TEXT]\n"
+        "  --filter      run only benchmarks whose name contains TEXT (e.g. parse/, resolve/warm, access-log/)\n"
+        "  --min-time    seconds per timed repetition (default 0.2)\n"
+        "  --collection  Postman collection replayed as parser input (default pm.tests.json)\n");
+}
+
+/**
+ * @brief Entry point: runs every benchmark matching the filter.
+ */
+int main(int argc, char* argv[]) {
+    std::string filter, jsonPath, label, collectionPath = "pm.tests.json";
+    double minSeconds = 0.2;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--filter" && hasValue) filter = argv[++i];
+        else if (arg == "--min-time" && hasValue) minSeconds = std::atof(argv[++i]);
+        else if (arg == "--collection" && hasValue) collectionPath = argv[++i];
+        else if (arg == "--json" && hasValue) jsonPath = argv[++i];
+        else if (arg == "--label" && hasValue) label = argv[++i];
+        else {
+            usage();
+            return 2;
+        }
+    }
+
+    std::vector<RequestTemplate> collection;
+    std::string error;
+    if (!loadCollection(collectionPath, HOST, false, collection, error)) {
+        std::fprintf(stderr, "micro-benchmarks: %s; parse/collection skipped\n", error.c_str());
+        collection.clear();
+    }
+
+    BenchRunner runner(filter, minSeconds);
+    benchParser(runner, builtinCorpus(), collection);
+    benchQuery(runner);
+    benchResponse(runner);
+    benchResolve(runner);
+    benchStrings(runner);
+    benchAccessLog(runner);
+
+    if (!jsonPath.empty() && !runner.writeJson(jsonPath, label)) {
+        std::fprintf(stderr, "micro-benchmarks: cannot write %s\n", jsonPath.c_str());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,207 @@
+#include "response-reader.h"
+#include <cctype>
+#include <cstring>
+
+static constexpr size_t MAX_HEAD_BYTES = 64 * 1024; // Larger heads are treated as errors
+
+/**
+ * @brief Compares the start of a header line with a lower-case name followed by ':'.
+ */
+static bool headerIs(const std::string& head, size_t start, size_t end, const char* name) {
+    size_t length = std::strlen(name);
+    if (end - start <= length || head[start + length] != ':') {
+        return false;
+    }
+    for (size_t i = 0; i < length; ++i) {
+        if (std::tolower(static_cast<unsigned char>(head[start + i])) != name[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Returns true if a header value contains a token, ignoring case.
+ */
+static bool valueHas(const std::string& head, size_t start, size_t end, const char* token) {
+    std::string value;
+    for (size_t i = start; i < end; ++i) {
+        value.push_back(static_cast<char>(std::tolower(static_cast<unsigned char>(head[i]))));
+    }
+    return value.find(token) != std::string::npos;
+}
+
+/**
+ * @brief Starts reading a new response.
+ * @param bodiless True for responses to HEAD, which have no body whatever their headers say
+ */
+void ResponseReader::reset(bool bodiless) {
+    state = State::Head;
+    line.clear();
+    remaining = 0;
+    statusCode = 0;
+    closeAfter = false;
+    chunked = false;
+    noBody = bodiless;
+}
+
+/**
+ * @brief Reads the status code and framing headers of the head held in line.
+ * @return False if the status line is malformed
+ */
+bool ResponseReader::parseHead() {
+    if (line.compare(0, 7, "HTTP/1.") != 0 || line.size() < 12 || !std::isdigit(static_cast<unsigned char>(line[9]))) {
+        return false;
+    }
+    statusCode = (line[9] - '0') * 100 + (line[10] - '0') * 10 + (line[11] - '0');
+    bool http10 = line[7] == '0';
+    bool keepAlive = false;
+    uint64_t length = 0;
+    bool hasLength = false;
+    size_t start = line.find("\r\n") + 2;
+    while (start < line.size()) {
+        size_t end = line.find("\r\n", start);
+        if (end == std::string::npos || end == start) {
+            break;
+        }
+        size_t value = line.find(':', start) + 1;
+        while (value < end && (line[value] == ' ' || line[value] == '\t')) {
+            ++value;
+        }
+        if (headerIs(line, start, end, "content-length")) {
+            hasLength = true;
+            length = 0;
+            for (size_t i = value; i < end && std::isdigit(static_cast<unsigned char>(line[i])); ++i) {
+                length = length * 10 + static_cast<uint64_t>(line[i] - '0');
+            }
+        }
+        else if (headerIs(line, start, end, "transfer-encoding")) {
+            chunked = valueHas(line, value, end, "chunked");
+        }
+        else if (headerIs(line, start, end, "connection")) {
+            closeAfter = valueHas(line, value, end, "close");
+            keepAlive = valueHas(line, value, end, "keep-alive");
+        }
+        start = end + 2;
+    }
+    closeAfter = closeAfter || (http10 && !keepAlive);
+    bool bodiless = noBody || statusCode == 204 || statusCode == 304 || statusCode / 100 == 1;
+    if (bodiless) {
+        state = State::Done;
+    }
+    else if (chunked) {
+        state = State::ChunkSize;
+    }
+    else if (hasLength) {
+        remaining = length;
+        state = length == 0 ? State::Done : State::Body;
+    }
+    else {
+        // Delimited by the connection closing; not produced by the server under test
+        return false;
+    }
+    line.clear();
+    return true;
+}
+
+/**
+ * @brief Consumes response bytes.
+ * @param data Received bytes
+ * @param length Number of bytes
+ * @param consumed Receives the bytes that belong to the current response
+ * @return Complete once the response ended, Error on a framing problem, Incomplete otherwise
+ */
+ReadStatus ResponseReader::feed(const char* data, size_t length, size_t& consumed) {
+    size_t pos = 0;
+    while (state != State::Done) {
+        if (pos == length) {
+            consumed = pos;
+            return ReadStatus::Incomplete;
+        }
+        switch (state) {
+            case State::Head: {
+                // Copy up to the end of the head (searching across read boundaries)
+                size_t before = line.size();
+                line.append(data + pos, length - pos);
+                size_t end = line.find("\r\n\r\n", before >= 3 ? before - 3 : 0);
+                if (end == std::string::npos) {
+                    if (line.size() > MAX_HEAD_BYTES) {
+                        return ReadStatus::Error;
+                    }
+                    pos = length;
+                    break;
+                }
+                pos += end + 4 - before;
+                line.resize(end + 4);
+                if (!parseHead()) {
+                    return ReadStatus::Error;
+                }
+                break;
+            }
+            case State::Body: {
+                size_t take = static_cast<size_t>(remaining < length - pos ? remaining : length - pos);
+                pos += take;
+                remaining -= take;
+                if (remaining == 0) {
+                    state = State::Done;
+                }
+                break;
+            }
+            case State::ChunkSize:
+            case State::Trailer: {
+                char c = data[pos++];
+                line.push_back(c);
+                if (c != '\n') {
+                    if (line.size() > 1024) {
+                        return ReadStatus::Error;
+                    }
+                    break;
+                }
+                if (state == State::Trailer) {
+                    // Trailer fields end with an empty line
+                    state = line == "\r\n" ? State::Done : State::Trailer;
+                    line.clear();
+                    break;
+                }
+                uint64_t size = 0;
+                size_t digits = 0;
+                for (char h : line) {
+                    int value = std::isdigit(static_cast<unsigned char>(h)) ? h - '0'
+                        : (h >= 'a' && h <= 'f') ? h - 'a' + 10 : (h >= 'A' && h <= 'F') ? h - 'A' + 10 : -1;
+                    if (value < 0) {
+                        break;
+                    }
+                    size = size * 16 + static_cast<uint64_t>(value);
+                    ++digits;
+                }
+                line.clear();
+                if (digits == 0) {
+                    return ReadStatus::Error;
+                }
+                remaining = size;
+                state = size == 0 ? State::Trailer : State::ChunkData;
+                break;
+            }
+            case State::ChunkData: {
+                size_t take = static_cast<size_t>(remaining < length - pos ? remaining : length - pos);
+                pos += take;
+                remaining -= take;
+                if (remaining == 0) {
+                    remaining = 2;
+                    state = State::ChunkEnd;
+                }
+                break;
+            }
+            case State::ChunkEnd:
+                ++pos;
+                if (--remaining == 0) {
+                    state = State::ChunkSize;
+                }
+                break;
+            default:
+                break;
+        }
+    }
+    consumed = pos;
+    return ReadStatus::Complete;
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * @brief Outcome of feeding bytes to a ResponseReader.
+ */
+enum class ReadStatus {
+    Incomplete, // More bytes are needed
+    Complete,   // One response ended; the rest of the input belongs to the next one
+    Error       // The bytes are not a valid HTTP/1.x response
+};
+
+/**
+ * @brief Incremental HTTP/1.x response framer for the load generator.
+ * @details Only what is needed to find the end of a response is decoded: the status code,
+ *          Content-Length, chunked transfer coding and Connection: close. Bodies are skipped
+ *          without being copied.
+ */
+class ResponseReader {
+public:
+    // Starts reading a new response; bodiless is true for responses to HEAD
+    void reset(bool bodiless);
+    // Consumes bytes from data; consumed receives how many belong to the current response
+    ReadStatus feed(const char* data, size_t length, size_t& consumed);
+    // Returns the status code of the response (0 until the status line was read)
+    int status() const { return statusCode; }
+    // Returns true if the server announced it closes the connection
+    bool closes() const { return closeAfter; }
+
+private:
+    enum class State { Head, Body, ChunkSize, ChunkData, ChunkEnd, Trailer, Done };
+
+    State state = State::Head;
+    std::string line;          // Partial head or chunk-size line carried between reads
+    uint64_t remaining = 0;    // Body or chunk bytes left
+    int statusCode = 0;        // Parsed status code
+    bool closeAfter = false;   // Connection: close seen
+    bool chunked = false;      // Transfer-Encoding: chunked seen
+    bool noBody = false;       // Response to HEAD
+
+    // Interprets the complete head held in line
+    bool parseHead();
+};
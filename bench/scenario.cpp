@@ -0,0 +1,207 @@
+#include "scenario.h"
+#include "json.h"
+#include <fstream>
+#include <sstream>
+#include <cctype>
+
+/**
+ * @brief Compares two header names case-insensitively.
+ */
+static bool sameName(const std::string& a, const char* b) {
+    size_t i = 0;
+    for (; i < a.size() && b[i] != '\0'; ++i) {
+        if (std::tolower(static_cast<unsigned char>(a[i])) != std::tolower(static_cast<unsigned char>(b[i]))) {
+            return false;
+        }
+    }
+    return i == a.size() && b[i] == '\0';
+}
+
+/**
+ * @brief Serializes a request.
+ * @details Host is always sent; Content-Length only with a body; the Connection header
+ *          reflects close. A Connection header among headers is replaced, and one saying
+ *          "close" makes the request close its connection.
+ * @param method Request method
+ * @param target Request target (path and query)
+ * @param headers Extra headers in order
+ * @param body Request body
+ * @param host Host header value
+ * @param close Ask the server to close the connection after the response
+ * @return Request template
+ */
+RequestTemplate makeRequest(const std::string& method, const std::string& target,
+    const std::vector<std::pair<std::string, std::string>>& headers, const std::string& body,
+    const std::string& host, bool close) {
+    RequestTemplate request;
+    request.name = method + " " + target;
+    request.head = method == "HEAD";
+    request.close = close;
+    std::string& out = request.bytes;
+    out.append(method).append(" ").append(target).append(" HTTP/1.1\r\n");
+    out.append("Host: ").append(host).append("\r\n");
+    for (const auto& header : headers) {
+        if (sameName(header.first, "Connection")) {
+            request.close = request.close || sameName(header.second, "close");
+            continue;
+        }
+        if (sameName(header.first, "Host") || sameName(header.first, "Content-Length")) {
+            continue;
+        }
+        out.append(header.first).append(": ").append(header.second).append("\r\n");
+    }
+    if (!body.empty() || method == "POST" || method == "PUT") {
+        out.append("Content-Length: ").append(std::to_string(body.size())).append("\r\n");
+    }
+    out.append(request.close ? "Connection: close\r\n\r\n" : "Connection: keep-alive\r\n\r\n");
+    out.append(body);
+    return request;
+}
+
+/**
+ * @brief Returns the names accepted by builtinScenario().
+ */
+const char* builtinScenarioNames() {
+    return "health, get, lang, head, put-delete, echo, close, mixed";
+}
+
+/**
+ * @brief Builds a built-in scenario modeled on the Postman collections.
+ * @param name Scenario name
+ * @param host Host header value
+ * @param forceClose Send Connection: close on every request
+ * @param out Receives the requests, replayed in order by every connection
+ * @return False if name is unknown
+ */
+bool builtinScenario(const std::string& name, const std::string& host, bool forceClose, std::vector<RequestTemplate>& out) {
+    using Headers = std::vector<std::pair<std::string, std::string>>;
+    const Headers plain = { { "Content-Type", "text/plain" } };
+    out.clear();
+    if (name == "health") {
+        out.push_back(makeRequest("GET", "/health", {}, "", host, forceClose));
+    }
+    else if (name == "get") {
+        out.push_back(makeRequest("GET", "/", {}, "", host, forceClose));
+    }
+    else if (name == "lang") {
+        out.push_back(makeRequest("GET", "/?lang=fr", {}, "", host, forceClose));
+        out.push_back(makeRequest("GET", "/about.html?lang=fr", {}, "", host, forceClose));
+    }
+    else if (name == "head") {
+        out.push_back(makeRequest("HEAD", "/index.html", {}, "", host, forceClose));
+    }
+    else if (name == "put-delete") {
+        out.push_back(makeRequest("PUT", "/bench.txt", plain, "Hello world", host, forceClose));
+        out.push_back(makeRequest("DELETE", "/bench.txt", {}, "", host, forceClose));
+    }
+    else if (name == "echo") {
+        out.push_back(makeRequest("POST", "/echo", plain, "Echo this text", host, forceClose));
+    }
+    else if (name == "close") {
+        out.push_back(makeRequest("GET", "/health", {}, "", host, true));
+    }
+    else if (name == "mixed") {
+        out.push_back(makeRequest("GET", "/", {}, "", host, forceClose));
+        out.push_back(makeRequest("GET", "/?lang=fr", {}, "", host, forceClose));
+        out.push_back(makeRequest("HEAD", "/index.html", {}, "", host, forceClose));
+        out.push_back(makeRequest("POST", "/echo", plain, "Echo this text", host, forceClose));
+        out.push_back(makeRequest("PUT", "/bench.txt", plain, "Hello world", host, forceClose));
+        out.push_back(makeRequest("DELETE", "/bench.txt", {}, "", host, forceClose));
+        out.push_back(makeRequest("GET", "/health", {}, "", host, forceClose));
+    }
+    else {
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Extracts the request target from a Postman URL ("http://localhost:8080/a?b" -> "/a?b").
+ */
+static std::string targetOf(const JsonValue& url) {
+    std::string raw = url.type == JsonValue::Type::String ? url.text : (url.find("raw") ? url.find("raw")->asString() : "");
+    size_t scheme = raw.find("://");
+    size_t start = scheme == std::string::npos ? 0 : scheme + 3;
+    size_t slash = raw.find_first_of("/?", start);
+    std::string target = slash == std::string::npos ? "/" : raw.substr(slash);
+    return target.empty() || target[0] != '/' ? "/" + target : target;
+}
+
+/**
+ * @brief Appends the requests of a collection item list, descending into folders.
+ */
+static void collectItems(const JsonValue& items, const std::string& host, bool forceClose, std::vector<RequestTemplate>& out) {
+    for (const JsonValue& item : items.items) {
+        if (const JsonValue* children = item.find("item")) {
+            collectItems(*children, host, forceClose, out);
+            continue;
+        }
+        const JsonValue* request = item.find("request");
+        if (request == nullptr) {
+            continue;
+        }
+        const JsonValue* method = request->find("method");
+        const JsonValue* url = request->find("url");
+        if (method == nullptr || url == nullptr) {
+            continue;
+        }
+        std::vector<std::pair<std::string, std::string>> headers;
+        if (const JsonValue* list = request->find("header")) {
+            for (const JsonValue& header : list->items) {
+                const JsonValue* key = header.find("key");
+                const JsonValue* value = header.find("value");
+                const JsonValue* disabled = header.find("disabled");
+                if (key != nullptr && value != nullptr && !(disabled != nullptr && disabled->boolean)) {
+                    headers.emplace_back(key->asString(), value->asString());
+                }
+            }
+        }
+        std::string body;
+        if (const JsonValue* spec = request->find("body")) {
+            if (const JsonValue* raw = spec->find("raw")) {
+                body = raw->asString();
+            }
+        }
+        RequestTemplate built = makeRequest(method->asString(), targetOf(*url), headers, body, host, forceClose);
+        if (const JsonValue* name = item.find("name")) {
+            built.name = name->asString(built.name);
+        }
+        out.push_back(std::move(built));
+    }
+}
+
+/**
+ * @brief Loads the requests of a Postman v2.1 collection.
+ * @details Scheme, host and port of the URLs are ignored: every request goes to the server
+ *          under test. Test scripts are not run; responses are only counted by status.
+ * @param path Collection file
+ * @param host Host header value
+ * @param forceClose Send Connection: close on every request
+ * @param out Receives the requests in collection order
+ * @param error Receives a description on failure
+ * @return True if at least one request was loaded
+ */
+bool loadCollection(const std::string& path, const std::string& host, bool forceClose,
+    std::vector<RequestTemplate>& out, std::string& error) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        error = "cannot open " + path;
+        return false;
+    }
+    std::stringstream contents;
+    contents << file.rdbuf();
+    JsonValue root;
+    if (!parseJson(contents.str(), root, error)) {
+        error = path + ": " + error;
+        return false;
+    }
+    out.clear();
+    if (const JsonValue* items = root.find("item")) {
+        collectItems(*items, host, forceClose, out);
+    }
+    if (out.empty()) {
+        error = path + ": no requests found";
+        return false;
+    }
+    return true;
+}
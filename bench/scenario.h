@@ -0,0 +1,29 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <utility>
+
+/**
+ * @brief One request of a benchmark scenario, serialized once up front.
+ */
+struct RequestTemplate {
+    std::string name;  // Label used in the per-request report ("GET /?lang=fr")
+    std::string bytes; // Complete request: request line, headers and body
+    bool head = false; // HEAD request: the response has no body
+    bool close = false; // Sends Connection: close, so the connection is reopened afterwards
+};
+
+// Builds a request with Host, Content-Length (when there is a body) and the Connection header
+RequestTemplate makeRequest(const std::string& method, const std::string& target,
+    const std::vector<std::pair<std::string, std::string>>& headers, const std::string& body,
+    const std::string& host, bool close);
+
+// Fills out with a built-in scenario (health, get, lang, head, put-delete, echo, close, mixed); false if unknown
+bool builtinScenario(const std::string& name, const std::string& host, bool forceClose, std::vector<RequestTemplate>& out);
+
+// Fills out with every request of a Postman v2.1 collection, in order; false with error on failure
+bool loadCollection(const std::string& path, const std::string& host, bool forceClose,
+    std::vector<RequestTemplate>& out, std::string& error);
+
+// Returns the names accepted by builtinScenario()
+const char* builtinScenarioNames();
@@ -0,0 +1,166 @@
+#include "blocking-pool.h"
+#include "utils.h"
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <thread>
+#include <algorithm>
+#ifdef __linux__
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+/**
+ * @brief Shared state of the pool threads.
+ */
+struct PoolState {
+    std::mutex mutex;                               // Guards jobs and stopping
+    std::condition_variable ready;                  // Signalled when a job is queued or the pool stops
+    std::deque<std::shared_ptr<BlockingJob>> jobs;  // Jobs waiting for a thread
+    std::vector<std::thread> threads;               // Worker threads
+    bool stopping = false;                          // Set at exit
+
+    ~PoolState() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        ready.notify_all();
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+    }
+};
+
+static PoolState pool;                     // The process-wide pool
+static std::atomic<bool> running(false);   // True once threads were started
+
+/**
+ * @brief Creates the wakeup descriptor.
+ */
+CompletionQueue::CompletionQueue() : head(nullptr), eventFd(-1) {
+#ifdef __linux__
+    eventFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (eventFd == -1) {
+        logError("Error at eventfd()", errno);
+    }
+#endif
+}
+
+/**
+ * @brief Closes the wakeup descriptor; jobs still in flight are dropped.
+ */
+CompletionQueue::~CompletionQueue() {
+    std::vector<std::shared_ptr<BlockingJob>> pending;
+    drain(pending);
+#ifdef __linux__
+    if (eventFd != -1) {
+        ::close(eventFd);
+    }
+#endif
+}
+
+/**
+ * @brief Hands a finished job back to its reactor.
+ * @details Only the push that finds the stack empty writes the eventfd: the reactor reads the
+ *          eventfd before taking the stack, so every job pushed onto an empty stack after that
+ *          raises a new wakeup and none is left behind.
+ * @param job Finished job (kept alive by job->self)
+ */
+void CompletionQueue::push(BlockingJob* job) {
+    BlockingJob* expected = head.load(std::memory_order_relaxed);
+    do {
+        job->next = expected;
+    } while (!head.compare_exchange_weak(expected, job, std::memory_order_release, std::memory_order_relaxed));
+#ifdef __linux__
+    if (expected == nullptr && eventFd != -1) {
+        uint64_t one = 1;
+        ssize_t written = ::write(eventFd, &one, sizeof(one));
+        (void)written; // Only fails if the counter would overflow, which leaves it readable anyway
+    }
+#endif
+}
+
+/**
+ * @brief Takes every finished job.
+ * @param out Receives the jobs in the order they finished (ownership moves out of job->self)
+ */
+void CompletionQueue::drain(std::vector<std::shared_ptr<BlockingJob>>& out) {
+#ifdef __linux__
+    if (eventFd != -1) {
+        uint64_t count;
+        ssize_t bytesRead = ::read(eventFd, &count, sizeof(count));
+        (void)bytesRead; // EAGAIN when the stack was refilled without a new wakeup
+    }
+#endif
+    BlockingJob* job = head.exchange(nullptr, std::memory_order_acquire);
+    size_t first = out.size();
+    while (job != nullptr) {
+        BlockingJob* next = job->next;
+        out.push_back(std::move(job->self));
+        job = next;
+    }
+    std::reverse(out.begin() + static_cast<std::ptrdiff_t>(first), out.end());
+}
+
+/**
+ * @brief Runs queued jobs until the pool stops.
+ */
+static void workerLoop() {
+    while (true) {
+        std::shared_ptr<BlockingJob> job;
+        {
+            std::unique_lock<std::mutex> lock(pool.mutex);
+            pool.ready.wait(lock, [] { return pool.stopping || !pool.jobs.empty(); });
+            if (pool.stopping) {
+                return;
+            }
+            job = std::move(pool.jobs.front());
+            pool.jobs.pop_front();
+        }
+        job->work();
+        BlockingJob* finished = job.get();
+        finished->self = std::move(job);
+        finished->completions->push(finished);
+    }
+}
+
+/**
+ * @brief Starts the worker threads.
+ * @details Without an eventfd to wake the reactors (non-Linux) the pool stays off and file
+ *          operations keep running on the event loop.
+ * @param threads Number of threads, 0 to keep file operations inline
+ */
+void BlockingPool::start(unsigned threads) {
+#ifdef __linux__
+    if (threads == 0 || running.load(std::memory_order_relaxed)) {
+        return;
+    }
+    for (unsigned i = 0; i < threads; ++i) {
+        pool.threads.emplace_back(workerLoop);
+    }
+    running.store(true, std::memory_order_release);
+#else
+    (void)threads;
+#endif
+}
+
+/**
+ * @brief Returns true if blocking operations should be deferred to the pool.
+ */
+bool BlockingPool::enabled() {
+    return running.load(std::memory_order_acquire);
+}
+
+/**
+ * @brief Queues a job for the next free thread.
+ * @param job Job whose completions queue is set
+ */
+void BlockingPool::submit(std::shared_ptr<BlockingJob> job) {
+    {
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        pool.jobs.push_back(std::move(job));
+    }
+    pool.ready.notify_one();
+}
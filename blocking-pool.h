@@ -0,0 +1,82 @@
+#pragma once
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include "request.h"
+#include "response.h"
+#include "router.h"
+
+class CompletionQueue;
+
+/**
+ * @brief A blocking file operation run on the I/O pool on behalf of a parked connection.
+ * @details work() runs on a pool thread and must not touch the connection, its buffers or
+ *          any reactor-owned state (the content cache): everything it needs is copied into
+ *          the closures up front. finish() runs back on the reactor thread with the request
+ *          parsed again from the connection buffer, and builds the response. A job submitted
+ *          for a coroutine handler's runBlocking() has no finish(): the handler is resumed instead.
+ *          A job with complete() belongs to no connection (the content cache building a variant)
+ *          and only runs that on the reactor thread.
+ */
+struct BlockingJob {
+    std::function<void()> work;                     // Blocking part, run on a pool thread
+    std::function<Response(const Request&)> finish; // Builds the response on the reactor thread
+    std::function<void()> complete;                 // Runs on the reactor thread for a job without a connection
+    bool headReleased = false;                      // Streamed upload: the head is gone, finish gets an empty Request
+    uint64_t client = 0;                            // Connection handle of the parked client
+    Method method = Method::Unknown;                // Request method, for the response counters
+    uint64_t startedUs = 0;                         // metricsClockUs() when the request was first dispatched
+    CompletionQueue* completions = nullptr;         // Queue of the reactor that submitted the job
+    std::shared_ptr<void> owner;                    // Keeps what work() refers to alive (a suspended coroutine handler)
+    std::shared_ptr<BlockingJob> self;              // Keeps the job alive while it is in flight
+    BlockingJob* next = nullptr;                    // Link in the completion queue
+};
+
+/**
+ * @brief Per-reactor queue of finished jobs.
+ * @details Pool threads push with a compare-and-swap onto an intrusive stack and never take
+ *          a lock; the reactor takes the whole stack with one exchange and reverses it into
+ *          completion order. The pusher that finds the stack empty signals an eventfd, which
+ *          the reactor polls like a socket, so a burst of completions costs one wakeup.
+ */
+class CompletionQueue {
+public:
+    // Creates the wakeup descriptor (Linux)
+    CompletionQueue();
+    // Closes the wakeup descriptor
+    ~CompletionQueue();
+
+    CompletionQueue(const CompletionQueue&) = delete;
+    CompletionQueue& operator=(const CompletionQueue&) = delete;
+
+    // Returns the descriptor that becomes readable when jobs complete, or -1 if there is none
+    int handle() const { return eventFd; }
+    // Hands a finished job back to the reactor (any thread)
+    void push(BlockingJob* job);
+    // Moves every finished job into out, oldest first (reactor thread only)
+    void drain(std::vector<std::shared_ptr<BlockingJob>>& out);
+
+private:
+    std::atomic<BlockingJob*> head; // Most recently finished job
+    int eventFd;                    // Wakeup descriptor, -1 if unavailable
+};
+
+/**
+ * @brief Process-wide pool of threads that run blocking file operations.
+ * @details Shared by every reactor. Jobs are taken first-in first-out from a mutex-guarded
+ *          queue (the reactor only holds the lock to append) and handed back through the
+ *          submitting reactor's CompletionQueue. With no threads, handlers do their file work
+ *          inline as before. Only available on Linux, where completions wake the loop through
+ *          an eventfd.
+ */
+class BlockingPool {
+public:
+    // Starts the worker threads (0 keeps file operations on the event loop); call before the reactors start
+    static void start(unsigned threads);
+    // Returns true if handlers should defer blocking operations to the pool
+    static bool enabled();
+    // Queues a job; it is pushed to job->completions once work() has run
+    static void submit(std::shared_ptr<BlockingJob> job);
+};
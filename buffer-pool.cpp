@@ -0,0 +1,215 @@
+#include "buffer-pool.h"
+#include "memory-budget.h"
+#include <cstring>
+#include <algorithm>
+
+/**
+ * @brief Creates an empty pool; slabs are allocated on demand.
+ */
+BufferPool::BufferPool() : oversizeInUse(0), oversizeBytes(0) {}
+
+/**
+ * @brief Frees every slab; buffers still lent out must not be used afterwards.
+ */
+BufferPool::~BufferPool() {}
+
+/**
+ * @brief Borrows a buffer.
+ * @param minSize Minimum size needed
+ * @param capacity Receives the size of the returned buffer
+ * @return Buffer of the smallest class that fits, or a heap buffer above the largest class
+ */
+char* BufferPool::acquire(size_t minSize, size_t& capacity) {
+    for (size_t i = 0; i < CLASS_COUNT; ++i) {
+        if (minSize > CLASS_SIZES[i]) {
+            continue;
+        }
+        SizeClass& sizeClass = classes[i];
+        if (sizeClass.freeList.empty()) {
+            grow(i);
+        }
+        char* buffer = sizeClass.freeList.back();
+        sizeClass.freeList.pop_back();
+        sizeClass.inUse++;
+        capacity = CLASS_SIZES[i];
+        return buffer;
+    }
+    // Round oversize requests up to a multiple of the largest class to limit regrowth
+    const size_t largest = CLASS_SIZES[CLASS_COUNT - 1];
+    capacity = (minSize + largest - 1) / largest * largest;
+    oversizeInUse++;
+    oversizeBytes += capacity;
+    return new char[capacity];
+}
+
+/**
+ * @brief Returns a buffer to its free list (or frees an oversize one).
+ * @param buffer Buffer from acquire()
+ * @param capacity Capacity reported by acquire()
+ */
+void BufferPool::release(char* buffer, size_t capacity) {
+    for (size_t i = 0; i < CLASS_COUNT; ++i) {
+        if (capacity == CLASS_SIZES[i]) {
+            classes[i].freeList.push_back(buffer);
+            classes[i].inUse--;
+            return;
+        }
+    }
+    oversizeInUse--;
+    oversizeBytes -= capacity;
+    delete[] buffer;
+}
+
+/**
+ * @brief Returns the current occupancy.
+ */
+BufferPool::Stats BufferPool::stats() const {
+    Stats stats;
+    for (size_t i = 0; i < CLASS_COUNT; ++i) {
+        stats.inUse[i] = classes[i].inUse;
+        stats.total[i] = classes[i].total;
+    }
+    stats.slabBytes = slabs.size() * SLAB_SIZE;
+    stats.oversizeInUse = oversizeInUse;
+    stats.oversizeBytes = oversizeBytes;
+    return stats;
+}
+
+/**
+ * @brief Formats the occupancy as a single log line.
+ */
+std::string BufferPool::describe() const {
+    std::string line;
+    for (size_t i = 0; i < CLASS_COUNT; ++i) {
+        line += std::to_string(CLASS_SIZES[i] / 1024) + "K " + std::to_string(classes[i].inUse) + "/" + std::to_string(classes[i].total) + " ";
+    }
+    line += "oversize " + std::to_string(oversizeInUse) + " (" + std::to_string(oversizeBytes) + " B) ";
+    line += "slabs " + std::to_string(slabs.size() * SLAB_SIZE / 1024) + " KiB";
+    return line;
+}
+
+/**
+ * @brief Allocates one slab and adds its buffers to a class's free list.
+ * @param index Size class index
+ */
+void BufferPool::grow(size_t index) {
+    slabs.emplace_back(new char[SLAB_SIZE]);
+    char* slab = slabs.back().get();
+    SizeClass& sizeClass = classes[index];
+    for (size_t offset = 0; offset + CLASS_SIZES[index] <= SLAB_SIZE; offset += CLASS_SIZES[index]) {
+        sizeClass.freeList.push_back(slab + offset);
+        sizeClass.total++;
+    }
+}
+
+/**
+ * @brief Creates an empty buffer.
+ * @param pool Pool to borrow from, or null for plain heap memory
+ */
+IoBuffer::IoBuffer(BufferPool* pool) : pool(pool), buffer(nullptr), bufferSize(0), start(0), end(0) {}
+
+/**
+ * @brief Returns any borrowed memory.
+ */
+IoBuffer::~IoBuffer() {
+    clear();
+}
+
+/**
+ * @brief Ensures length bytes can be written at the tail.
+ * @details Borrows a buffer if none is held, compacts unconsumed bytes to the front if that
+ *          frees enough room, and otherwise moves to a buffer at least twice as large.
+ * @param length Bytes about to be written
+ * @return Write position (valid until the next prepare(), append() or consume())
+ */
+char* IoBuffer::prepare(size_t length) {
+    if (buffer == nullptr) {
+        reallocate(length);
+    }
+    else if (bufferSize - end < length) {
+        if (bufferSize - size() >= length && start > 0) {
+            std::memmove(buffer, buffer + start, size());
+            end -= start;
+            start = 0;
+        }
+        else {
+            reallocate((std::max)(size() + length, bufferSize * 2));
+        }
+    }
+    return buffer + end;
+}
+
+/**
+ * @brief Marks bytes written after prepare() as buffered.
+ * @param length Bytes written (at most writable())
+ */
+void IoBuffer::commit(size_t length) {
+    end += length;
+}
+
+/**
+ * @brief Copies bytes to the tail.
+ * @param bytes Source
+ * @param length Number of bytes
+ */
+void IoBuffer::append(const char* bytes, size_t length) {
+    if (length == 0) {
+        return;
+    }
+    std::memcpy(prepare(length), bytes, length);
+    end += length;
+}
+
+/**
+ * @brief Drops bytes from the front.
+ * @param length Number of bytes (clamped to size())
+ */
+void IoBuffer::consume(size_t length) {
+    start += (std::min)(length, size());
+    if (start == end) {
+        clear();
+    }
+}
+
+/**
+ * @brief Drops every byte and gives the memory back.
+ */
+void IoBuffer::clear() {
+    if (buffer != nullptr) {
+        giveBack(buffer, bufferSize);
+    }
+    buffer = nullptr;
+    bufferSize = start = end = 0;
+}
+
+/**
+ * @brief Moves the unconsumed bytes into a buffer of at least minCapacity bytes.
+ * @param minCapacity Required capacity
+ */
+void IoBuffer::reallocate(size_t minCapacity) {
+    size_t capacity = minCapacity;
+    char* memory = pool ? pool->acquire(minCapacity, capacity) : new char[capacity];
+    size_t length = size();
+    if (buffer != nullptr) {
+        std::memcpy(memory, buffer + start, length);
+        giveBack(buffer, bufferSize);
+    }
+    buffer = memory;
+    bufferSize = capacity;
+    start = 0;
+    end = length;
+    MemoryBudget::chargeInput(static_cast<int64_t>(capacity));
+}
+
+/**
+ * @brief Hands memory back to the pool or the heap, releasing it from the memory budget.
+ */
+void IoBuffer::giveBack(char* memory, size_t size) {
+    MemoryBudget::chargeInput(-static_cast<int64_t>(size));
+    if (pool) {
+        pool->release(memory, size);
+    }
+    else {
+        delete[] memory;
+    }
+}
@@ -0,0 +1,116 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <cstddef>
+
+/**
+ * @brief Slab allocator for connection I/O buffers.
+ * @details Buffers come in a few size classes carved out of 256 KiB slabs and are recycled
+ *          through per-class free lists, so borrowing and returning one is a vector push/pop.
+ *          Requests above the largest class are served from the heap and counted as oversize.
+ *          One pool is owned by each reactor and used only from its thread.
+ */
+class BufferPool {
+public:
+    static constexpr size_t CLASS_COUNT = 3;                                   // Number of size classes
+    static constexpr size_t CLASS_SIZES[CLASS_COUNT] = { 4096, 16384, 65536 }; // Buffer size per class
+    static constexpr size_t SLAB_SIZE = 256 * 1024;                            // Bytes allocated per slab
+
+    // Occupancy snapshot
+    struct Stats {
+        size_t inUse[CLASS_COUNT];   // Borrowed buffers per class
+        size_t total[CLASS_COUNT];   // Carved buffers per class
+        size_t slabBytes;            // Memory held in slabs
+        size_t oversizeInUse;        // Borrowed heap buffers above the largest class
+        size_t oversizeBytes;        // Bytes held by those heap buffers
+    };
+
+    BufferPool();
+    ~BufferPool();
+
+    BufferPool(const BufferPool&) = delete;
+    BufferPool& operator=(const BufferPool&) = delete;
+
+    // Borrows a buffer of at least minSize bytes; capacity receives its actual size
+    char* acquire(size_t minSize, size_t& capacity);
+    // Returns a buffer obtained from acquire() with the capacity it reported
+    void release(char* buffer, size_t capacity);
+    // Returns the current occupancy
+    Stats stats() const;
+    // Formats the occupancy as one line, e.g. "4K 3/64 16K 0/0 64K 1/4 oversize 0 (0 B) slabs 512 KiB"
+    std::string describe() const;
+
+private:
+    // Buffers of one size
+    struct SizeClass {
+        std::vector<char*> freeList; // Buffers ready to lend
+        size_t inUse = 0;            // Buffers lent out
+        size_t total = 0;            // Buffers carved from slabs
+    };
+
+    SizeClass classes[CLASS_COUNT];            // Size classes, smallest first
+    std::vector<std::unique_ptr<char[]>> slabs; // Slab memory, kept for the pool's lifetime
+    size_t oversizeInUse;                      // Heap buffers lent out
+    size_t oversizeBytes;                      // Bytes in those heap buffers
+
+    // Carves a new slab into buffers of class index
+    void grow(size_t index);
+};
+
+/**
+ * @brief Growable byte buffer backed by a BufferPool.
+ * @details Holds no memory while empty: a buffer is borrowed on the first write and returned as
+ *          soon as every byte has been consumed, so idle connections cost nothing. Consumed
+ *          bytes are dropped by advancing a start offset; the rest is compacted only when the
+ *          tail runs out of room. The capacity held is charged to MemoryBudget as input.
+ */
+class IoBuffer {
+public:
+    // Creates an empty buffer drawing from pool (plain heap memory if pool is null)
+    explicit IoBuffer(BufferPool* pool = nullptr);
+    // Returns any borrowed memory
+    ~IoBuffer();
+
+    IoBuffer(const IoBuffer&) = delete;
+    IoBuffer& operator=(const IoBuffer&) = delete;
+
+    // Returns the first unconsumed byte
+    const char* data() const { return buffer + start; }
+    // Returns the first unconsumed byte for in-place rewriting (the parser decodes chunked bodies here)
+    char* data() { return buffer + start; }
+    // Returns the number of unconsumed bytes
+    size_t size() const { return end - start; }
+    // Returns true if no bytes are buffered
+    bool empty() const { return end == start; }
+    // Returns the unconsumed bytes as a view (invalidated by writes and consume())
+    std::string_view view() const { return std::string_view(data(), size()); }
+    // Returns the capacity of the borrowed buffer (0 when none is held)
+    size_t capacity() const { return bufferSize; }
+
+    // Makes room for at least length bytes at the tail and returns where to write them
+    char* prepare(size_t length);
+    // Returns the bytes writable at the tail after prepare()
+    size_t writable() const { return bufferSize - end; }
+    // Marks length bytes written at the tail as buffered
+    void commit(size_t length);
+    // Copies bytes to the tail
+    void append(const char* bytes, size_t length);
+    // Drops length bytes from the front, returning the buffer to the pool when it empties
+    void consume(size_t length);
+    // Drops every byte and returns the buffer to the pool
+    void clear();
+
+private:
+    BufferPool* pool;  // Source of buffers (null = heap)
+    char* buffer;      // Borrowed memory, null when empty
+    size_t bufferSize; // Size of buffer
+    size_t start;      // First unconsumed byte
+    size_t end;        // One past the last buffered byte
+
+    // Replaces the buffer with one of at least minCapacity bytes, keeping the unconsumed bytes
+    void reallocate(size_t minCapacity);
+    // Hands memory back to the pool or the heap
+    void giveBack(char* memory, size_t size);
+};
@@ -1,11 +1,14 @@
 #include "client.h"
 
-// Helper to convert ClientState to string
-static std::string clientStateToString(ClientState state) {
+/**
+ * @brief Returns the name of a client state, as written to the state log.
+ */
+std::string clientStateToString(ClientState state) {
     switch (state) {
         case ClientState::Disconnected: return "Disconnected";
         case ClientState::AwaitingRequest: return "AwaitingRequest";
         case ClientState::RequestBuffered: return "RequestBuffered";
+        case ClientState::AwaitingHandler: return "AwaitingHandler";
         case ClientState::ResponseReady: return "ResponseReady";
         case ClientState::Completed: return "Completed";
         case ClientState::Aborted: return "Aborted";
@@ -17,30 +20,40 @@ static std::string clientStateToString(ClientState state) {
  * @brief Constructs a client with socket and address.
  * @param s Socket descriptor
  * @param addr Client address
+ * @param pool Pool the input buffer borrows from (null = heap)
  */
-Client::Client(SOCKET s, const sockaddr_in& addr)
-    : socket(s), lastActive(0), keepAlive(true), state(ClientState::AwaitingRequest) {
+Client::Client(SOCKET s, const sockaddr_in& addr, BufferPool* pool)
+    : socket(s), state(ClientState::AwaitingRequest), timeout(TimeoutKind::None), keepAlive(true), readProgress(false), writeProgress(false),
+      readPaused(false), sendInFlight(false), interest(0), readSize(MIN_READ_SIZE), outOffset(0), requests(0), outputBytes(0), inBuffer(pool), lastReadUs(0) {
     std::ostringstream oss;
     oss << inet_ntoa(addr.sin_addr) << ":" << ntohs(addr.sin_port);
     clientAddr = oss.str();
-    inBuffer.reserve(BUFF_SIZE);
-    outBuffer.reserve(BUFF_SIZE);
 }
 
 /**
  * @brief Default constructor for Client.
  */
 Client::Client()
-    : socket(INVALID_SOCKET), lastActive(0), keepAlive(true), state(ClientState::Disconnected) {
+    : socket(INVALID_SOCKET), state(ClientState::Disconnected), timeout(TimeoutKind::None), keepAlive(true), readProgress(false), writeProgress(false),
+      readPaused(false), sendInFlight(false), interest(0), readSize(MIN_READ_SIZE), outOffset(0), requests(0), outputBytes(0), lastReadUs(0) {
     clientAddr = "";
-    inBuffer.reserve(BUFF_SIZE);
-    outBuffer.reserve(BUFF_SIZE);
 }
 
 /**
- * @brief Destructor for Client.
+ * @brief Destructor for Client: releases the queued output from the memory budget.
+ */
+Client::~Client() {
+    chargeOutput(-static_cast<int64_t>(outputBytes));
+}
+
+/**
+ * @brief Accounts for output bytes queued or freed.
+ * @param delta Bytes added to (positive) or removed from (negative) outQueue
  */
-Client::~Client() {}
+void Client::chargeOutput(int64_t delta) {
+    outputBytes = static_cast<size_t>(static_cast<int64_t>(outputBytes) + delta);
+    MemoryBudget::chargeOutput(delta);
+}
 
 /**
  * @brief Sets client state to Disconnected.
@@ -56,7 +69,6 @@ void Client::setDisconnected() {
  */
 void Client::setAwaitingRequest() {
     std::string oldState = clientStateToString(state);
-    lastActive = time(nullptr);
     state = ClientState::AwaitingRequest;
     logClientState(clientAddr, oldState, clientStateToString(state));
 }
@@ -66,11 +78,19 @@ void Client::setAwaitingRequest() {
  */
 void Client::setRequestBuffered() {
     std::string oldState = clientStateToString(state);
-    lastActive = time(nullptr);
     state = ClientState::RequestBuffered;
     logClientState(clientAddr, oldState, clientStateToString(state));
 }
 
+/**
+ * @brief Sets client state to AwaitingHandler.
+ */
+void Client::setAwaitingHandler() {
+    std::string oldState = clientStateToString(state);
+    state = ClientState::AwaitingHandler;
+    logClientState(clientAddr, oldState, clientStateToString(state));
+}
+
 /**
  * @brief Sets client state to ResponseReady.
  */
@@ -86,7 +106,9 @@ void Client::setResponseReady() {
 void Client::setCompleted() {
     std::string oldState = clientStateToString(state);
     inBuffer.clear();
-    outBuffer.clear();
+    outQueue.clear();
+    chargeOutput(-static_cast<int64_t>(outputBytes));
+    outOffset = 0;
     state = ClientState::Completed;
     logClientState(clientAddr, oldState, clientStateToString(state));
 }
@@ -101,12 +123,30 @@ void Client::setAborted() {
 }
 
 /**
- * @brief Checks if client is idle for longer than timeoutSec seconds.
- * @param timeoutSec Timeout in seconds
- * @return True if idle, false otherwise
+ * @brief Returns an empty buffer for serializing a response head.
+ * @return A recycled buffer (capacity kept) or a new one reserved to HEAD_RESERVE bytes
  */
-bool Client::isIdle(int timeoutSec) const {
-    return (difftime(time(nullptr), lastActive) > timeoutSec && state == ClientState::AwaitingRequest);
+std::string Client::takeHeadBuffer() {
+    if (spareHeads.empty()) {
+        std::string head;
+        head.reserve(HEAD_RESERVE);
+        return head;
+    }
+    std::string head = std::move(spareHeads.back());
+    spareHeads.pop_back();
+    return head;
+}
+
+/**
+ * @brief Keeps a sent response's head buffer so its capacity can be reused.
+ * @param response Response whose head is no longer needed
+ */
+void Client::recycleHead(OutboundResponse& response) {
+    if (spareHeads.size() < MAX_SPARE_HEADS && response.head.capacity() > 0) {
+        response.head.clear();
+        spareHeads.push_back(std::move(response.head));
+    }
+    response.head.clear();
 }
 
 /**
@@ -114,6 +154,6 @@ bool Client::isIdle(int timeoutSec) const {
  * @param data Incoming data
  */
 void Client::bufferRequest(const std::string& data) {
-    inBuffer.append(data);
+    inBuffer.append(data.data(), data.size());
     setRequestBuffered();
 }
\ No newline at end of file
@@ -1,49 +1,120 @@
 #pragma once
-#define _CRT_SECURE_NO_WARNINGS
-#define _WINSOCK_DEPRECATED_NO_WARNINGS
-
-#include <winsock2.h>
 #include <string>
 #include <iostream>
 #include <memory>
+#include <deque>
+#include <vector>
 #include <sstream>
 #include <ctime>
 #include "request.h"
+#include "request-parser.h"
 #include "response.h"
 #include "utils.h"
-#pragma comment(lib, "Ws2_32.lib")
+#include "platform.h"
+#include "buffer-pool.h"
+#include "timer-wheel.h"
+#include "upload.h"
+#include "async-handler.h"
+#include "memory-budget.h"
+#include "access-log.h"
 
 static constexpr size_t BUFF_SIZE = 1024; // 4KB max buffer size
+static constexpr size_t MIN_READ_SIZE = 4096;  // Read size of a new or idle connection
+static constexpr size_t MAX_READ_SIZE = 65536; // Read size cap for connections moving bulk data
+static constexpr size_t HEAD_RESERVE = 512; // Initial capacity of a response head buffer
+static constexpr size_t MAX_SPARE_HEADS = 8; // Head buffers kept per client for reuse
 
 /**
  * @brief Enum representing the state of a client connection.
  * @details Used for managing the client's lifecycle in the server.
  */
-enum class ClientState {
+enum class ClientState : uint8_t {
     Disconnected,      // No active client connection
     AwaitingRequest,   // Waiting for a new request
     RequestBuffered,   // Full request buffered
+    AwaitingHandler,   // Request parked while its file operation runs on the I/O pool or its coroutine handler waits
     ResponseReady,     // Response is ready
     Completed,         // Done, ready for next or close
     Aborted            // Socket should be closed
 };
 
+// Returns the name of a client state, as written to the state log
+std::string clientStateToString(ClientState state);
+
+/**
+ * @brief Deadline currently armed for a client.
+ */
+enum class TimeoutKind : uint8_t {
+    None,       // No timer armed
+    Idle,       // Keep-alive connection waiting for its next request
+    Header,     // Request headers not fully received
+    Body,       // Request body stalled
+    WriteStall, // Queued responses not draining
+    Wakeup,     // End of a coroutine handler's sleepFor() (not a deadline)
+    SocketWait  // Coroutine handler waiting on its own socket (resumes it with false)
+};
+
+/**
+ * @brief A response waiting to be written.
+ * @details The head and the body are kept apart and sent as separate slices of one gathered
+ *          write, so the body is never copied behind the headers.
+ */
+struct OutboundResponse {
+    std::string head;                              // Status line and headers
+    std::string body;                              // Owned in-memory body
+    std::shared_ptr<const std::string> sharedBody; // Body shared with the content cache (replaces body)
+    std::shared_ptr<FileHandle> file;              // File-backed body sent after the in-memory parts
+    uint64_t fileOffset = 0;                       // Next file byte to send
+    uint64_t fileRemaining = 0;                    // File bytes left to send
+    BodyProducer stream;                           // Producer of the chunks still to come (null once the last one is queued)
+    AccessRecord access;                           // Phase stamps of the request, logged once the response is sent
+
+    // Returns the in-memory body
+    const std::string& bodyData() const { return sharedBody ? *sharedBody : body; }
+    // Returns the bytes sent from memory (head and in-memory body)
+    size_t memorySize() const { return head.size() + bodyData().size(); }
+    // Returns the bytes the response owns (a shared body belongs to the content cache)
+    size_t ownedSize() const { return head.size() + body.size(); }
+};
+
 /**
  * @brief Represents a connected client and its state.
- * @details Manages the client's socket, buffers, state, and timing.
+ * @details Manages the client's socket, buffers, state, and timing. Fields read on every
+ *          event come first so they share the first two cache lines; the parser's offset
+ *          tables, the response queue and the address string follow.
  */
 class Client {
 public:
+    // Hot: touched on every readiness event or completion
     SOCKET socket;                  // Client socket descriptor
-    std::string clientAddr;         // Store client address
-    std::string inBuffer;           // Raw incoming data buffer
-    std::string outBuffer;          // Fully constructed HTTP response
-    time_t lastActive;              // Used for idle timeout tracking
-    bool keepAlive;                 // Connection: keep-alive or close
     ClientState state;
+    TimeoutKind timeout;            // What the armed timer guards
+    bool keepAlive;                 // Connection: keep-alive or close (of the last dispatched request)
+    bool readProgress;              // Bytes were received since the timer was last updated
+    bool writeProgress;             // Bytes were sent since the timer was last updated
+    bool readPaused;                // Reads are paused until the memory budget allows more
+    bool sendInFlight;              // An io_uring send reads from outQueue: the client must outlive its completion
+    unsigned interest;              // Readiness interest registered with the poller
+    size_t readSize;                // Bytes requested per recv(), grows while reads fill it
+    size_t outOffset;               // Bytes of outQueue.front() head and body already sent
+    size_t requests;                // Requests dispatched on this connection
+    size_t outputBytes;             // Owned bytes of outQueue, charged to MemoryBudget
+    TimerNode timer;                // Deadline of the current timeout, keyed by connection handle
+    IoBuffer inBuffer;              // Raw incoming data, backed by the reactor's pool only while non-empty
+
+    // Cold: touched while a request is parsed or a response is queued, or for logging
+    RequestParser parser;           // Incremental parser over inBuffer
+    std::deque<OutboundResponse> outQueue; // Responses to pipelined requests, in request order
+    std::vector<std::string> spareHeads; // Head buffers of sent responses, reused by takeHeadBuffer()
+    std::unique_ptr<FileUpload> upload; // PUT body being streamed to disk, null when none
+    std::shared_ptr<BlockingJob> job; // Finished I/O pool job whose response is still to be built
+    std::shared_ptr<AsyncCall> async; // Coroutine handler in flight, null when none
+    AccessRecord access;            // Phase stamps of the request being received, moved to its response
+    uint64_t lastReadUs;            // metricsClockUs() of the latest read
+    std::string clientAddr;         // Store client address
 
-	// Constructs a client with socket and address.
-    Client(SOCKET s, const sockaddr_in& addr);
+	// Constructs a client with socket and address; input buffers are borrowed from pool.
+    Client(SOCKET s, const sockaddr_in& addr, BufferPool* pool = nullptr);
 
 	// Default empty constructor for Client.
     Client();
@@ -59,12 +130,22 @@ public:
     void setDisconnected();
     void setAwaitingRequest();
     void setRequestBuffered();
+    void setAwaitingHandler();
     void setResponseReady();
     void setCompleted();
     void setAborted();
     
-	// Checks if the client has been idle for longer than timeoutSec seconds.
-    bool isIdle(int timeoutSec = 120) const;
+	// Returns true while a request still has to be finished: its body is being streamed or its handler is parked
+    bool inRequest() const { return upload || job || async || state == ClientState::AwaitingHandler; }
+
+	// Adds delta bytes to outputBytes and the process-wide output total
+    void chargeOutput(int64_t delta);
+
+	// Returns an empty head buffer, reusing the capacity of a sent response's head when possible
+    std::string takeHeadBuffer();
+
+	// Keeps the head buffer of a sent response for reuse
+    void recycleHead(OutboundResponse& response);
 
 	// Buffers incoming data into inBuffer
     void bufferRequest(const std::string& data);
@@ -0,0 +1,248 @@
+#include "compression.h"
+#include "request.h"
+
+static constexpr int GZIP_WINDOW_BITS = 15 + 16; // zlib window with a gzip wrapper
+static constexpr int ZLIB_WINDOW_BITS = 15;      // zlib window with a zlib wrapper
+static constexpr size_t OUTPUT_STEP = 16 * 1024; // Output grown per deflate() call
+static constexpr int NOT_LISTED = -1;            // Coding absent from Accept-Encoding
+
+/**
+ * @brief Strips spaces and tabs from both ends of a view.
+ */
+static std::string_view trimView(std::string_view text) {
+    while (!text.empty() && (text.front() == ' ' || text.front() == '\t')) {
+        text.remove_prefix(1);
+    }
+    while (!text.empty() && (text.back() == ' ' || text.back() == '\t')) {
+        text.remove_suffix(1);
+    }
+    return text;
+}
+
+/**
+ * @brief Parses a qvalue ("0", "0.5", "1.000") into thousandths.
+ * @return 0..1000, or 1000 if the value is malformed (treated as acceptable)
+ */
+static int parseQuality(std::string_view value) {
+    if (value.empty() || (value[0] != '0' && value[0] != '1')) {
+        return 1000;
+    }
+    int quality = (value[0] - '0') * 1000;
+    int scale = 100;
+    for (size_t i = 2; i < value.size() && i < 5 && value[1] == '.'; ++i) {
+        if (value[i] < '0' || value[i] > '9') {
+            return 1000;
+        }
+        quality += (value[i] - '0') * scale;
+        scale /= 10;
+    }
+    return quality > 1000 ? 1000 : quality;
+}
+
+/**
+ * @brief Picks the coding for a response from the request's Accept-Encoding header.
+ * @details Follows RFC 9110 12.5.3: qvalues rank the codings, "q=0" excludes one, "*"
+ *          covers codings not listed. gzip wins ties because more clients decode it.
+ * @param acceptEncoding Header value (empty if absent)
+ * @return Gzip, Deflate, or Identity if neither is acceptable or zlib is unavailable
+ */
+ContentCoding negotiateCoding(std::string_view acceptEncoding) {
+#ifdef WEB_SERVER_ZLIB
+    int gzip = NOT_LISTED;
+    int deflate = NOT_LISTED;
+    int any = NOT_LISTED;
+    while (!acceptEncoding.empty()) {
+        size_t comma = acceptEncoding.find(',');
+        std::string_view element = acceptEncoding.substr(0, comma);
+        acceptEncoding.remove_prefix(comma == std::string_view::npos ? acceptEncoding.size() : comma + 1);
+        size_t semicolon = element.find(';');
+        std::string_view coding = trimView(element.substr(0, semicolon));
+        int quality = 1000;
+        while (semicolon != std::string_view::npos) {
+            element.remove_prefix(semicolon + 1);
+            semicolon = element.find(';');
+            std::string_view parameter = trimView(element.substr(0, semicolon));
+            if (parameter.size() >= 2 && (parameter[0] == 'q' || parameter[0] == 'Q') && parameter[1] == '=') {
+                quality = parseQuality(trimView(parameter.substr(2)));
+            }
+        }
+        if (equalsIgnoreCase(coding, "gzip") || equalsIgnoreCase(coding, "x-gzip")) {
+            gzip = quality;
+        }
+        else if (equalsIgnoreCase(coding, "deflate")) {
+            deflate = quality;
+        }
+        else if (coding == "*") {
+            any = quality;
+        }
+    }
+    gzip = gzip == NOT_LISTED ? any : gzip;
+    deflate = deflate == NOT_LISTED ? any : deflate;
+    if (gzip > 0 && gzip >= deflate) {
+        return ContentCoding::Gzip;
+    }
+    if (deflate > 0) {
+        return ContentCoding::Deflate;
+    }
+#else
+    (void)acceptEncoding;
+#endif
+    return ContentCoding::Identity;
+}
+
+/**
+ * @brief Returns the Content-Encoding token of a coding.
+ * @param coding Coding
+ * @return "gzip", "deflate", or an empty view for Identity
+ */
+std::string_view codingName(ContentCoding coding) {
+    switch (coding) {
+        case ContentCoding::Gzip:
+            return "gzip";
+        case ContentCoding::Deflate:
+            return "deflate";
+        default:
+            return std::string_view();
+    }
+}
+
+/**
+ * @brief Returns true for textual Content-Types; already compressed formats gain nothing.
+ * @param contentType Content-Type header value
+ * @return True if the body should be compressed
+ */
+bool isCompressible(std::string_view contentType) {
+    return contentType.compare(0, 5, "text/") == 0
+        || contentType.find("json") != std::string_view::npos
+        || contentType.find("xml") != std::string_view::npos
+        || contentType.find("javascript") != std::string_view::npos;
+}
+
+/**
+ * @brief Compresses a complete body.
+ * @param input Uncompressed bytes
+ * @param coding Gzip or Deflate
+ * @param level zlib level (1 fastest .. 9 smallest)
+ * @param out Receives the compressed bytes (replaced)
+ * @return True on success
+ */
+bool compressBody(std::string_view input, ContentCoding coding, int level, std::string& out) {
+    out.clear();
+    StreamCompressor compressor(coding, level);
+    return compressor.isOpen() && compressor.write(input, out) && compressor.finish(out);
+}
+
+/**
+ * @brief Starts a zlib stream with the wrapper of the requested coding.
+ * @param coding Gzip or Deflate (Identity leaves the compressor closed)
+ * @param level zlib level
+ */
+StreamCompressor::StreamCompressor(ContentCoding coding, int level) : open(false) {
+#ifdef WEB_SERVER_ZLIB
+    stream = z_stream();
+    if (coding == ContentCoding::Identity) {
+        return;
+    }
+    int windowBits = coding == ContentCoding::Gzip ? GZIP_WINDOW_BITS : ZLIB_WINDOW_BITS;
+    open = deflateInit2(&stream, level, Z_DEFLATED, windowBits, 8, Z_DEFAULT_STRATEGY) == Z_OK;
+#else
+    (void)coding;
+    (void)level;
+#endif
+}
+
+/**
+ * @brief Frees the zlib state if the stream was not finished.
+ */
+StreamCompressor::~StreamCompressor() {
+#ifdef WEB_SERVER_ZLIB
+    if (open) {
+        deflateEnd(&stream);
+    }
+#endif
+}
+
+/**
+ * @brief Compresses a piece of the body.
+ * @param input Uncompressed bytes
+ * @param out Destination, appended to (zlib may hold output back until flush/finish)
+ * @return True on success
+ */
+bool StreamCompressor::write(std::string_view input, std::string& out) {
+#ifdef WEB_SERVER_ZLIB
+    return pump(input, Z_NO_FLUSH, out);
+#else
+    return pump(input, 0, out);
+#endif
+}
+
+/**
+ * @brief Forces out everything written so far (costs a few bytes of ratio).
+ * @param out Destination, appended to
+ * @return True on success
+ */
+bool StreamCompressor::flush(std::string& out) {
+#ifdef WEB_SERVER_ZLIB
+    return pump(std::string_view(), Z_SYNC_FLUSH, out);
+#else
+    return pump(std::string_view(), 0, out);
+#endif
+}
+
+/**
+ * @brief Ends the stream and releases the zlib state.
+ * @param out Destination, appended to
+ * @return True on success
+ */
+bool StreamCompressor::finish(std::string& out) {
+#ifdef WEB_SERVER_ZLIB
+    bool ok = pump(std::string_view(), Z_FINISH, out);
+    if (open) {
+        deflateEnd(&stream);
+        open = false;
+    }
+    return ok;
+#else
+    return pump(std::string_view(), 0, out);
+#endif
+}
+
+/**
+ * @brief Feeds input to deflate() until it is consumed, growing out in OUTPUT_STEP pieces.
+ * @param input Uncompressed bytes
+ * @param mode zlib flush mode
+ * @param out Destination, appended to
+ * @return True on success
+ */
+bool StreamCompressor::pump(std::string_view input, int mode, std::string& out) {
+#ifdef WEB_SERVER_ZLIB
+    if (!open) {
+        return false;
+    }
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input.data()));
+    stream.avail_in = static_cast<uInt>(input.size());
+    while (true) {
+        size_t used = out.size();
+        out.resize(used + OUTPUT_STEP);
+        stream.next_out = reinterpret_cast<Bytef*>(&out[used]);
+        stream.avail_out = static_cast<uInt>(OUTPUT_STEP);
+        int result = deflate(&stream, mode);
+        out.resize(used + OUTPUT_STEP - stream.avail_out);
+        if (result == Z_STREAM_END) {
+            return true;
+        }
+        if (result != Z_OK && result != Z_BUF_ERROR) {
+            return false;
+        }
+        // Done once the input is consumed and deflate() had room to spare
+        if (stream.avail_in == 0 && stream.avail_out != 0 && mode != Z_FINISH) {
+            return true;
+        }
+    }
+#else
+    (void)input;
+    (void)mode;
+    (void)out;
+    return false;
+#endif
+}
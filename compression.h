@@ -0,0 +1,72 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include <cstddef>
+
+// Compression needs zlib; define WEB_SERVER_NO_ZLIB to build without it (bodies are then sent as is)
+#if !defined(WEB_SERVER_NO_ZLIB) && __has_include(<zlib.h>)
+#include <zlib.h>
+#define WEB_SERVER_ZLIB 1
+#endif
+
+/**
+ * @brief Content codings the server can apply to response bodies.
+ */
+enum class ContentCoding : uint8_t {
+    Identity, // Body sent as is
+    Gzip,     // RFC 1952 gzip stream
+    Deflate   // RFC 1950 zlib stream (HTTP "deflate")
+};
+
+static constexpr size_t CODING_COUNT = 3;           // Entries in ContentCoding
+static constexpr size_t MIN_COMPRESS_BYTES = 1024;  // Smaller bodies are sent uncompressed
+static constexpr int STATIC_COMPRESSION_LEVEL = 9;  // zlib level for cached variants (compressed once)
+static constexpr int DYNAMIC_COMPRESSION_LEVEL = 5; // zlib level for per-request bodies
+
+// Picks the best coding the client accepts (Identity without zlib or if nothing better is accepted)
+ContentCoding negotiateCoding(std::string_view acceptEncoding);
+
+// Returns the Content-Encoding token of a coding (empty for Identity)
+std::string_view codingName(ContentCoding coding);
+
+// Returns true if bodies of this Content-Type are worth compressing
+bool isCompressible(std::string_view contentType);
+
+// Compresses input in one pass into out; returns false if zlib is unavailable or fails
+bool compressBody(std::string_view input, ContentCoding coding, int level, std::string& out);
+
+/**
+ * @brief Incremental gzip/deflate encoder for bodies produced piece by piece.
+ * @details Wraps one zlib stream. write() consumes input in place and appends whatever
+ *          output zlib releases, so a body is never copied into a second uncompressed
+ *          buffer and memory stays bounded by the output plus zlib's window.
+ */
+class StreamCompressor {
+public:
+    // Starts a stream for coding (Gzip or Deflate) at the given zlib level
+    StreamCompressor(ContentCoding coding, int level);
+    // Releases the zlib stream
+    ~StreamCompressor();
+
+    StreamCompressor(const StreamCompressor&) = delete;
+    StreamCompressor& operator=(const StreamCompressor&) = delete;
+
+    // Returns false if the stream could not be started
+    bool isOpen() const { return open; }
+    // Compresses input, appending released output to out
+    bool write(std::string_view input, std::string& out);
+    // Flushes pending output so the receiver can decode everything written so far
+    bool flush(std::string& out);
+    // Ends the stream, appending the trailer to out
+    bool finish(std::string& out);
+
+private:
+#ifdef WEB_SERVER_ZLIB
+    z_stream stream; // zlib state
+#endif
+    bool open;       // True once deflateInit2 succeeded and until finish()
+
+    // Runs deflate() with the given flush mode until the input is consumed
+    bool pump(std::string_view input, int mode, std::string& out);
+};
@@ -0,0 +1,269 @@
+#include "conditional.h"
+#include "request.h"
+
+static const char* const DAY_NAMES[7] = { "Thu", "Fri", "Sat", "Sun", "Mon", "Tue", "Wed" }; // Day 0 (1970-01-01) was a Thursday
+static const char* const MONTH_NAMES[12] = { "Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec" };
+static constexpr int64_t SECONDS_PER_DAY = 86400;
+
+/**
+ * @brief Converts a civil date to days since 1970-01-01 (proleptic Gregorian calendar).
+ */
+static int64_t daysFromCivil(int64_t year, unsigned month, unsigned day) {
+    year -= month <= 2 ? 1 : 0;
+    int64_t era = (year >= 0 ? year : year - 399) / 400;
+    unsigned yearOfEra = static_cast<unsigned>(year - era * 400);
+    unsigned dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    unsigned dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return era * 146097 + static_cast<int64_t>(dayOfEra) - 719468;
+}
+
+/**
+ * @brief Converts days since 1970-01-01 to a civil date.
+ */
+static void civilFromDays(int64_t days, int64_t& year, unsigned& month, unsigned& day) {
+    days += 719468;
+    int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+    unsigned dayOfEra = static_cast<unsigned>(days - era * 146097);
+    unsigned yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+    unsigned dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+    unsigned monthIndex = (5 * dayOfYear + 2) / 153;
+    day = dayOfYear - (153 * monthIndex + 2) / 5 + 1;
+    month = monthIndex < 10 ? monthIndex + 3 : monthIndex - 9;
+    year = static_cast<int64_t>(yearOfEra) + era * 400 + (month <= 2 ? 1 : 0);
+}
+
+/**
+ * @brief Appends a number zero-padded to width digits.
+ */
+static void appendPadded(std::string& out, int64_t value, int width) {
+    char digits[20];
+    int length = 0;
+    do {
+        digits[length++] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while (value > 0 && length < 20);
+    for (int i = length; i < width; ++i) {
+        out.push_back('0');
+    }
+    while (length > 0) {
+        out.push_back(digits[--length]);
+    }
+}
+
+/**
+ * @brief Formats a timestamp as an HTTP date.
+ * @details Computed arithmetically, so it needs neither gmtime() nor its locale.
+ * @param seconds Seconds since the epoch (UTC)
+ * @return IMF-fixdate, e.g. "Sun, 06 Nov 1994 08:49:37 GMT"
+ */
+std::string formatHttpDate(int64_t seconds) {
+    int64_t days = seconds >= 0 ? seconds / SECONDS_PER_DAY : (seconds - SECONDS_PER_DAY + 1) / SECONDS_PER_DAY;
+    int64_t secondOfDay = seconds - days * SECONDS_PER_DAY;
+    int64_t year;
+    unsigned month, day;
+    civilFromDays(days, year, month, day);
+    std::string out;
+    out.reserve(29);
+    out.append(DAY_NAMES[((days % 7) + 7) % 7]).append(", ");
+    appendPadded(out, day, 2);
+    out.append(" ").append(MONTH_NAMES[month - 1]).append(" ");
+    appendPadded(out, year, 4);
+    out.push_back(' ');
+    appendPadded(out, secondOfDay / 3600, 2);
+    out.push_back(':');
+    appendPadded(out, secondOfDay / 60 % 60, 2);
+    out.push_back(':');
+    appendPadded(out, secondOfDay % 60, 2);
+    out.append(" GMT");
+    return out;
+}
+
+/**
+ * @brief Reads count decimal digits at text[pos].
+ * @return False if any of them is not a digit
+ */
+static bool readDigits(std::string_view text, size_t pos, size_t count, int64_t& value) {
+    value = 0;
+    for (size_t i = pos; i < pos + count; ++i) {
+        if (text[i] < '0' || text[i] > '9') {
+            return false;
+        }
+        value = value * 10 + (text[i] - '0');
+    }
+    return true;
+}
+
+/**
+ * @brief Parses an HTTP date in the preferred IMF-fixdate format.
+ * @details The obsolete RFC 850 and asctime formats are not accepted; a date that does not
+ *          parse makes its condition be ignored, which is always safe (a full response).
+ * @param text Header value
+ * @param seconds Receives seconds since the epoch
+ * @return True if text is a valid IMF-fixdate
+ */
+bool parseHttpDate(std::string_view text, int64_t& seconds) {
+    // "Sun, 06 Nov 1994 08:49:37 GMT"
+    if (text.size() != 29 || text[3] != ',' || text[4] != ' ' || text[7] != ' ' || text[11] != ' '
+        || text[16] != ' ' || text[19] != ':' || text[22] != ':' || text.substr(25) != " GMT") {
+        return false;
+    }
+    int64_t day, year, hour, minute, second;
+    if (!readDigits(text, 5, 2, day) || !readDigits(text, 12, 4, year) || !readDigits(text, 17, 2, hour)
+        || !readDigits(text, 20, 2, minute) || !readDigits(text, 23, 2, second)) {
+        return false;
+    }
+    unsigned month = 0;
+    for (unsigned i = 0; i < 12; ++i) {
+        if (text.substr(8, 3) == MONTH_NAMES[i]) {
+            month = i + 1;
+        }
+    }
+    if (month == 0 || day < 1 || day > 31 || hour > 23 || minute > 59 || second > 60) {
+        return false;
+    }
+    seconds = daysFromCivil(year, month, static_cast<unsigned>(day)) * SECONDS_PER_DAY + hour * 3600 + minute * 60 + second;
+    return true;
+}
+
+/**
+ * @brief Strips spaces and tabs from both ends of a view.
+ */
+static std::string_view trimList(std::string_view text) {
+    while (!text.empty() && (text.front() == ' ' || text.front() == '\t')) {
+        text.remove_prefix(1);
+    }
+    while (!text.empty() && (text.back() == ' ' || text.back() == '\t')) {
+        text.remove_suffix(1);
+    }
+    return text;
+}
+
+/**
+ * @brief Removes the weakness indicator of an entity-tag.
+ */
+static std::string_view opaqueTag(std::string_view etag) {
+    return etag.substr(0, 2) == "W/" ? etag.substr(2) : etag;
+}
+
+/**
+ * @brief Checks an If-None-Match list against the current entity-tag.
+ * @param list Header value ("*" or comma-separated entity-tags)
+ * @param etag Current entity-tag, quotes included
+ * @return True if any listed tag matches by weak comparison (RFC 9110 section 8.8.3.2)
+ */
+bool etagListMatches(std::string_view list, std::string_view etag) {
+    if (trimList(list) == "*") {
+        return true;
+    }
+    while (!list.empty()) {
+        size_t comma = list.find(',');
+        std::string_view candidate = trimList(list.substr(0, comma));
+        list.remove_prefix(comma == std::string_view::npos ? list.size() : comma + 1);
+        if (!candidate.empty() && opaqueTag(candidate) == opaqueTag(etag)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Compares two entity-tags with the strong comparison function.
+ * @return True if neither is weak and both are identical
+ */
+bool etagStrongMatch(std::string_view a, std::string_view b) {
+    return !a.empty() && a.substr(0, 2) != "W/" && a == b;
+}
+
+/**
+ * @brief Parses a decimal byte position.
+ * @return False if text is empty, not decimal or overflows
+ */
+static bool parsePosition(std::string_view text, uint64_t& value) {
+    if (text.empty()) {
+        return false;
+    }
+    value = 0;
+    for (char c : text) {
+        if (c < '0' || c > '9' || value > (UINT64_MAX - 9) / 10) {
+            return false;
+        }
+        value = value * 10 + static_cast<uint64_t>(c - '0');
+    }
+    return true;
+}
+
+/**
+ * @brief Evaluates a Range header (RFC 9110 section 14.1.2).
+ * @details Ranges that start past the end are dropped, the rest are clipped to the
+ *          representation. A syntax error anywhere, another range unit or more than
+ *          MAX_RANGES ranges make the whole header ignored.
+ * @param header Range header value
+ * @param size Representation length
+ * @return Ignore, Satisfiable (items/count filled) or Unsatisfiable
+ */
+RangeStatus ByteRanges::parse(std::string_view header, uint64_t size) {
+    count = 0;
+    header = trimList(header);
+    if (header.size() < 6 || !equalsIgnoreCase(header.substr(0, 6), "bytes=")) {
+        return RangeStatus::Ignore;
+    }
+    header.remove_prefix(6);
+    size_t listed = 0;
+    while (!header.empty()) {
+        size_t comma = header.find(',');
+        std::string_view spec = trimList(header.substr(0, comma));
+        header.remove_prefix(comma == std::string_view::npos ? header.size() : comma + 1);
+        if (spec.empty()) {
+            continue;
+        }
+        size_t dash = spec.find('-');
+        if (dash == std::string_view::npos || ++listed > MAX_RANGES) {
+            return RangeStatus::Ignore;
+        }
+        uint64_t first, last;
+        if (dash == 0) {
+            // Suffix range: the last N bytes
+            uint64_t suffix;
+            if (!parsePosition(spec.substr(1), suffix)) {
+                return RangeStatus::Ignore;
+            }
+            if (suffix == 0 || size == 0) {
+                continue;
+            }
+            first = suffix < size ? size - suffix : 0;
+            last = size - 1;
+        }
+        else {
+            if (!parsePosition(spec.substr(0, dash), first)) {
+                return RangeStatus::Ignore;
+            }
+            std::string_view end = spec.substr(dash + 1);
+            if (end.empty()) {
+                last = UINT64_MAX;
+            }
+            else if (!parsePosition(end, last) || last < first) {
+                return RangeStatus::Ignore;
+            }
+            if (first >= size) {
+                continue;
+            }
+            last = last < size - 1 ? last : size - 1;
+        }
+        items[count++] = ByteRange{ first, last };
+    }
+    if (listed == 0) {
+        return RangeStatus::Ignore;
+    }
+    return count > 0 ? RangeStatus::Satisfiable : RangeStatus::Unsatisfiable;
+}
+
+/**
+ * @brief Returns the bytes covered by the ranges (overlaps counted twice, as they are sent).
+ */
+uint64_t ByteRanges::total() const {
+    uint64_t bytes = 0;
+    for (size_t i = 0; i < count; ++i) {
+        bytes += items[i].last - items[i].first + 1;
+    }
+    return bytes;
+}
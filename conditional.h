@@ -0,0 +1,50 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <array>
+#include <cstdint>
+#include <cstddef>
+
+// Formats seconds since the epoch as an IMF-fixdate ("Sun, 06 Nov 1994 08:49:37 GMT")
+std::string formatHttpDate(int64_t seconds);
+
+// Parses an IMF-fixdate; returns false for anything else (the condition is then ignored)
+bool parseHttpDate(std::string_view text, int64_t& seconds);
+
+// Returns true if an If-None-Match list names etag (weak comparison, "*" matches anything)
+bool etagListMatches(std::string_view list, std::string_view etag);
+
+// Returns true if two entity-tags are the same strong validator
+bool etagStrongMatch(std::string_view a, std::string_view b);
+
+/**
+ * @brief One satisfiable byte range, both ends inclusive.
+ */
+struct ByteRange {
+    uint64_t first; // First byte offset
+    uint64_t last;  // Last byte offset
+};
+
+/**
+ * @brief Outcome of evaluating a Range header against a representation.
+ */
+enum class RangeStatus {
+    Ignore,       // Not a usable bytes range set: send the full representation (200)
+    Satisfiable,  // At least one range overlaps the representation (206)
+    Unsatisfiable // No range overlaps it (416)
+};
+
+/**
+ * @brief Fixed-capacity list of the satisfiable ranges of a Range header.
+ */
+struct ByteRanges {
+    static constexpr size_t MAX_RANGES = 16; // Longer range sets are ignored (full response)
+
+    std::array<ByteRange, MAX_RANGES> items; // Ranges in request order
+    size_t count = 0;                        // Ranges in use
+
+    // Parses a "bytes=..." Range value against a representation of size bytes
+    RangeStatus parse(std::string_view header, uint64_t size);
+    // Returns the total bytes covered by the ranges
+    uint64_t total() const;
+};
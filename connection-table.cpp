@@ -0,0 +1,127 @@
+#include "connection-table.h"
+#include <new>
+#include <algorithm>
+
+/**
+ * @brief Creates an empty table; chunks are allocated as connections arrive.
+ */
+ConnectionTable::ConnectionTable() : count(0) {}
+
+/**
+ * @brief Destroys the clients still registered.
+ */
+ConnectionTable::~ConnectionTable() {
+    clear();
+}
+
+/**
+ * @brief Constructs a client in the most recently freed slot, or in a new one.
+ * @param s Client socket
+ * @param addr Client address
+ * @param pool Pool the client's input buffer borrows from
+ * @return New client (its timer is keyed by the connection handle), or nullptr if s is registered
+ */
+Client* ConnectionTable::add(SOCKET s, const sockaddr_in& addr, BufferPool* pool) {
+    size_t socketSlot = socketIndex(s);
+    if (socketSlot >= slotBySocket.size()) {
+        slotBySocket.resize((std::max)(socketSlot + 1, slotBySocket.size() * 2), NO_SLOT);
+    }
+    if (slotBySocket[socketSlot] != NO_SLOT) {
+        return nullptr;
+    }
+    uint32_t index;
+    if (!freeSlots.empty()) {
+        index = freeSlots.back();
+        freeSlots.pop_back();
+    }
+    else {
+        index = static_cast<uint32_t>(slots.size());
+        if (index % CHUNK_SIZE == 0) {
+            chunks.emplace_back(new ClientStorage[CHUNK_SIZE]);
+        }
+        slots.push_back(Slot{ INVALID_SOCKET, 1 });
+    }
+    Client* client = new (chunks[index / CHUNK_SIZE][index % CHUNK_SIZE].bytes) Client(s, addr, pool);
+    slots[index].socket = s;
+    slotBySocket[socketSlot] = index;
+    client->timer.key = (static_cast<uint64_t>(slots[index].generation) << 32) | index;
+    count++;
+    return client;
+}
+
+/**
+ * @brief Destroys the client registered for a socket.
+ * @param s Client socket (ignored if not registered)
+ */
+void ConnectionTable::remove(SOCKET s) {
+    uint32_t index = slotOf(s);
+    if (index != NO_SLOT) {
+        slotBySocket[socketIndex(s)] = NO_SLOT;
+        release(index);
+    }
+}
+
+/**
+ * @brief Looks up a client by socket.
+ * @param s Client socket
+ * @return Client, or nullptr if s is not registered
+ */
+Client* ConnectionTable::find(SOCKET s) {
+    uint32_t index = slotOf(s);
+    return index == NO_SLOT ? nullptr : at(index);
+}
+
+/**
+ * @brief Resolves a handle issued by add().
+ * @param handle Generation in the high 32 bits, slot index in the low 32 bits
+ * @return Client, or nullptr if the connection it was issued for has been removed
+ */
+Client* ConnectionTable::get(uint64_t handle) {
+    uint32_t index = static_cast<uint32_t>(handle);
+    if (index >= slots.size() || slots[index].socket == INVALID_SOCKET
+        || slots[index].generation != static_cast<uint32_t>(handle >> 32)) {
+        return nullptr;
+    }
+    return at(index);
+}
+
+/**
+ * @brief Destroys every client and frees all slots (storage chunks are kept).
+ */
+void ConnectionTable::clear() {
+    for (uint32_t index = 0; index < slots.size(); ++index) {
+        if (slots[index].socket != INVALID_SOCKET) {
+            slotBySocket[socketIndex(slots[index].socket)] = NO_SLOT;
+            release(index);
+        }
+    }
+}
+
+/**
+ * @brief Returns the client constructed in a slot.
+ */
+Client* ConnectionTable::at(uint32_t index) {
+    return std::launder(reinterpret_cast<Client*>(chunks[index / CHUNK_SIZE][index % CHUNK_SIZE].bytes));
+}
+
+/**
+ * @brief Returns the slot registered for a socket, or NO_SLOT.
+ */
+uint32_t ConnectionTable::slotOf(SOCKET s) const {
+    size_t socketSlot = socketIndex(s);
+    return socketSlot < slotBySocket.size() ? slotBySocket[socketSlot] : NO_SLOT;
+}
+
+/**
+ * @brief Destroys a slot's client and pushes the slot onto the free list.
+ * @details The generation is bumped (skipping 0) so handles to the old client stop resolving.
+ */
+void ConnectionTable::release(uint32_t index) {
+    at(index)->~Client();
+    slots[index].socket = INVALID_SOCKET;
+    if (++slots[index].generation == 0) {
+        slots[index].generation = 1;
+    }
+    freeSlots.push_back(index);
+    count--;
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+#include "client.h"
+
+/**
+ * @brief Slot table owning a reactor's clients.
+ * @details Clients are constructed in place in fixed-size chunks, so their addresses never
+ *          change and neighbouring connections share pages. A compact slot array holds the
+ *          descriptor and generation of every slot, freed slots are reused LIFO (still warm in
+ *          cache), and a descriptor-indexed array maps sockets to slots, so adding, finding
+ *          and removing a client are O(1) without a per-connection node allocation.
+ *          Handles combine the slot with its generation, so a handle kept by a timer or an
+ *          in-flight operation stops resolving once its connection is removed.
+ */
+class ConnectionTable {
+public:
+    static constexpr uint32_t CHUNK_SIZE = 256;      // Clients per storage chunk
+    static constexpr uint32_t NO_SLOT = UINT32_MAX;  // Marks an unused descriptor index
+
+    ConnectionTable();
+    // Destroys the remaining clients (their sockets are not closed)
+    ~ConnectionTable();
+
+    ConnectionTable(const ConnectionTable&) = delete;
+    ConnectionTable& operator=(const ConnectionTable&) = delete;
+
+    // Creates the client for s in a free slot; nullptr if s is already registered
+    Client* add(SOCKET s, const sockaddr_in& addr, BufferPool* pool);
+    // Destroys the client for s and frees its slot
+    void remove(SOCKET s);
+    // Returns the client registered for s, or nullptr
+    Client* find(SOCKET s);
+    // Returns the client a handle was issued for, or nullptr if it has been removed
+    Client* get(uint64_t handle);
+    // Destroys every client (their sockets are not closed)
+    void clear();
+
+    // Returns the number of clients
+    size_t size() const { return count; }
+    // Returns true if there are no clients
+    bool empty() const { return count == 0; }
+
+    // Calls fn(Client&) for every client, in slot order
+    template <typename Fn>
+    void forEach(Fn fn) {
+        for (uint32_t index = 0; index < slots.size(); ++index) {
+            if (slots[index].socket != INVALID_SOCKET) {
+                fn(*at(index));
+            }
+        }
+    }
+
+private:
+    // Per-slot bookkeeping scanned by lookups and iteration
+    struct Slot {
+        SOCKET socket;       // Owner descriptor, INVALID_SOCKET when free
+        uint32_t generation; // Bumped on every removal, never 0 for a live slot
+    };
+
+    // Raw storage for one Client
+    struct alignas(Client) ClientStorage {
+        unsigned char bytes[sizeof(Client)];
+    };
+
+    std::vector<Slot> slots;                             // One entry per slot
+    std::vector<uint32_t> freeSlots;                     // Free slot indices, reused last-in first-out
+    std::vector<uint32_t> slotBySocket;                  // Slot per socketIndex(), NO_SLOT if unused
+    std::vector<std::unique_ptr<ClientStorage[]>> chunks; // Client storage, CHUNK_SIZE slots each
+    size_t count;                                        // Live clients
+
+    // Returns the client stored in slot index
+    Client* at(uint32_t index);
+    // Returns the slot for s, or NO_SLOT
+    uint32_t slotOf(SOCKET s) const;
+    // Destroys the client in slot index and frees the slot
+    void release(uint32_t index);
+};
@@ -0,0 +1,432 @@
+#include "content-cache.h"
+#include "http-utils.h"
+#include "utils.h"
+#include "conditional.h"
+#include "blocking-pool.h"
+#include <atomic>
+#include <fstream>
+#include <cstdio>
+#ifdef __linux__
+#include <sys/inotify.h>
+#endif
+
+static constexpr size_t DEFAULT_BUDGET = 64 * 1024 * 1024; // Cached bytes per reactor
+static constexpr size_t MAX_ENTRY_BYTES = 1024 * 1024;     // Larger files are streamed from disk
+
+static std::atomic<size_t> defaultBudget(DEFAULT_BUDGET);
+
+/**
+ * @brief Builds the lookup key for a (path, lang) pair.
+ */
+static std::string makeKey(std::string_view path, std::string_view lang) {
+    std::string key;
+    key.reserve(path.size() + lang.size() + 1);
+    key.append(path).append(1, '\0').append(lang);
+    return key;
+}
+
+/**
+ * @brief Returns the part of a file name before its first dot ("index.fr.html" -> "index").
+ */
+static std::string baseNameOf(const std::string& fileName) {
+    size_t start = fileName.find_last_of("\\/");
+    start = start == std::string::npos ? 0 : start + 1;
+    return fileName.substr(start, fileName.find('.', start) - start);
+}
+
+/**
+ * @brief Returns the bytes an entry is charged against the budget.
+ * @details Includes bookkeeping so that many keys resolving to large (uncached) files
+ *          or arbitrary lang values cannot grow the cache without bound.
+ */
+static size_t entryCost(const std::string& key, const CachedContent& entry) {
+    size_t cost = sizeof(CachedContent) + 64 + key.size() * 2 + entry.filePath.size() + entry.precompressedPath.size();
+    for (size_t i = 0; i < CODING_COUNT; ++i) {
+        cost += entry.headerBlocks[i].size() + entry.etags[i].size() + (entry.encoded[i] ? entry.encoded[i]->size() : 0);
+    }
+    return cost + (entry.bytes ? entry.bytes->size() : 0);
+}
+
+/**
+ * @brief Reads a whole file into out.
+ * @return True if the file could be read
+ */
+static bool readFile(const std::string& filePath, std::string& out) {
+    std::ifstream infile(filePath, std::ios::binary | std::ios::ate);
+    if (!infile.good()) {
+        return false;
+    }
+    out.resize(static_cast<size_t>(infile.tellg()));
+    infile.seekg(0);
+    infile.read(&out[0], static_cast<std::streamsize>(out.size()));
+    out.resize(static_cast<size_t>(infile.gcount()));
+    return true;
+}
+
+/**
+ * @brief Builds a compressed variant of a file's contents.
+ * @details A precompressed "<file>.gz" is used as the gzip variant as is; otherwise the
+ *          contents are compressed at STATIC_COMPRESSION_LEVEL. Touches no cache state, so the
+ *          I/O pool can run it.
+ * @param contents File contents
+ * @param precompressedPath "<file>.gz" to read instead of compressing, empty if none
+ * @param coding Gzip or Deflate
+ * @return Variant, or null if it could not be built or would not be smaller than the original
+ */
+static std::shared_ptr<const std::string> buildVariant(const std::string& contents, const std::string& precompressedPath, ContentCoding coding) {
+    auto encoded = std::make_shared<std::string>();
+    bool built = !precompressedPath.empty()
+        ? readFile(precompressedPath, *encoded)
+        : compressBody(contents, coding, STATIC_COMPRESSION_LEVEL, *encoded);
+    if (!built || encoded->size() >= contents.size()) {
+        return nullptr;
+    }
+    encoded->shrink_to_fit();
+    return encoded;
+}
+
+/**
+ * @brief Creates an empty cache and starts watching the content directory.
+ * @param byteBudget Maximum bytes of cached file contents (0 disables caching)
+ * @param maxEntryBytes Largest file whose contents are kept in memory
+ */
+ContentCache::ContentCache(size_t byteBudget, size_t maxEntryBytes)
+    : budget(byteBudget), maxEntry(maxEntryBytes), used(0), watchFd(-1), generation(0), completions(nullptr) {
+#ifdef __linux__
+    if (budget == 0) {
+        return;
+    }
+    watchFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (watchFd == -1) {
+        logError("Error at inotify_init1()", errno);
+        return;
+    }
+    uint32_t mask = IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_MODIFY | IN_ATTRIB | IN_DELETE_SELF | IN_MOVE_SELF;
+    if (inotify_add_watch(watchFd, CONTENT_DIR, mask) == -1) {
+        logError("Error at inotify_add_watch()", errno);
+        ::close(watchFd);
+        watchFd = -1;
+    }
+#endif
+}
+
+/**
+ * @brief Closes the watch descriptor.
+ */
+ContentCache::~ContentCache() {
+#ifdef __linux__
+    if (watchFd != -1) {
+        ::close(watchFd);
+    }
+#endif
+}
+
+/**
+ * @brief Returns the calling thread's cache.
+ * @details Every reactor runs on its own thread, so each one gets a private cache.
+ */
+ContentCache& ContentCache::local() {
+    static thread_local ContentCache cache(defaultBudget.load(std::memory_order_relaxed), MAX_ENTRY_BYTES);
+    return cache;
+}
+
+/**
+ * @brief Sets the byte budget for caches created afterwards.
+ * @param byteBudget Budget in bytes, 0 disables caching
+ */
+void ContentCache::setDefaultBudget(size_t byteBudget) {
+    defaultBudget.store(byteBudget, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Returns the cached entry for (path, lang), loading it on a miss.
+ * @details The compressed variant for coding is built here the first time it is asked for,
+ *          so each file is compressed once per reactor rather than once per request.
+ * @param path Request path
+ * @param lang Requested language (may be empty)
+ * @param coding Coding the caller will serve if a variant exists
+ * @return Entry, or null if no file matches
+ */
+std::shared_ptr<const CachedContent> ContentCache::lookup(std::string_view path, std::string_view lang, ContentCoding coding) {
+    std::shared_ptr<const CachedContent> entry = find(path, lang, coding);
+    if (entry) {
+        return entry;
+    }
+    return insert(path, lang, load(path, lang, memoryLimit()), generation, coding);
+}
+
+/**
+ * @brief Returns the cached entry for (path, lang) without loading it.
+ * @details Used by the reactor when misses are loaded on the blocking I/O pool.
+ * @param path Request path
+ * @param lang Requested language (may be empty)
+ * @param coding Coding the caller will serve if a variant exists
+ * @return Entry, or null on a miss or when caching is disabled
+ */
+std::shared_ptr<const CachedContent> ContentCache::find(std::string_view path, std::string_view lang, ContentCoding coding) {
+    if (budget == 0) {
+        return nullptr;
+    }
+    auto it = index.find(makeKey(path, lang));
+    if (it == index.end()) {
+        return nullptr;
+    }
+    lru.splice(lru.begin(), lru, it->second);
+    std::shared_ptr<const CachedContent> entry = it->second->second;
+    if (coding != ContentCoding::Identity && !entry->encodeTried[static_cast<size_t>(coding)]) {
+        used += encode(it->first, entry, coding);
+        evict();
+    }
+    return entry;
+}
+
+/**
+ * @brief Caches a freshly loaded entry.
+ * @details An entry loaded on another thread is only kept if nothing was invalidated while it
+ *          was being read; otherwise it may describe a file that has changed since, and it is
+ *          served once without being cached.
+ * @param path Request path
+ * @param lang Requested language (may be empty)
+ * @param entry Loaded entry (null if no file matched)
+ * @param epoch epoch() when the load started
+ * @param coding Coding the caller will serve if a variant exists
+ * @return entry
+ */
+std::shared_ptr<const CachedContent> ContentCache::insert(std::string_view path, std::string_view lang,
+    std::shared_ptr<const CachedContent> entry, uint64_t epoch, ContentCoding coding) {
+    if (!entry || budget == 0 || epoch != generation) {
+        return entry;
+    }
+    std::string key = makeKey(path, lang);
+    auto it = index.find(key);
+    if (it != index.end()) {
+        erase(it->second); // Loaded twice by overlapping misses; the newer load wins
+    }
+    lru.emplace_front(std::move(key), entry);
+    index.emplace(lru.front().first, lru.begin());
+    used += entryCost(lru.front().first, *entry);
+    if (coding != ContentCoding::Identity) {
+        used += encode(lru.front().first, entry, coding);
+    }
+    evict();
+    return entry;
+}
+
+/**
+ * @brief Resolves (path, lang) and reads the file if it fits the memory limit.
+ * @details Only reads the disk, so the blocking I/O pool can run it for a reactor's cache.
+ * @param path Request path
+ * @param lang Requested language (may be empty)
+ * @param memoryLimit Largest file whose contents are read into the entry (0 = none)
+ * @return New entry, or null if no file matches
+ */
+std::shared_ptr<const CachedContent> ContentCache::load(std::string_view path, std::string_view lang, size_t memoryLimit) {
+    std::string filePath = resolveFilePath(std::string(path), std::string(lang));
+    if (filePath.empty()) {
+        return nullptr;
+    }
+    std::ifstream infile(filePath, std::ios::binary | std::ios::ate);
+    if (!infile.good()) {
+        return nullptr;
+    }
+    auto entry = std::make_shared<CachedContent>();
+    entry->filePath = filePath;
+    entry->baseName = baseNameOf(filePath);
+    entry->contentType = getContentType(filePath);
+    entry->size = static_cast<uint64_t>(infile.tellg());
+    if (isCompressible(entry->contentType)) {
+        std::ifstream precompressed(filePath + ".gz", std::ios::binary | std::ios::ate);
+        if (precompressed.good()) {
+            entry->precompressedPath = filePath + ".gz";
+            entry->precompressedSize = static_cast<uint64_t>(precompressed.tellg());
+        }
+        entry->compressible = entry->size >= MIN_COMPRESS_BYTES || !entry->precompressedPath.empty();
+    }
+    // Validators: the entity-tag changes with the modification time (ns) or the size
+    int64_t modifiedNs = 0;
+    fileModified(filePath, modifiedNs);
+    entry->modified = modifiedNs >= 0 ? modifiedNs / 1000000000 : 0;
+    entry->lastModified = formatHttpDate(entry->modified);
+    char tag[48];
+    std::snprintf(tag, sizeof(tag), "%llx-%llx", static_cast<unsigned long long>(modifiedNs), static_cast<unsigned long long>(entry->size));
+    for (size_t i = 0; i < CODING_COUNT; ++i) {
+        ContentCoding coding = static_cast<ContentCoding>(i);
+        entry->etags[i].append("\"").append(tag);
+        if (coding != ContentCoding::Identity) {
+            entry->etags[i].append("-").append(codingName(coding));
+        }
+        entry->etags[i].append("\"");
+        std::string& block = entry->headerBlocks[i];
+        block = "Content-Type: " + entry->contentType + "\r\n";
+        if (entry->compressible) {
+            block += "Vary: Accept-Encoding\r\n";
+        }
+        if (coding != ContentCoding::Identity) {
+            block.append("Content-Encoding: ").append(codingName(coding)).append("\r\n");
+        }
+        block.append("ETag: ").append(entry->etags[i]).append("\r\n");
+        block.append("Last-Modified: ").append(entry->lastModified).append("\r\n");
+        block.append("Accept-Ranges: bytes\r\n");
+    }
+    if (memoryLimit > 0 && entry->size <= memoryLimit) {
+        auto bytes = std::make_shared<std::string>(static_cast<size_t>(entry->size), '\0');
+        infile.seekg(0);
+        infile.read(&(*bytes)[0], static_cast<std::streamsize>(bytes->size()));
+        bytes->resize(static_cast<size_t>(infile.gcount()));
+        entry->size = bytes->size();
+        entry->bytes = std::move(bytes);
+    }
+    return entry;
+}
+
+/**
+ * @brief Drops every entry resolved to a file named baseName.*.
+ * @details A change to any variant (e.g. index.fr.html) can change which file a key resolves to,
+ *          so all keys sharing the base name are dropped.
+ * @param baseName File base name without extension or language
+ */
+void ContentCache::invalidate(const std::string& baseName) {
+    generation++;
+    for (auto it = lru.begin(); it != lru.end();) {
+        auto next = std::next(it);
+        if (it->second->baseName == baseName) {
+            erase(it);
+        }
+        it = next;
+    }
+}
+
+/**
+ * @brief Drops every entry.
+ */
+void ContentCache::clear() {
+    generation++;
+    index.clear();
+    lru.clear();
+    used = 0;
+}
+
+/**
+ * @brief Returns the inotify descriptor, or -1 if changes are not watched.
+ */
+int ContentCache::watchHandle() const {
+    return watchFd;
+}
+
+/**
+ * @brief Drains the inotify descriptor and invalidates entries for every changed file.
+ * @details A queue overflow or loss of the watched directory drops the whole cache.
+ */
+void ContentCache::processEvents() {
+#ifdef __linux__
+    if (watchFd == -1) {
+        return;
+    }
+    alignas(inotify_event) char buffer[4096];
+    while (true) {
+        ssize_t length = ::read(watchFd, buffer, sizeof(buffer));
+        if (length <= 0) {
+            return;
+        }
+        for (ssize_t pos = 0; pos < length;) {
+            const inotify_event* event = reinterpret_cast<const inotify_event*>(buffer + pos);
+            if (event->mask & (IN_Q_OVERFLOW | IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED)) {
+                clear();
+            }
+            else if (event->len > 0) {
+                invalidate(baseNameOf(event->name));
+            }
+            pos += sizeof(inotify_event) + event->len;
+        }
+    }
+#endif
+}
+
+/**
+ * @brief Returns the bytes charged to cached entries (contents plus bookkeeping).
+ */
+size_t ContentCache::bytesUsed() const {
+    return used;
+}
+
+/**
+ * @brief Returns the number of cached entries.
+ */
+size_t ContentCache::entryCount() const {
+    return index.size();
+}
+
+/**
+ * @brief Builds the compressed variant of an entry held in memory.
+ * @details With the I/O pool on, reading "<file>.gz" or compressing up to maxEntry bytes is
+ *          handed to it and the variant is attached once it is back; requests are served the
+ *          identity body meanwhile. Either way a variant is only tried once per entry.
+ * @param key Key the entry is cached under
+ * @param entry Cached entry
+ * @param coding Gzip or Deflate
+ * @return Bytes added to the entry's cost (0 while the variant is built on the pool)
+ */
+size_t ContentCache::encode(const std::string& key, const std::shared_ptr<const CachedContent>& entry, ContentCoding coding) {
+    size_t slot = static_cast<size_t>(coding);
+    entry->encodeTried[slot] = true;
+    if (!entry->compressible || !entry->bytes) {
+        return 0;
+    }
+    std::string precompressedPath = coding == ContentCoding::Gzip && entry->precompressedSize <= maxEntry
+        ? entry->precompressedPath : std::string();
+    if (completions == nullptr) {
+        entry->encoded[slot] = buildVariant(*entry->bytes, precompressedPath, coding);
+        return entry->encoded[slot] ? entry->encoded[slot]->size() : 0;
+    }
+    // The pool thread only sees copies and the immutable contents, never the entry's variants
+    auto variant = std::make_shared<std::shared_ptr<const std::string>>();
+    std::shared_ptr<const std::string> bytes = entry->bytes;
+    std::shared_ptr<BlockingJob> job = std::make_shared<BlockingJob>();
+    job->work = [variant, bytes, precompressedPath, coding]() {
+        *variant = buildVariant(*bytes, precompressedPath, coding);
+    };
+    job->complete = [this, key, entry, variant, coding]() {
+        attach(key, entry, coding, std::move(*variant));
+    };
+    job->completions = completions;
+    BlockingPool::submit(std::move(job));
+    return 0;
+}
+
+/**
+ * @brief Stores a variant the I/O pool built.
+ * @details Dropped if the entry was evicted or invalidated meanwhile: a replacement entry
+ *          builds its own variants.
+ * @param key Key the entry was cached under
+ * @param entry Entry the variant was built for
+ * @param coding Gzip or Deflate
+ * @param variant Built variant, null if it was not worth keeping
+ */
+void ContentCache::attach(const std::string& key, const std::shared_ptr<const CachedContent>& entry, ContentCoding coding,
+    std::shared_ptr<const std::string> variant) {
+    auto it = index.find(key);
+    if (!variant || it == index.end() || it->second->second != entry) {
+        return;
+    }
+    used += variant->size();
+    entry->encoded[static_cast<size_t>(coding)] = std::move(variant);
+    evict();
+}
+
+/**
+ * @brief Removes one entry; in-flight responses keep their bytes alive through the shared pointer.
+ */
+void ContentCache::erase(std::list<Entry>::iterator it) {
+    used -= entryCost(it->first, *it->second);
+    index.erase(it->first);
+    lru.erase(it);
+}
+
+/**
+ * @brief Evicts least-recently-used entries until the cached bytes fit the budget.
+ */
+void ContentCache::evict() {
+    while (used > budget && !lru.empty()) {
+        erase(std::prev(lru.end()));
+    }
+}
@@ -0,0 +1,118 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <array>
+#include <cstdint>
+#include "compression.h"
+
+class CompletionQueue;
+
+/**
+ * @brief A resolved static file as served by GET/HEAD.
+ * @details Compressed variants are built on the first request that accepts them (on the I/O
+ *          pool when there is one, serving the identity body until they are back) and then
+ *          live as long as the entry. Only the owning reactor thread touches an entry, so
+ *          filling them in through a const pointer needs no locking.
+ */
+struct CachedContent {
+    std::string filePath;                     // File the (path, lang) pair resolved to
+    std::string baseName;                     // Base name used for invalidation (e.g. "index")
+    std::string contentType;                  // Content-Type header value
+    std::array<std::string, CODING_COUNT> headerBlocks; // Pre-serialized entity headers per coding ("Content-Type: ...\r\n")
+    uint64_t size = 0;                        // File size in bytes
+    std::shared_ptr<const std::string> bytes; // File contents, null if too large to keep in memory
+    bool compressible = false;                // Textual and large enough to be worth compressing
+    std::string precompressedPath;            // "<file>.gz" shipped next to the file, empty if none
+    uint64_t precompressedSize = 0;           // Size of precompressedPath
+    std::array<std::string, CODING_COUNT> etags; // Strong entity-tag per coding, quotes included
+    std::string lastModified;                 // Last-Modified header value (HTTP date)
+    int64_t modified = 0;                     // Modification time in seconds since the epoch
+    mutable std::array<std::shared_ptr<const std::string>, CODING_COUNT> encoded; // Compressed bodies (Identity unused)
+    mutable std::array<bool, CODING_COUNT> encodeTried{};                           // Variant already built or found not worth it
+};
+
+/**
+ * @brief Per-reactor cache of resolved static content keyed by (path, lang).
+ * @details Saves the probing opens of resolveFilePath() and the open/read of the winning file
+ *          on hot paths. Entries are evicted least-recently-used once the byte budget is
+ *          exceeded; files larger than the per-entry limit keep only their resolution and are
+ *          still streamed from disk. On Linux an inotify watch on CONTENT_DIR invalidates
+ *          entries when files change behind the server's back; PUT/DELETE invalidate directly.
+ *          Each reactor thread owns its own instance, so no locking is needed.
+ */
+class ContentCache {
+public:
+    // Creates a cache with the given budgets and starts watching CONTENT_DIR (Linux)
+    ContentCache(size_t byteBudget, size_t maxEntryBytes);
+    // Closes the watch descriptor
+    ~ContentCache();
+
+    ContentCache(const ContentCache&) = delete;
+    ContentCache& operator=(const ContentCache&) = delete;
+
+    // Returns the calling thread's cache, created with the default budget on first use
+    static ContentCache& local();
+    // Sets the byte budget used by caches created afterwards (0 disables caching)
+    static void setDefaultBudget(size_t byteBudget);
+
+    // Returns the entry for (path, lang), resolving and loading it on a miss and building the
+    // variant for coding if it is missing; null if not found
+    std::shared_ptr<const CachedContent> lookup(std::string_view path, std::string_view lang,
+        ContentCoding coding = ContentCoding::Identity);
+    // Returns the cached entry for (path, lang) without touching the disk (building the coding
+    // variant if it is missing); null on a miss or when caching is disabled
+    std::shared_ptr<const CachedContent> find(std::string_view path, std::string_view lang,
+        ContentCoding coding = ContentCoding::Identity);
+    // Caches an entry loaded off the reactor thread unless the cache changed since epoch; returns entry
+    std::shared_ptr<const CachedContent> insert(std::string_view path, std::string_view lang,
+        std::shared_ptr<const CachedContent> entry, uint64_t epoch, ContentCoding coding = ContentCoding::Identity);
+    // Resolves and reads (path, lang), keeping contents up to memoryLimit bytes; null if no file
+    // matches. Touches no cache state, so it may run on any thread.
+    static std::shared_ptr<const CachedContent> load(std::string_view path, std::string_view lang, size_t memoryLimit);
+    // Returns the largest file load() should keep in memory for this cache (0 when caching is disabled)
+    size_t memoryLimit() const { return budget > 0 ? maxEntry : 0; }
+    // Returns a counter bumped by every invalidation, to detect loads that raced with one
+    uint64_t epoch() const { return generation; }
+    // Builds compressed variants on the I/O pool and hands them back through queue (null builds them inline)
+    void setCompletions(CompletionQueue* queue) { completions = queue; }
+    // Drops every entry whose resolution may depend on files named baseName.*
+    void invalidate(const std::string& baseName);
+    // Drops every entry
+    void clear();
+
+    // Returns the inotify descriptor to poll for readability, or -1 if there is none
+    int watchHandle() const;
+    // Reads pending inotify events and invalidates the affected entries
+    void processEvents();
+
+    // Returns the bytes charged to cached entries (contents plus bookkeeping)
+    size_t bytesUsed() const;
+    // Returns the number of cached entries
+    size_t entryCount() const;
+
+private:
+    using Entry = std::pair<std::string, std::shared_ptr<const CachedContent>>;
+
+    std::list<Entry> lru;                                          // Most recently used first
+    std::unordered_map<std::string, std::list<Entry>::iterator> index; // Key -> position in lru
+    size_t budget;                                                 // Maximum bytes of cached contents
+    size_t maxEntry;                                               // Largest file kept in memory
+    size_t used;                                                   // Bytes charged to cached entries
+    int watchFd;                                                   // inotify descriptor, -1 if none
+    uint64_t generation;                                           // Bumped by invalidate() and clear()
+    CompletionQueue* completions;                                  // Reactor queue of variants built on the I/O pool, null if none
+
+    // Builds the compressed variant of the entry cached under key, or queues it on the I/O pool;
+    // returns the bytes it added
+    size_t encode(const std::string& key, const std::shared_ptr<const CachedContent>& entry, ContentCoding coding);
+    // Stores a variant built on the I/O pool if the entry is still the one cached under key
+    void attach(const std::string& key, const std::shared_ptr<const CachedContent>& entry, ContentCoding coding,
+        std::shared_ptr<const std::string> variant);
+    // Removes one entry and releases its bytes
+    void erase(std::list<Entry>::iterator it);
+    // Evicts least-recently-used entries until the budget holds
+    void evict();
+};
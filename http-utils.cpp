@@ -1,55 +1,333 @@
 ﻿#include "http-utils.h"
 #include "response.h"
+#include "content-cache.h"
+#include "compression.h"
+#include "conditional.h"
+#include "metrics.h"
+#include "blocking-pool.h"
+#include <atomic>
+#include <cstdio>
+#include <cerrno>
+#include <charconv>
+#include <array>
+
+static constexpr size_t STREAM_READ_BYTES = 64 * 1024; // File bytes read per multipart piece
+static constexpr uint64_t MAX_DELAY_MS = 10 * 1000;     // Longest delay GET /delay/:ms accepts
 
 /**
- * @brief Handles GET requests for files with language support and /health endpoint.
- * @param request HTTP request
- * @return HTTP response
+ * @brief Returns the coding a static entry is actually served with.
+ * @details The negotiated coding is used only if its variant exists: a cached compressed body
+ *          for in-memory files, or a precompressed "<file>.gz" for files streamed from disk.
+ * @param content Cached entry
+ * @param coding Coding negotiated from Accept-Encoding
+ * @return coding, or Identity
  */
-Response handleGet(const Request& request) {
-    if (request.path == "/health") {
-        return health();
+static ContentCoding servedCoding(const CachedContent& content, ContentCoding coding) {
+    if (coding == ContentCoding::Identity) {
+        return coding;
     }
-    std::string lang = request.getQparams("lang");
-    std::string filePath = resolveFilePath(request.path, lang);
-    if (filePath.empty()) {
-        return handleNotFound(request.path);
+    if (content.bytes) {
+        return content.encoded[static_cast<size_t>(coding)] ? coding : ContentCoding::Identity;
     }
-    std::ifstream infile(filePath, std::ios::binary);
-    if (!infile.good()) {
-        return handleNotFound(filePath);
+    return coding == ContentCoding::Gzip && !content.precompressedPath.empty() ? coding : ContentCoding::Identity;
+}
+
+/**
+ * @brief Builds the header lines a 304 carries in place of the entity headers.
+ * @param content Cached entry
+ * @param coding Coding the stored copy was served with
+ * @return ETag, Last-Modified and Vary lines
+ */
+static std::string validatorHeaders(const CachedContent& content, ContentCoding coding) {
+    std::string block;
+    block.append("ETag: ").append(content.etags[static_cast<size_t>(coding)]).append("\r\n");
+    block.append("Last-Modified: ").append(content.lastModified).append("\r\n");
+    if (content.compressible) {
+        block.append("Vary: Accept-Encoding\r\n");
+    }
+    return block;
+}
+
+/**
+ * @brief Evaluates If-None-Match and If-Modified-Since (RFC 9110 section 13.2.2).
+ * @details If-Modified-Since is only consulted when If-None-Match is absent; a date that
+ *          does not parse leaves the condition unevaluated.
+ * @param request GET or HEAD request
+ * @param content Cached entry
+ * @param coding Coding that would be served
+ * @return True if the client's stored copy is still current (304)
+ */
+static bool isNotModified(const Request& request, const CachedContent& content, ContentCoding coding) {
+    std::string_view noneMatch = request.headers.get("If-None-Match");
+    if (!noneMatch.empty()) {
+        return etagListMatches(noneMatch, content.etags[static_cast<size_t>(coding)]);
+    }
+    int64_t since;
+    std::string_view modifiedSince = request.headers.get("If-Modified-Since");
+    return !modifiedSince.empty() && parseHttpDate(modifiedSince, since) && content.modified <= since;
+}
+
+/**
+ * @brief Evaluates If-Range: a range request only applies to the representation the client holds.
+ * @return True if there is no If-Range or it still matches the identity representation
+ */
+static bool ifRangeHolds(const Request& request, const CachedContent& content) {
+    std::string_view ifRange = request.headers.get("If-Range");
+    if (ifRange.empty()) {
+        return true;
     }
-    std::ostringstream ss;
-    ss << infile.rdbuf();
-    infile.close();
+    if (ifRange.front() == '"' || ifRange.substr(0, 2) == "W/") {
+        return etagStrongMatch(ifRange, content.etags[static_cast<size_t>(ContentCoding::Identity)]);
+    }
+    int64_t date;
+    return parseHttpDate(ifRange, date) && date == content.modified;
+}
 
-    Response response = Response::ok(ss.str());
-    // Set content type based on extension
-    if (filePath.size() >= 5 && filePath.substr(filePath.size() - 5) == ".html") {
-        response.headers["Content-Type"] = "text/html";
-    } else {
-        response.headers["Content-Type"] = "text/plain";
+/**
+ * @brief Returns a multipart/byteranges boundary unlikely to occur in any served file.
+ */
+static std::string makeBoundary() {
+    static std::atomic<uint64_t> boundaryCounter(0);
+    char boundary[40];
+    std::snprintf(boundary, sizeof(boundary), "web-server-%016llx",
+        static_cast<unsigned long long>((boundaryCounter.fetch_add(1, std::memory_order_relaxed) + 1) * 0x9E3779B97F4A7C15ull));
+    return boundary;
+}
+
+/**
+ * @brief Appends the delimiter and headers that open one part of a multipart/byteranges body.
+ */
+static void appendPartHead(std::string& out, const std::string& boundary, const std::string& contentType, const ByteRange& range, uint64_t size) {
+    out.append("\r\n--").append(boundary).append("\r\n");
+    out.append("Content-Type: ").append(contentType).append("\r\n");
+    out.append("Content-Range: bytes ").append(std::to_string(range.first)).append("-").append(std::to_string(range.last));
+    out.append("/").append(std::to_string(size)).append("\r\n\r\n");
+}
+
+/**
+ * @brief Builds the 206 response for a satisfiable Range header.
+ * @details One range is sent as the plain slice with a Content-Range header: from the cached
+ *          bytes, or straight from the file with sendfile() starting at the range offset.
+ *          Several ranges become a multipart/byteranges body; for files on disk it is produced
+ *          piece by piece, so only one read buffer per connection is ever held.
+ * @param content Cached entry (identity representation)
+ * @param file Open file when the entry is not held in memory, null otherwise
+ * @param ranges Satisfiable ranges
+ * @param size Representation length the ranges were evaluated against
+ * @return 206 Partial Content response
+ */
+static Response partialContent(const CachedContent& content, std::shared_ptr<FileHandle> file, const ByteRanges& ranges, uint64_t size) {
+    Response response;
+    const std::string& headerBlock = content.headerBlocks[static_cast<size_t>(ContentCoding::Identity)];
+    if (ranges.count == 1) {
+        const ByteRange& range = ranges.items[0];
+        uint64_t length = range.last - range.first + 1;
+        if (file) {
+            response = Response::fromFile(std::move(file), headerBlock);
+            response.fileOffset = range.first;
+        }
+        else {
+            response.rawHeaders = headerBlock;
+            response.body = content.bytes->substr(static_cast<size_t>(range.first), static_cast<size_t>(length));
+        }
+        response.bodyLength = static_cast<size_t>(length);
+        response.headers["Content-Range"] = "bytes " + std::to_string(range.first) + "-" + std::to_string(range.last) + "/" + std::to_string(size);
+    }
+    else {
+        std::string boundary = makeBoundary();
+        response.rawHeaders = validatorHeaders(content, ContentCoding::Identity) + "Accept-Ranges: bytes\r\n";
+        response.headers["Content-Type"] = "multipart/byteranges; boundary=" + boundary;
+        if (file) {
+            // Parts are read from the file as the connection drains (chunked transfer coding)
+            struct PartCursor {
+                size_t index = 0;     // Range being sent
+                uint64_t offset = 0;  // Next byte of it
+                bool started = false; // Part head of this range already written
+            };
+            auto cursor = std::make_shared<PartCursor>();
+            std::string contentType = content.contentType;
+            response.stream = [file, ranges, size, boundary, contentType, cursor](std::string& out) {
+                if (cursor->index == ranges.count) {
+                    out.append("\r\n--").append(boundary).append("--\r\n");
+                    return false;
+                }
+                const ByteRange& range = ranges.items[cursor->index];
+                if (!cursor->started) {
+                    appendPartHead(out, boundary, contentType, range, size);
+                    cursor->offset = range.first;
+                    cursor->started = true;
+                }
+                size_t piece = static_cast<size_t>(std::min<uint64_t>(range.last - cursor->offset + 1, STREAM_READ_BYTES));
+                size_t used = out.size();
+                out.resize(used + piece);
+                long long bytesRead = readAt(*file, cursor->offset, &out[used], piece);
+                if (bytesRead <= 0) {
+                    out.resize(used); // File shrank or failed: end the body, the client sees it incomplete
+                    return false;
+                }
+                out.resize(used + static_cast<size_t>(bytesRead));
+                cursor->offset += static_cast<uint64_t>(bytesRead);
+                if (cursor->offset > range.last) {
+                    cursor->index++;
+                    cursor->started = false;
+                }
+                return true;
+            };
+        }
+        else {
+            for (size_t i = 0; i < ranges.count; ++i) {
+                const ByteRange& range = ranges.items[i];
+                appendPartHead(response.body, boundary, content.contentType, range, size);
+                response.body.append(*content.bytes, static_cast<size_t>(range.first), static_cast<size_t>(range.last - range.first + 1));
+            }
+            response.body.append("\r\n--").append(boundary).append("--\r\n");
+            response.bodyLength = response.body.size();
+        }
     }
-    response.bodyLength = response.body.size();
+    response.statusCode = 206;
+    response.statusMessage = "Partial Content";
     return response;
 }
 
 /**
- * @brief Handles POST requests. Only supports /echo endpoint.
+ * @brief Serves a resolved static file for GET or HEAD.
+ * @details Answers from the cache entry's validators when the client's copy is current (304,
+ *          the file is not even opened) and honors Range/If-Range on GET. A range request is
+ *          served from the identity representation; otherwise Accept-Encoding picks the
+ *          entry's cached gzip/deflate variant.
+ * @param request HTTP request
+ * @param withBody False for HEAD
+ * @param content Cache entry, null if no file matched
+ * @param coding Coding negotiated from Accept-Encoding (Identity for range requests)
+ * @return HTTP response
+ */
+static Response serveContent(const Request& request, bool withBody, std::shared_ptr<const CachedContent> content, ContentCoding coding) {
+    std::string_view rangeHeader = withBody ? request.headers.get("Range") : std::string_view();
+    if (!content) {
+        return withBody ? handleNotFound(std::string(request.path)) : Response::notFound();
+    }
+    coding = servedCoding(*content, coding);
+    if (isNotModified(request, *content, coding)) {
+        return Response::notModified(validatorHeaders(*content, coding));
+    }
+    const std::string& headerBlock = content->headerBlocks[static_cast<size_t>(coding)];
+    if (!withBody) {
+        // Same representation GET would send, so Content-Length matches it
+        Response response;
+        response.rawHeaders = headerBlock;
+        if (coding == ContentCoding::Identity) {
+            response.bodyLength = static_cast<size_t>(content->size); // Correct content length, no body for HEAD
+        }
+        else {
+            response.bodyLength = content->bytes ? content->encoded[static_cast<size_t>(coding)]->size() : static_cast<size_t>(content->precompressedSize);
+        }
+        return response;
+    }
+    bool ranged = !rangeHeader.empty() && ifRangeHolds(request, *content);
+    if (content->bytes && !ranged) {
+        return Response::fromCache(coding == ContentCoding::Identity ? content->bytes : content->encoded[static_cast<size_t>(coding)], headerBlock);
+    }
+    std::shared_ptr<FileHandle> file;
+    uint64_t size = content->bytes ? content->bytes->size() : 0;
+    if (!content->bytes) {
+        // Too large to keep in memory: the body is streamed from the open file by the send path
+        file = std::make_shared<FileHandle>(coding == ContentCoding::Identity ? content->filePath : content->precompressedPath);
+        if (!file->isOpen()) {
+            return handleNotFound(content->filePath);
+        }
+        size = file->size();
+    }
+    if (ranged) {
+        ByteRanges ranges;
+        RangeStatus status = ranges.parse(rangeHeader, size);
+        if (status == RangeStatus::Unsatisfiable) {
+            return Response::rangeNotSatisfiable(size);
+        }
+        // Heavily overlapping range sets are ignored rather than amplified; a multipart body
+        // streamed from disk needs chunked transfer coding, which HTTP/1.0 lacks
+        bool usable = status == RangeStatus::Satisfiable
+            && (ranges.count == 1 || (ranges.total() <= size && (!file || request.version == "HTTP/1.1")));
+        if (usable) {
+            return partialContent(*content, std::move(file), ranges, size);
+        }
+    }
+    if (!file) {
+        return Response::fromCache(content->bytes, headerBlock);
+    }
+    return Response::fromFile(file, headerBlock);
+}
+
+/**
+ * @brief Serves a static file for GET or HEAD.
+ * @details A cache hit is answered right away. On a miss, resolving and reading the file is
+ *          handed to the blocking I/O pool when there is one; the entry is cached and served
+ *          once it is back on the reactor thread.
+ * @param request HTTP request
+ * @param withBody False for HEAD
+ * @return HTTP response, or a deferred one
+ */
+static Response serveStatic(const Request& request, bool withBody) {
+    ContentCoding coding = withBody && !request.headers.get("Range").empty()
+        ? ContentCoding::Identity : negotiateCoding(request.headers.get("Accept-Encoding"));
+    ContentCache& cache = ContentCache::local();
+    std::string_view lang = request.getQparams("lang");
+    if (!BlockingPool::enabled()) {
+        return serveContent(request, withBody, cache.lookup(request.path, lang, coding), coding);
+    }
+    std::shared_ptr<const CachedContent> content = cache.find(request.path, lang, coding);
+    if (content) {
+        return serveContent(request, withBody, std::move(content), coding);
+    }
+    auto loaded = std::make_shared<std::shared_ptr<const CachedContent>>();
+    std::string path(request.path);
+    std::string language(lang);
+    size_t memoryLimit = cache.memoryLimit();
+    uint64_t epoch = cache.epoch();
+    return Response::deferred(
+        [loaded, path, language, memoryLimit]() {
+            *loaded = ContentCache::load(path, language, memoryLimit);
+        },
+        [loaded, path, language, epoch, withBody, coding](const Request& request) {
+            return serveContent(request, withBody, ContentCache::local().insert(path, language, *loaded, epoch, coding), coding);
+        });
+}
+
+/**
+ * @brief Handles GET requests for files with language support.
+ * @details Honors Accept-Encoding with the entry's cached gzip/deflate variant, conditional
+ *          requests and byte ranges.
+ * @param request HTTP request
+ * @return HTTP response
+ */
+Response handleGet(const Request& request) {
+    return serveStatic(request, true);
+}
+
+/**
+ * @brief Handles POST /echo by echoing the body.
  * @param request HTTP request
  * @return HTTP response
  */
 Response handlePost(const Request& request) {
     // Validate Content-Type
-    auto ctIt = request.headers.find("Content-Type");
-    if (ctIt == request.headers.end() || ctIt->second != "text/plain") {
+    if (request.headers.get("Content-Type") != "text/plain") {
         return handleBadRequest("Unsupported Content-Type for POST. Only text/plain allowed.");
     }
-    if (request.path != "/echo") {
-        return handleBadRequest("POST only supported on /echo");
-    }
     std::cout << "[POST] Received body: \"" << request.body << "\"\n";
-    return Response::ok(request.body);
+    ContentCoding coding = negotiateCoding(request.headers.get("Accept-Encoding"));
+    if (coding == ContentCoding::Identity || request.body.size() < MIN_COMPRESS_BYTES) {
+        return Response::ok(std::string(request.body));
+    }
+    // Compressed straight from the connection buffer; the body is never copied uncompressed
+    Response response = Response::ok();
+    StreamCompressor compressor(coding, DYNAMIC_COMPRESSION_LEVEL);
+    if (!compressor.write(request.body, response.body) || !compressor.finish(response.body)) {
+        return Response::ok(std::string(request.body));
+    }
+    response.bodyLength = response.body.size();
+    response.headers["Content-Encoding"] = std::string(codingName(coding));
+    response.headers["Vary"] = "Accept-Encoding";
+    return response;
 }
 
 /**
@@ -58,45 +336,152 @@ Response handlePost(const Request& request) {
  * @return HTTP response with headers only
  */
 Response handleHead(const Request& request) {
-    std::string lang = request.getQparams("lang");
-    std::string filePath = resolveFilePath(request.path, lang);
-    if (filePath.empty()) {
-        return Response::notFound();
+    return serveStatic(request, false);
+}
+
+/**
+ * @brief Moves a completely written upload into place without touching the content cache.
+ * @param upload Upload whose body has been written
+ * @return 201 Created for a new file, 200 OK for a replaced one, 500 if the rename failed
+ */
+static Response commitPut(FileUpload& upload) {
+    bool replaced = false;
+    std::string fileName = upload.target().substr(upload.target().find_last_of("\\/") + 1);
+    if (!upload.commit(replaced)) {
+        return handleInternalError("Error writing file: " + upload.target());
     }
-    std::ifstream infile(filePath, std::ios::binary | std::ios::ate);
-    if (!infile.good()) {
-        return Response::notFound();
+    if (replaced) {
+        return handleOk(fileName);
+    } else {
+        return handleCreated(fileName);
     }
-    size_t fileSize = infile.tellg();
-    infile.close();
+}
 
-    Response response = Response::ok("");
-    // Set content type based on extension
-    if (filePath.size() >= 5 && filePath.substr(filePath.size() - 5) == ".html") {
-        response.headers["Content-Type"] = "text/html";
-    } else {
-        response.headers["Content-Type"] = "text/plain";
+/**
+ * @brief Writes a whole body to a new upload and moves it into place.
+ * @details Touches only the disk, so it may run on the blocking I/O pool.
+ * @param target Path of the file to write
+ * @param baseName Base name of the file
+ * @param data Body bytes
+ * @param length Number of body bytes
+ * @return 201 Created, 200 OK or 500 Internal Server Error
+ */
+static Response storeFile(const std::string& target, const std::string& baseName, const char* data, size_t length) {
+    FileUpload upload(target, baseName);
+    if (!upload.isOpen()) {
+        return handleInternalError("Could not open file for writing: " + upload.target());
     }
-    response.body.clear(); // No body for HEAD
-    response.bodyLength = fileSize; // Set correct content length for header
-    return response;
+    if (!upload.write(data, length)) {
+        return handleInternalError("Error writing file: " + upload.target());
+    }
+    return commitPut(upload);
 }
 
 /**
- * @brief Handles PUT requests by writing the request body to a file. Extension is taken from the path.
+ * @brief Handles PUT requests whose body is fully buffered. Extension is taken from the path.
+ * @details Bodies still arriving are streamed by the server through beginPut()/completePut().
+ *          With a blocking I/O pool the file is written there from a copy of the body, since
+ *          the connection buffer may move while the job runs.
  * @param request HTTP request
- * @return HTTP response
+ * @return HTTP response, or a deferred one
  */
 Response handlePut(const Request& request) {
+    Response error = validatePut(request);
+    if (error.statusCode != 200) {
+        return error;
+    }
+    std::string baseName, extension;
+    isValidPutPath(request.path, baseName, extension);
+    std::string target = CONTENT_DIR + baseName + extension;
+    if (!BlockingPool::enabled()) {
+        Response response = storeFile(target, baseName, request.body.data(), request.body.size());
+        ContentCache::local().invalidate(baseName);
+        return response;
+    }
+    auto body = std::make_shared<std::string>(request.body);
+    auto result = std::make_shared<Response>();
+    return Response::deferred(
+        [body, result, target, baseName]() {
+            *result = storeFile(target, baseName, body->data(), body->size());
+        },
+        [result, baseName](const Request&) {
+            ContentCache::local().invalidate(baseName);
+            return std::move(*result);
+        });
+}
+
+/**
+ * @brief Validates a PUT request's head and creates the temporary file its body goes to.
+ * @param request HTTP request (only the request line and headers are used)
+ * @param upload Receives the open upload
+ * @param error Receives the response to send when the request is rejected
+ * @return True if the body should be written to upload
+ */
+bool beginPut(const Request& request, std::unique_ptr<FileUpload>& upload, Response& error) {
+    error = validatePut(request);
+    if (error.statusCode != 200) {
+        return false;
+    }
+    std::string baseName, extension;
+    isValidPutPath(request.path, baseName, extension);
+    upload = std::make_unique<FileUpload>(CONTENT_DIR + baseName + extension, baseName);
+    if (!upload->isOpen()) {
+        error = handleInternalError("Could not open file for writing: " + upload->target());
+        upload.reset();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Moves a completely written upload into place.
+ * @param upload Upload whose body has been written
+ * @return 201 Created for a new file, 200 OK for a replaced one, 500 if the rename failed
+ */
+Response finishPut(FileUpload& upload) {
+    Response response = commitPut(upload);
+    ContentCache::local().invalidate(upload.name());
+    return response;
+}
+
+/**
+ * @brief Moves a streamed upload into place, on the blocking I/O pool when there is one.
+ * @param upload Upload whose body has been written
+ * @return 201 Created, 200 OK or 500, or a deferred response
+ */
+Response completePut(std::unique_ptr<FileUpload> upload) {
+    if (!BlockingPool::enabled()) {
+        return finishPut(*upload);
+    }
+    std::shared_ptr<FileUpload> written(std::move(upload));
+    auto result = std::make_shared<Response>();
+    Response response = Response::deferred(
+        [written, result]() {
+            *result = commitPut(*written);
+        },
+        [written, result](const Request&) {
+            ContentCache::local().invalidate(written->name());
+            return std::move(*result);
+        });
+    response.job->headReleased = true; // The head was dropped while the body streamed in
+    return response;
+}
+
+/**
+ * @brief Checks the path, extension and Content-Type of a PUT request.
+ * @param request HTTP request (headers only)
+ * @return 200 OK if the request may be written, otherwise the 400 response to send
+ */
+Response validatePut(const Request& request) {
     // Validate Content-Type
-    auto ctIt = request.headers.find("Content-Type");
-    if (ctIt == request.headers.end()) {
+    const Header* contentTypeHeader = request.headers.find("Content-Type");
+    if (contentTypeHeader == nullptr) {
         return handleBadRequest("Missing Content-Type for PUT.");
     }
-    std::string contentType = ctIt->second;
+    std::string_view contentType = contentTypeHeader->value;
     std::string baseName, extension;
     if (!isValidPutPath(request.path, baseName, extension)) {
-        return handleBadRequest("Invalid or missing path for PUT: " + request.path);
+        return handleBadRequest("Invalid or missing path for PUT: " + std::string(request.path));
     }
     // Validate extension and Content-Type match
     if (extension == ".txt" && contentType != "text/plain") {
@@ -113,39 +498,40 @@ Response handlePut(const Request& request) {
             return handleBadRequest("PUT not allowed for index* or about* html files.");
         }
     }
-    std::string filePath = "C:\\temp\\" + baseName + extension;
-    bool fileExists = false;
-    {
-        std::ifstream infile(filePath);
-        fileExists = infile.good();
-    }
-    try {
-        std::ofstream outfile(filePath, std::ios::trunc);
-        if (!outfile.is_open()) {
-            return handleBadRequest("Could not open file for writing: " + filePath);
-        }
-        outfile << request.body;
-        outfile.close();
-    } catch (...) {
-        return handleInternalError("Error writing file: " + filePath);
-    }
+    return Response();
+}
+
+/**
+ * @brief Deletes a content file.
+ * @details Touches only the disk, so it may run on the blocking I/O pool. The file is not probed
+ *          first: with deletes of the same file running concurrently on pool threads, only the
+ *          outcome of remove() itself tells a missing file (404) from a failure (500).
+ * @param filePath File to delete
+ * @param removed Set to true if the file was deleted
+ * @return 200 OK, 404 Not Found or 500 Internal Server Error
+ */
+static Response removeFile(const std::string& filePath, bool& removed) {
     std::string fileName = filePath.substr(filePath.find_last_of("\\/") + 1);
-    if (fileExists) {
+    removed = std::remove(filePath.c_str()) == 0;
+    if (removed) {
         return handleOk(fileName);
-    } else {
-        return handleCreated(fileName);
     }
+    if (errno == ENOENT) {
+        return handleNotFound(filePath);
+    }
+    return handleInternalError("Error deleting file: " + fileName);
 }
 
 /**
  * @brief Handles DELETE requests by deleting the file. Extension is taken from the path.
+ * @details With a blocking I/O pool the file is probed and removed there.
  * @param request HTTP request
- * @return HTTP response
+ * @return HTTP response, or a deferred one
  */
 Response handleDelete(const Request& request) {
     std::string baseName, extension;
     if (!isValidPutPath(request.path, baseName, extension)) {
-        return handleBadRequest("Invalid or missing path for DELETE: " + request.path);
+        return handleBadRequest("Invalid or missing path for DELETE: " + std::string(request.path));
     }
     // Block index*/about* for .html files
     std::string lowerBase = baseName;
@@ -153,18 +539,86 @@ Response handleDelete(const Request& request) {
     if (extension == ".html" && (lowerBase.find("index") == 0 || lowerBase.find("about") == 0)) {
         return handleBadRequest("DELETE not allowed for index* or about* html files.");
     }
-    std::string filePath = "C:\\temp\\" + baseName + extension;
-    std::ifstream infile(filePath);
-    if (!infile.good()) {
-        return handleNotFound(filePath);
-    }
-    infile.close();
-    std::string fileName = filePath.substr(filePath.find_last_of("\\/") + 1);
-    if (std::remove(filePath.c_str()) == 0) {
-        return handleOk(fileName);
-    } else {
-        return handleInternalError("Error deleting file: " + fileName);
+    std::string filePath = CONTENT_DIR + baseName + extension;
+    if (!BlockingPool::enabled()) {
+        bool removed = false;
+        Response response = removeFile(filePath, removed);
+        if (removed) {
+            ContentCache::local().invalidate(baseName);
+        }
+        return response;
+    }
+    auto removed = std::make_shared<bool>(false);
+    auto result = std::make_shared<Response>();
+    return Response::deferred(
+        [filePath, removed, result]() {
+            *result = removeFile(filePath, *removed);
+        },
+        [baseName, removed, result](const Request&) {
+            if (*removed) {
+                ContentCache::local().invalidate(baseName);
+            }
+            return std::move(*result);
+        });
+}
+
+/**
+ * @brief Handles GET /delay/:ms by answering after the given number of milliseconds.
+ * @details A coroutine handler: the reactor goes on serving other connections while it sleeps.
+ * @param request HTTP request (params holds "ms")
+ * @return 200 OK once the delay is over, 400 for a delay that is not 0 to MAX_DELAY_MS
+ */
+Task<Response> handleDelay(Request& request) {
+    std::string_view value = request.params.get("ms");
+    uint64_t delayMs = 0;
+    auto [end, error] = std::from_chars(value.data(), value.data() + value.size(), delayMs);
+    if (value.empty() || error != std::errc() || end != value.data() + value.size() || delayMs > MAX_DELAY_MS) {
+        co_return handleBadRequest("Delay must be 0 to " + std::to_string(MAX_DELAY_MS) + " ms: " + std::string(value));
+    }
+    co_await sleepFor(delayMs);
+    co_return Response::ok("Delayed " + std::to_string(delayMs) + " ms");
+}
+
+/**
+ * @brief Feeds bytes to a CRC-32 (IEEE 802.3, reflected) computed with a 256-entry table.
+ * @param crc Running value (start with 0xFFFFFFFF, invert at the end)
+ * @param data Bytes to add
+ * @return Updated running value
+ */
+static uint32_t updateCrc32(uint32_t crc, std::string_view data) {
+    static const std::array<uint32_t, 256> TABLE = [] {
+        std::array<uint32_t, 256> table{};
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t value = i;
+            for (int bit = 0; bit < 8; ++bit) {
+                value = (value & 1) ? 0xEDB88320u ^ (value >> 1) : value >> 1;
+            }
+            table[i] = value;
+        }
+        return table;
+    }();
+    for (unsigned char c : data) {
+        crc = TABLE[(crc ^ c) & 0xFF] ^ (crc >> 8);
     }
+    return crc;
+}
+
+/**
+ * @brief Handles POST /crc32 by returning the CRC-32 and length of the request body.
+ * @details A coroutine handler that reads the body piece by piece as it arrives, so a body of
+ *          any accepted size is checked without being buffered.
+ * @return 200 OK with "crc32-hex length"
+ */
+Task<Response> handleCrc32(Request&) {
+    uint32_t crc = 0xFFFFFFFFu;
+    uint64_t length = 0;
+    for (std::string_view chunk = co_await nextBodyChunk(); !chunk.empty(); chunk = co_await nextBodyChunk()) {
+        crc = updateCrc32(crc, chunk);
+        length += chunk.size();
+    }
+    char hex[9];
+    std::snprintf(hex, sizeof(hex), "%08x", crc ^ 0xFFFFFFFFu);
+    co_return Response::ok(std::string(hex) + " " + std::to_string(length) + "\n");
 }
 
 /**
@@ -173,12 +627,9 @@ Response handleDelete(const Request& request) {
  * @return HTTP response
  */
 Response handleTrace(const Request& request) {
-    if (request.path != "/trace") {
-        return handleBadRequest(request.path);
-    }
     std::ostringstream ss;
     for (const auto& header : request.headers) {
-        ss << header.first << ": " << header.second << "\r\n";
+        ss << header.name << ": " << header.value << "\r\n";
     }
     ss << "\r\n" << request.body;
     Response response = Response::ok(ss.str());
@@ -209,6 +660,18 @@ Response health() {
     return response;
 }
 
+/**
+ * @brief Handles GET /metrics endpoint.
+ * @details Renders from counters the reactors publish without locking, so a scrape costs
+ *          the serving reactor a few microseconds and never waits on the others.
+ * @return Prometheus text exposition
+ */
+Response handleMetrics() {
+    Response response = Response::ok(renderMetrics());
+    response.headers["Content-Type"] = "text/plain; version=0.0.4; charset=utf-8";
+    return response;
+}
+
 /**
  * @brief Resolves the file path for static HTML or text serving based on path and language.
  * @param path Request path
@@ -226,7 +689,7 @@ std::string resolveFilePath(const std::string& path, const std::string& lang) {
         extension = ".html";
     }
 
-    std::string dir = "C:\\temp\\";
+    std::string dir = CONTENT_DIR;
     std::string filePath;
 
     // If extension is present, use it directly
@@ -314,56 +777,15 @@ Response handleInternalError(const std::string& context) {
 }
 
 /**
- * @brief Extracts Content-Length value from HTTP headers, or returns 0 if not found or invalid.
- * @param rawHeaders Raw HTTP headers string
- * @return Content-Length value
+ * @brief Returns the Content-Type served for a file, based on its extension.
+ * @param filePath Resolved file path
+ * @return "text/html" for .html files, "text/plain" otherwise
  */
-size_t getContentLength(const std::string& rawHeaders) {
-    std::istringstream stream(rawHeaders);
-    std::string line;
-
-    while (std::getline(stream, line)) {
-        if (!line.empty() && line.back() == '\r') {
-            line.pop_back();
-        }
-
-        std::string lowerLine = line;
-        std::transform(lowerLine.begin(), lowerLine.end(), lowerLine.begin(), ::tolower);
-
-        if (lowerLine.rfind("content-length:", 0) == 0) {
-            size_t colonPos = line.find(':');
-            if (colonPos != std::string::npos) {
-                std::string clVal = line.substr(colonPos + 1);
-                clVal.erase(std::remove_if(clVal.begin(), clVal.end(), ::isspace), clVal.end());
-                try {
-                    return std::stoul(clVal);
-                }
-                catch (...) {
-                    return 0;
-                }
-            }
-        }
+std::string getContentType(const std::string& filePath) {
+    if (filePath.size() >= 5 && filePath.compare(filePath.size() - 5, 5, ".html") == 0) {
+        return "text/html";
     }
-    return 0;
-}
-
-/**
- * @brief Checks if the HTTP request in buffer is complete (headers and body).
- * @param buffer Raw HTTP request buffer
- * @return True if request is complete, false otherwise
- */
-bool isRequestComplete(const std::string& buffer) {
-    size_t headerEnd = buffer.find("\r\n\r\n");
-    if (headerEnd == std::string::npos) {
-        return false;
-    }
-    size_t contentLength = getContentLength(buffer.substr(0, headerEnd));
-    size_t bodyStart = headerEnd + 4;
-    size_t bodyLen = buffer.size() - bodyStart;
-    if ((contentLength == 0 && bodyLen == 0) || (contentLength > 0 && bodyLen >= contentLength)) {
-        return true;
-    }
-    return false;
+    return "text/plain";
 }
 
 /**
@@ -372,16 +794,12 @@ bool isRequestComplete(const std::string& buffer) {
  * @return True if keep-alive, false otherwise
  */
 bool isKeepAlive(const Request& request) {
-    auto connIt = request.headers.find("Connection");
-    if (connIt != request.headers.end()) {
-        std::string connVal = connIt->second;
-        std::transform(connVal.begin(), connVal.end(), connVal.begin(), ::tolower);
-        if (connVal == "keep-alive") {
-            return true;
-        }
-        if (connVal == "close") {
-            return false;
-        }
+    std::string_view connection = request.headers.get("Connection");
+    if (equalsIgnoreCase(connection, "keep-alive")) {
+        return true;
+    }
+    if (equalsIgnoreCase(connection, "close")) {
+        return false;
     }
     // Default to HTTP/1.1 keep-alive, HTTP/1.0 close
     return request.version == "HTTP/1.1";
@@ -1,6 +1,11 @@
 #pragma once
 #include "response.h"
 #include "request.h"
+#include "platform.h"
+#include "utils.h"
+#include "upload.h"
+#include "task.h"
+#include "async-handler.h"
 #include <string>
 #include <fstream>
 #include <sstream>
@@ -8,7 +13,7 @@
 #include <iostream>
 #include <vector>
 
-// Handles GET requests by dispatching to the appropriate handler based on the path.
+// Handles GET requests for static files (/health is routed separately).
 Response handleGet(const Request& request);
 
 // Handles HEAD requests by fetching the HTML file and returning headers only.
@@ -17,30 +22,47 @@ Response handleHead(const Request& request);
 // Handles PUT requests. Stores body in file derived from path, returns appropriate response.
 Response handlePut(const Request& request);
 
+// Checks a PUT request's path, extension and Content-Type; returns 200 OK or the 400 response.
+Response validatePut(const Request& request);
+
+// Validates a PUT head and opens the temporary file for its body; on false, error holds the response.
+bool beginPut(const Request& request, std::unique_ptr<FileUpload>& upload, Response& error);
+
+// Renames a fully written upload into place and returns 201 Created or 200 OK.
+Response finishPut(FileUpload& upload);
+// Renames a streamed upload into place, deferred to the blocking I/O pool when there is one.
+Response completePut(std::unique_ptr<FileUpload> upload);
+
 // Handles POST requests. Echoes body and prints to console.
 Response handlePost(const Request& request);
 
 // Handles DELETE requests. Deletes the .txt file derived from the path.
 Response handleDelete(const Request& request);
 
+// Coroutine handler for GET /delay/:ms. Answers after sleeping on the reactor's timer wheel.
+Task<Response> handleDelay(Request& request);
+
+// Coroutine handler for POST /crc32. Returns the CRC-32 and length of the body, read as it arrives.
+Task<Response> handleCrc32(Request& request);
+
 // Handles TRACE requests. Currently not supported, returns 400 Bad Request.
 Response handleTrace(const Request& request);
 
 // Handles GET /health endpoint. Returns a plain text health check response.
 Response health();
 
+// Handles GET /metrics. Returns every reactor's counters in the Prometheus text format.
+Response handleMetrics();
+
 // Resolves the file path for static HTML serving based on path and language.
 std::string resolveFilePath(const std::string& path, const std::string& lang);
 
-// Checks if the HTTP request in buffer is complete (headers and body).
-bool isRequestComplete(const std::string& buffer);
+// Returns the Content-Type served for a resolved file ("text/html" or "text/plain").
+std::string getContentType(const std::string& filePath);
 
 // Checks if the connection should be kept alive based on headers and HTTP version.
 bool isKeepAlive(const Request& request);
 
-// Extracts Content-Length value from HTTP headers, or returns 0 if not found or invalid.
-size_t getContentLength(const std::string& rawHeaders);
-
 // Returns a 404 Not Found response with a context-aware message.
 Response handleNotFound(const std::string& context);
 
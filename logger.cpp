@@ -0,0 +1,283 @@
+#include "logger.h"
+#include "platform.h"
+#include <ctime>
+#include <cstdio>
+#include <cmath>
+#include <algorithm>
+
+// Level each category is recorded at
+static constexpr LogLevel CATEGORY_LEVEL[] = { LogLevel::Error, LogLevel::Info, LogLevel::Debug, LogLevel::Debug };
+
+static constexpr int WRITER_BATCH = 4096;                          // Records written between flushes
+static constexpr std::chrono::milliseconds WRITER_IDLE_SLEEP(5);   // Writer back-off when the ring is empty
+
+/**
+ * @brief Returns the process-wide logger.
+ */
+Logger& Logger::instance() {
+    static Logger logger;
+    return logger;
+}
+
+/**
+ * @brief Initializes the ring and starts the writer thread.
+ */
+Logger::Logger()
+    : cells(new Cell[RING_SIZE]), enqueuePos(0), dequeuePos(0), droppedCount(0),
+      minLevel(static_cast<int>(LogLevel::Debug)), running(true), reportedDrops(0) {
+    for (size_t i = 0; i < RING_SIZE; ++i) {
+        cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    for (auto& every : sampleEvery) {
+        every.store(1, std::memory_order_relaxed);
+    }
+    writer = std::thread(&Logger::writerLoop, this);
+}
+
+/**
+ * @brief Stops the writer; it drains the ring before exiting.
+ */
+Logger::~Logger() {
+    running.store(false, std::memory_order_release);
+    if (writer.joinable()) {
+        writer.join();
+    }
+}
+
+/**
+ * @brief Sets the minimum level that is recorded.
+ * @param level Minimum level, LogLevel::Off disables logging
+ */
+void Logger::setLevel(LogLevel level) {
+    minLevel.store(static_cast<int>(level), std::memory_order_relaxed);
+}
+
+/**
+ * @brief Sets the fraction of records of a category that are kept.
+ * @param category Record category
+ * @param rate Fraction in (0, 1]; values <= 0 keep nothing
+ */
+void Logger::setSampleRate(LogCategory category, double rate) {
+    uint32_t every = rate <= 0.0 ? 0 : static_cast<uint32_t>(std::lround(1.0 / (std::min)(rate, 1.0)));
+    sampleEvery[static_cast<int>(category)].store(every, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Checks whether a category's level is currently recorded.
+ * @param category Record category
+ * @return True if records of this category pass the level filter
+ */
+bool Logger::isEnabled(LogCategory category) const {
+    return static_cast<int>(CATEGORY_LEVEL[static_cast<int>(category)]) >= minLevel.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Decides whether the next record of a category is wanted.
+ * @details Checks the level and applies 1-in-N sampling with a per-thread counter, so callers
+ *          can skip building payload strings entirely.
+ * @param category Record category
+ * @return True if the record should be submitted
+ */
+bool Logger::shouldLog(LogCategory category) {
+    int index = static_cast<int>(category);
+    if (!isEnabled(category)) {
+        return false;
+    }
+    uint32_t every = sampleEvery[index].load(std::memory_order_relaxed);
+    if (every <= 1) {
+        return every == 1;
+    }
+    static thread_local uint32_t counters[static_cast<int>(LogCategory::Count)] = {};
+    return ++counters[index] % every == 0;
+}
+
+/**
+ * @brief Pushes a record into the ring without blocking.
+ * @param record Record to move into the ring
+ * @return True if queued, false if the ring was full (the drop is counted)
+ */
+bool Logger::submit(LogRecord&& record) {
+    size_t pos = enqueuePos.load(std::memory_order_relaxed);
+    Cell* cell;
+    while (true) {
+        cell = &cells[pos & (RING_SIZE - 1)];
+        size_t seq = cell->sequence.load(std::memory_order_acquire);
+        intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+        if (diff == 0) {
+            if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        }
+        else if (diff < 0) {
+            droppedCount.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        else {
+            pos = enqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+    cell->record = std::move(record);
+    cell->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+}
+
+/**
+ * @brief Returns the number of records dropped because the ring was full.
+ */
+uint64_t Logger::dropped() const {
+    return droppedCount.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Pops the oldest record (writer thread only).
+ * @param record Output record
+ * @return True if a record was popped, false if the ring is empty
+ */
+bool Logger::tryPop(LogRecord& record) {
+    size_t pos = dequeuePos.load(std::memory_order_relaxed);
+    Cell* cell = &cells[pos & (RING_SIZE - 1)];
+    size_t seq = cell->sequence.load(std::memory_order_acquire);
+    if (static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1) < 0) {
+        return false;
+    }
+    dequeuePos.store(pos + 1, std::memory_order_relaxed);
+    record = std::move(cell->record);
+    cell->record.text.clear();
+    cell->sequence.store(pos + RING_SIZE, std::memory_order_release);
+    return true;
+}
+
+/**
+ * @brief Writer loop: drains the ring in batches and flushes every touched file once per batch.
+ */
+void Logger::writerLoop() {
+    LogRecord record;
+    while (true) {
+        bool stopping = !running.load(std::memory_order_acquire);
+        int written = 0;
+        while (written < WRITER_BATCH && tryPop(record)) {
+            write(record);
+            written++;
+        }
+        uint64_t drops = dropped();
+        if (drops != reportedDrops) {
+            LogRecord note;
+            note.path = "log/web-server-error.log";
+            note.text = "[] Logger ring full, " + std::to_string(drops - reportedDrops) + " records dropped\n";
+            note.timestampPos = 1;
+            note.time = std::chrono::system_clock::now();
+            write(note);
+            reportedDrops = drops;
+        }
+        if (written > 0) {
+            for (auto& kv : files) {
+                kv.second.flush();
+            }
+            continue;
+        }
+        if (stopping) {
+            return;
+        }
+        std::this_thread::sleep_for(WRITER_IDLE_SLEEP);
+    }
+}
+
+/**
+ * @brief Renders a timestamp as YYYY-MM-DD HH:MM:SS.mmm.
+ * @details The seconds part is cached, so strftime runs at most once per second.
+ */
+static void formatTimestamp(std::chrono::system_clock::time_point time, std::string& out) {
+    using namespace std::chrono;
+    static std::time_t cachedSecond = -1;
+    static char cachedText[32];
+    std::time_t now_c = system_clock::to_time_t(time);
+    if (now_c != cachedSecond) {
+        tm timeInfo;
+#ifdef _WIN32
+        localtime_s(&timeInfo, &now_c);
+#else
+        localtime_r(&now_c, &timeInfo);
+#endif
+        std::strftime(cachedText, sizeof(cachedText), "%Y-%m-%d %H:%M:%S", &timeInfo);
+        cachedSecond = now_c;
+    }
+    auto ms = duration_cast<milliseconds>(time.time_since_epoch()) % 1000;
+    char millis[8];
+    std::snprintf(millis, sizeof(millis), ".%03lld", static_cast<long long>(ms.count()));
+    out.append(cachedText).append(millis);
+}
+
+/**
+ * @brief Appends a record to its file, inserting the rendered timestamp.
+ * @param record Record to write
+ */
+void Logger::write(const LogRecord& record) {
+    std::ofstream& file = fileFor(record.path, record.binary);
+    if (record.timestampPos == std::string::npos) {
+        file << record.text;
+        return;
+    }
+    std::string timestamp;
+    formatTimestamp(record.time, timestamp);
+    file.write(record.text.data(), record.timestampPos);
+    file << timestamp;
+    file.write(record.text.data() + record.timestampPos, record.text.size() - record.timestampPos);
+}
+
+/**
+ * @brief Returns the stream for a path, opening it (and creating parent directories) on first use.
+ * @param path Log file path
+ * @param binary Open without newline translation, for records of raw bytes
+ * @return Open append stream
+ */
+std::ofstream& Logger::fileFor(const std::string& path, bool binary) {
+    auto it = files.find(path);
+    if (it != files.end()) {
+        return it->second;
+    }
+    for (size_t slash = path.find('/'); slash != std::string::npos; slash = path.find('/', slash + 1)) {
+        makeDir(path.substr(0, slash).c_str());
+    }
+    std::ios::openmode mode = binary ? std::ios::app | std::ios::binary : std::ios::app;
+    return files.emplace(path, std::ofstream(path, mode)).first->second;
+}
+
+/**
+ * @brief Parses a log level name.
+ * @param name "debug", "info", "warn", "error" or "off"
+ * @param level Output level
+ * @return True if the name is known
+ */
+bool parseLogLevel(const std::string& name, LogLevel& level) {
+    static const std::pair<const char*, LogLevel> names[] = {
+        { "debug", LogLevel::Debug }, { "info", LogLevel::Info }, { "warn", LogLevel::Warn },
+        { "error", LogLevel::Error }, { "off", LogLevel::Off }
+    };
+    for (const auto& entry : names) {
+        if (name == entry.first) {
+            level = entry.second;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Parses a log category name.
+ * @param name "error", "state", "payload" or "data"
+ * @param category Output category
+ * @return True if the name is known
+ */
+bool parseLogCategory(const std::string& name, LogCategory& category) {
+    static const std::pair<const char*, LogCategory> names[] = {
+        { "error", LogCategory::Error }, { "state", LogCategory::State },
+        { "payload", LogCategory::Payload }, { "data", LogCategory::Data }
+    };
+    for (const auto& entry : names) {
+        if (name == entry.first) {
+            category = entry.second;
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,114 @@
+#pragma once
+#include <string>
+#include <atomic>
+#include <thread>
+#include <memory>
+#include <chrono>
+#include <fstream>
+#include <unordered_map>
+#include <cstdint>
+
+/**
+ * @brief Severity of a log record; records below the configured level are discarded.
+ */
+enum class LogLevel {
+    Debug,
+    Info,
+    Warn,
+    Error,
+    Off
+};
+
+/**
+ * @brief Kind of log record, used for levels and per-category sampling.
+ */
+enum class LogCategory {
+    Error,   // logError: failures (Error level)
+    State,   // logClientState: FSM transitions (Info level)
+    Payload, // logEvent: full request/response dumps (Debug level)
+    Data,    // logData: iteration separators and raw lines (Debug level)
+    Count
+};
+
+/**
+ * @brief A formatted log line waiting for the writer thread.
+ * @details The timestamp is captured by the producer but rendered by the writer;
+ *          it is inserted into text at timestampPos (npos = no timestamp).
+ */
+struct LogRecord {
+    std::string path;                              // Target file (e.g. log/web-server-sent.log)
+    std::string text;                              // Line(s) to append
+    size_t timestampPos = std::string::npos;       // Where the rendered timestamp goes
+    std::chrono::system_clock::time_point time;    // Capture time
+    bool binary = false;                           // Text holds raw bytes (file opened in binary mode)
+};
+
+/**
+ * @brief Asynchronous logging pipeline.
+ * @details Producers (event-loop threads) push records into a bounded lock-free ring
+ *          (Vyukov MPMC sequence ring) and never block or touch the filesystem. A background
+ *          writer drains the ring in batches, keeps every log file open, renders timestamps
+ *          and flushes once per batch. Records that do not fit in the ring are counted as
+ *          dropped and reported in the error log.
+ */
+class Logger {
+public:
+    // Returns the process-wide logger, starting the writer thread on first use
+    static Logger& instance();
+
+    // Stops the writer after draining the ring
+    ~Logger();
+
+    Logger(const Logger&) = delete;
+    Logger& operator=(const Logger&) = delete;
+
+    // Sets the minimum level that is recorded
+    void setLevel(LogLevel level);
+    // Keeps roughly `rate` (0..1) of the records of a category, e.g. 0.01 for 1% of payload dumps
+    void setSampleRate(LogCategory category, double rate);
+    // Returns true if the category's level is currently recorded (no sampling)
+    bool isEnabled(LogCategory category) const;
+    // Returns true if the next record of this category should be built and submitted (level + sampling)
+    bool shouldLog(LogCategory category);
+    // Pushes a record into the ring; returns false (and counts a drop) if the ring is full
+    bool submit(LogRecord&& record);
+    // Returns the number of records dropped because the ring was full
+    uint64_t dropped() const;
+
+private:
+    // Ring slot: the sequence number tells producers and the consumer who owns it
+    struct Cell {
+        std::atomic<size_t> sequence;
+        LogRecord record;
+    };
+
+    static constexpr size_t RING_SIZE = 1 << 16;   // Ring capacity (power of two)
+
+    std::unique_ptr<Cell[]> cells;                  // Ring storage
+    alignas(64) std::atomic<size_t> enqueuePos;     // Next slot for producers
+    alignas(64) std::atomic<size_t> dequeuePos;     // Next slot for the writer
+    alignas(64) std::atomic<uint64_t> droppedCount; // Records lost to a full ring
+    std::atomic<int> minLevel;                      // LogLevel as int
+    std::atomic<uint32_t> sampleEvery[static_cast<int>(LogCategory::Count)]; // Keep 1 of N records
+    std::atomic<bool> running;                      // Cleared to stop the writer
+    std::thread writer;                             // Background writer thread
+
+    std::unordered_map<std::string, std::ofstream> files; // Open log files (writer thread only)
+    uint64_t reportedDrops;                         // Drops already reported (writer thread only)
+
+    Logger();
+    // Pops one record; returns false if the ring is empty
+    bool tryPop(LogRecord& record);
+    // Writer loop: drain, write, flush, sleep when idle
+    void writerLoop();
+    // Appends one record to its file (writer thread only)
+    void write(const LogRecord& record);
+    // Returns the open stream for a path, creating directories and opening it on first use
+    std::ofstream& fileFor(const std::string& path, bool binary);
+};
+
+// Parses "debug", "info", "warn", "error" or "off"; returns false if unknown
+bool parseLogLevel(const std::string& name, LogLevel& level);
+
+// Parses "error", "state", "payload" or "data"; returns false if unknown
+bool parseLogCategory(const std::string& name, LogCategory& category);
@@ -1,12 +1,125 @@
 #include "server.h"
+#include "reactor-pool.h"
+#include "content-cache.h"
+#include "blocking-pool.h"
+#include "admission.h"
+#include "memory-budget.h"
+#include "access-log.h"
 #include <iostream>
 #include <csignal>
+#include <cstring>
+#include <cstdlib>
 
 static constexpr const char* IP = "127.0.0.1";
 static constexpr int PORT = 8080;
 
-int main() {
-    Server server(IP, PORT);
-	server.run();
+/**
+ * @brief Entry point.
+ * @details Usage: web-server [--reactors N] [--engine poll|uring] [--log-level L] [--log-sample CATEGORY=RATE]... [--cache-mb N]
+ *          [--max-body-mb N] [--io-threads N] [--backlog N] [--max-connections N] [--rate-limit R] [--rate-burst N]
+ *          [--shed-lag-ms N] [--max-header-kb N] [--connection-buffer-mb N] [--buffer-budget-mb N] [--access-log F]
+ *          --reactors N runs N event-loop threads sharing the port (0 = one per core, default 1).
+ *          --engine selects readiness polling (default) or the io_uring completion engine.
+ *          --log-level sets the minimum level: debug (default), info, warn, error or off.
+ *          --log-sample keeps a fraction of a category (error, state, payload, data), e.g. payload=0.01.
+ *          --cache-mb sets the static content cache budget per reactor in MiB (0 disables, default 64).
+ *          --max-body-mb sets the largest accepted request body in MiB (default 1024); larger ones get 413.
+ *          --io-threads N runs cache-miss file reads, PUT writes and DELETEs on N pool threads (default 4);
+ *          0 keeps them on the event loop.
+ *          --backlog N sets the listen backlog (default 1024).
+ *          --max-connections N caps open connections across all reactors (default 10000, 0 = unlimited);
+ *          connections over the cap get 503 and are closed.
+ *          --rate-limit R allows R requests per second per client address and reactor (default 0 = unlimited);
+ *          --rate-burst N sets how many may come at once (default R); further requests get 429 with Retry-After.
+ *          Each reactor keeps its own buckets, so a client whose connections land on N reactors may get up to
+ *          N * R requests per second.
+ *          --shed-lag-ms N answers new connections and requests with 503 while the smoothed event-loop lag
+ *          exceeds N ms (default 250, 0 never sheds).
+ *          --max-header-kb N sets the largest request line and header section in KiB (default 16); larger ones get 431.
+ *          --connection-buffer-mb N sets the memory one connection may hold in MiB (default 8): its reads pause
+ *          while its responses drain, and requests buffered whole that would not fit get 413.
+ *          --buffer-budget-mb N sets the memory all connection buffers may hold in MiB (default 512, 0 = unlimited);
+ *          every read pauses once it is used up.
+ *          --access-log F writes one record per request with its phase timings: text (default), binary or off.
+ */
+int main(int argc, char* argv[]) {
+    unsigned reactors = 1;
+    IoEngine engine = IoEngine::Poll;
+    unsigned ioThreads = 4;
+    AdmissionLimits limits;
+    size_t connectionBuffer = MemoryBudget::connectionLimit();
+    size_t bufferBudget = MemoryBudget::totalLimit();
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--reactors") == 0 && i + 1 < argc) {
+            reactors = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else if (std::strcmp(argv[i], "--engine") == 0 && i + 1 < argc) {
+            engine = std::strcmp(argv[++i], "uring") == 0 ? IoEngine::Uring : IoEngine::Poll;
+        }
+        else if (std::strcmp(argv[i], "--log-level") == 0 && i + 1 < argc) {
+            LogLevel level;
+            if (parseLogLevel(argv[++i], level)) {
+                Logger::instance().setLevel(level);
+            }
+        }
+        else if (std::strcmp(argv[i], "--log-sample") == 0 && i + 1 < argc) {
+            std::string spec = argv[++i];
+            size_t eq = spec.find('=');
+            LogCategory category;
+            if (eq != std::string::npos && parseLogCategory(spec.substr(0, eq), category)) {
+                Logger::instance().setSampleRate(category, std::atof(spec.c_str() + eq + 1));
+            }
+        }
+        else if (std::strcmp(argv[i], "--cache-mb") == 0 && i + 1 < argc) {
+            ContentCache::setDefaultBudget(static_cast<size_t>(std::strtoul(argv[++i], nullptr, 10)) * 1024 * 1024);
+        }
+        else if (std::strcmp(argv[i], "--max-body-mb") == 0 && i + 1 < argc) {
+            RequestParser::setDefaultBodyLimit(static_cast<size_t>(std::strtoull(argv[++i], nullptr, 10)) * 1024 * 1024);
+        }
+        else if (std::strcmp(argv[i], "--io-threads") == 0 && i + 1 < argc) {
+            ioThreads = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else if (std::strcmp(argv[i], "--backlog") == 0 && i + 1 < argc) {
+            limits.backlog = std::atoi(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--max-connections") == 0 && i + 1 < argc) {
+            limits.maxConnections = static_cast<size_t>(std::strtoull(argv[++i], nullptr, 10));
+        }
+        else if (std::strcmp(argv[i], "--rate-limit") == 0 && i + 1 < argc) {
+            limits.ratePerSecond = std::atof(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--rate-burst") == 0 && i + 1 < argc) {
+            limits.rateBurst = std::atof(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--shed-lag-ms") == 0 && i + 1 < argc) {
+            limits.shedLagMs = std::strtoull(argv[++i], nullptr, 10);
+        }
+        else if (std::strcmp(argv[i], "--max-header-kb") == 0 && i + 1 < argc) {
+            RequestParser::setDefaultHeaderLimit(static_cast<size_t>(std::strtoull(argv[++i], nullptr, 10)) * 1024);
+        }
+        else if (std::strcmp(argv[i], "--connection-buffer-mb") == 0 && i + 1 < argc) {
+            connectionBuffer = static_cast<size_t>(std::strtoull(argv[++i], nullptr, 10)) * 1024 * 1024;
+        }
+        else if (std::strcmp(argv[i], "--buffer-budget-mb") == 0 && i + 1 < argc) {
+            bufferBudget = static_cast<size_t>(std::strtoull(argv[++i], nullptr, 10)) * 1024 * 1024;
+        }
+        else if (std::strcmp(argv[i], "--access-log") == 0 && i + 1 < argc) {
+            AccessLogFormat format;
+            if (parseAccessLogFormat(argv[++i], format)) {
+                AccessLog::setFormat(format);
+            }
+        }
+    }
+    MemoryBudget::setLimits(connectionBuffer, bufferBudget);
+    AdmissionControl::setDefaultLimits(limits);
+    BlockingPool::start(ioThreads);
+    if (reactors == 1) {
+        Server server(IP, PORT, 1024, 120, false, engine);
+        server.run();
+        return 0;
+    }
+    ReactorPool pool(IP, PORT, reactors, engine);
+    std::cout << "Starting " << pool.size() << " reactors" << std::endl;
+    pool.run();
     return 0;
 }
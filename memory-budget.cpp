@@ -0,0 +1,72 @@
+#include "memory-budget.h"
+#include <atomic>
+
+static constexpr size_t DEFAULT_CONNECTION_LIMIT = 8 * 1024 * 1024; // Bytes per connection
+static constexpr size_t DEFAULT_TOTAL_LIMIT = 512 * 1024 * 1024;    // Bytes across all connections
+
+static std::atomic<size_t> connectionBytesLimit(DEFAULT_CONNECTION_LIMIT);
+static std::atomic<size_t> totalBytesLimit(DEFAULT_TOTAL_LIMIT);
+static std::atomic<int64_t> input(0);  // Capacity of connection input buffers
+static std::atomic<int64_t> output(0); // Owned bytes of queued responses
+
+/**
+ * @brief Sets the per-connection and total limits.
+ * @param connectionBytes Bytes one connection may hold (also the largest in-memory request)
+ * @param totalBytes Bytes all connections may hold together, 0 for no limit
+ */
+void MemoryBudget::setLimits(size_t connectionBytes, size_t totalBytes) {
+    connectionBytesLimit.store(connectionBytes, std::memory_order_relaxed);
+    totalBytesLimit.store(totalBytes, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Returns the bytes one connection may hold before its reads pause.
+ */
+size_t MemoryBudget::connectionLimit() {
+    return connectionBytesLimit.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Returns the bytes all connections may hold before every read pauses (0 = unlimited).
+ */
+size_t MemoryBudget::totalLimit() {
+    return totalBytesLimit.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Adjusts the input total.
+ * @param delta Bytes borrowed (positive) or given back (negative)
+ */
+void MemoryBudget::chargeInput(int64_t delta) {
+    input.fetch_add(delta, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Adjusts the output total.
+ * @param delta Bytes queued (positive) or sent and freed (negative)
+ */
+void MemoryBudget::chargeOutput(int64_t delta) {
+    output.fetch_add(delta, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Returns the bytes held by connection input buffers.
+ */
+size_t MemoryBudget::inputBytes() {
+    return static_cast<size_t>(input.load(std::memory_order_relaxed));
+}
+
+/**
+ * @brief Returns the bytes held by queued responses.
+ */
+size_t MemoryBudget::outputBytes() {
+    return static_cast<size_t>(output.load(std::memory_order_relaxed));
+}
+
+/**
+ * @brief Returns true while input and output together reach the total limit.
+ */
+bool MemoryBudget::exhausted() {
+    size_t limit = totalLimit();
+    return limit != 0 && inputBytes() + outputBytes() >= limit;
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Process-wide accounting of the memory held by connection buffers.
+ * @details Input is the capacity of every connection's IoBuffer, charged when the buffer is
+ *          borrowed or grown and released when it goes back; output is the bytes of queued
+ *          responses that belong to the connection (heads, owned bodies and stream chunks;
+ *          bodies shared with the content cache count against the cache's own budget, and
+ *          file bodies are not in memory). Counters are relaxed atomics updated by every
+ *          reactor, so the totals are exact but the budget may be overshot by the reads in
+ *          flight when it runs out. Past the per-connection limit a connection stops being
+ *          read until its queue drains, past the total every connection does, and a request
+ *          whose body would not fit the per-connection limit in memory is refused with 413.
+ */
+class MemoryBudget {
+public:
+    // Sets the limits (call before the reactors start)
+    static void setLimits(size_t connectionBytes, size_t totalBytes);
+    // Returns the bytes one connection may hold before its reads pause
+    static size_t connectionLimit();
+    // Returns the bytes all connections together may hold before every read pauses (0 = unlimited)
+    static size_t totalLimit();
+
+    // Adjusts the input total by delta bytes (any thread)
+    static void chargeInput(int64_t delta);
+    // Adjusts the output total by delta bytes (any thread)
+    static void chargeOutput(int64_t delta);
+    // Returns the bytes held by connection input buffers
+    static size_t inputBytes();
+    // Returns the bytes held by queued responses
+    static size_t outputBytes();
+    // Returns true while the total limit is reached
+    static bool exhausted();
+};
@@ -0,0 +1,278 @@
+#include "metrics.h"
+#include "memory-budget.h"
+#include <mutex>
+#include <vector>
+#include <chrono>
+#include <charconv>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+static std::mutex registryMutex;                 // Guards registry (reactor start/stop and scrapes only)
+static std::vector<const ReactorMetrics*> registry; // Live reactors' counters
+
+static const char* const STATE_LABELS[CLIENT_STATE_COUNT] = {
+    "disconnected", "awaiting_request", "request_buffered", "awaiting_handler", "response_ready", "completed", "aborted"
+};
+static const char* const TIMEOUT_LABELS[TIMEOUT_KIND_COUNT] = { "none", "idle", "header", "body", "write_stall" };
+static const char* const QUANTILES[] = { "0.5", "0.9", "0.99", "0.999" }; // Latency quantiles reported as gauges
+
+/**
+ * @brief Returns microseconds of a monotonic clock.
+ */
+uint64_t metricsClockUs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+/**
+ * @brief Returns the bucket a latency falls into.
+ * @details Bucket bounds are inclusive upper limits: the first SUB_BUCKETS buckets hold 1..4 us
+ *          one by one, then every power of two is split into SUB_BUCKETS equal parts, so the
+ *          powers of two themselves are bucket bounds.
+ * @param micros Latency in microseconds
+ * @return Bucket index
+ */
+size_t LatencyHistogram::bucketOf(uint64_t micros) {
+    uint64_t value = micros > 0 ? micros - 1 : 0;
+    if (value < SUB_BUCKETS) {
+        return static_cast<size_t>(value);
+    }
+    size_t exponent = 2;
+    while (exponent < 63 && (value >> (exponent + 1)) != 0) {
+        ++exponent;
+    }
+    size_t index = SUB_BUCKETS * (exponent - 1) + static_cast<size_t>((value >> (exponent - 2)) & (SUB_BUCKETS - 1));
+    return (std::min)(index, BUCKETS - 1);
+}
+
+/**
+ * @brief Returns the inclusive upper bound of a bucket in microseconds.
+ */
+uint64_t LatencyHistogram::upperBound(size_t index) {
+    if (index < SUB_BUCKETS) {
+        return index + 1;
+    }
+    size_t exponent = index / SUB_BUCKETS + 1;
+    return static_cast<uint64_t>(SUB_BUCKETS + 1 + index % SUB_BUCKETS) << (exponent - 2);
+}
+
+/**
+ * @brief Records one latency.
+ * @param micros Latency in microseconds
+ */
+void LatencyHistogram::record(uint64_t micros) {
+    counts[bucketOf(micros)].add();
+    sumMicros.add(micros);
+}
+
+/**
+ * @brief Registers the counters so /metrics reports them.
+ */
+ReactorMetrics::ReactorMetrics() {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    registry.push_back(this);
+}
+
+/**
+ * @brief Unregisters the counters; a scrape in progress finishes first.
+ */
+ReactorMetrics::~ReactorMetrics() {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    registry.erase(std::remove(registry.begin(), registry.end(), this), registry.end());
+}
+
+/**
+ * @brief Counts a response.
+ * @param method Request method (Unknown for requests that could not be parsed)
+ * @param statusCode Response status code; untracked codes share the "other" slot
+ */
+void ReactorMetrics::countResponse(Method method, int statusCode) {
+    size_t slot = 0;
+    while (slot < TRACKED_STATUSES.size() && TRACKED_STATUSES[slot] != statusCode) {
+        ++slot;
+    }
+    responses[(std::min)(static_cast<size_t>(method), METHOD_COUNT)][slot].add();
+}
+
+/**
+ * @brief Appends an unsigned number.
+ */
+static void appendNumber(std::string& out, uint64_t value) {
+    char digits[24];
+    auto result = std::to_chars(digits, digits + sizeof(digits), value);
+    out.append(digits, result.ptr);
+}
+
+/**
+ * @brief Appends a microsecond count as seconds with six decimals ("0.000128").
+ */
+static void appendSeconds(std::string& out, uint64_t micros) {
+    appendNumber(out, micros / 1000000);
+    std::string fraction = std::to_string(micros % 1000000);
+    out.append(".").append(6 - fraction.size(), '0').append(fraction);
+}
+
+/**
+ * @brief Appends the HELP and TYPE lines of a metric family.
+ */
+static void appendFamily(std::string& out, const char* name, const char* type, const char* help) {
+    out.append("# HELP ").append(name).append(" ").append(help).append("\n");
+    out.append("# TYPE ").append(name).append(" ").append(type).append("\n");
+}
+
+/**
+ * @brief Appends a metric family with a single unlabelled sample.
+ */
+static void appendSingle(std::string& out, const char* name, const char* type, const char* help, uint64_t value) {
+    appendFamily(out, name, type, help);
+    out.append(name).append(" ");
+    appendNumber(out, value);
+    out.append("\n");
+}
+
+/**
+ * @brief Sums one counter over every registered reactor (registry lock held).
+ */
+template <typename Field>
+static uint64_t sum(Field field) {
+    uint64_t total = 0;
+    for (const ReactorMetrics* metrics : registry) {
+        total += field(*metrics).get();
+    }
+    return total;
+}
+
+/**
+ * @brief Returns the largest value of one gauge over every registered reactor (registry lock held).
+ */
+template <typename Field>
+static uint64_t maximum(Field field) {
+    uint64_t largest = 0;
+    for (const ReactorMetrics* metrics : registry) {
+        largest = (std::max)(largest, field(*metrics).get());
+    }
+    return largest;
+}
+
+/**
+ * @brief Renders every registered reactor's counters in the Prometheus text exposition format.
+ * @details Only relaxed loads are made under a lock that reactors take just when they start or
+ *          stop, so a scrape never waits on (or stalls) another reactor's event loop. Latency
+ *          buckets are exported at the powers of two; the full-resolution buckets feed the
+ *          quantile gauges.
+ * @return Exposition text
+ */
+std::string renderMetrics() {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    std::string out;
+    out.reserve(8192);
+    appendSingle(out, "web_server_reactors", "gauge", "Event-loop threads serving connections.", registry.size());
+
+    appendFamily(out, "web_server_responses_total", "counter", "Responses queued, by request method and status code.");
+    for (size_t method = 0; method <= METHOD_COUNT; ++method) {
+        for (size_t slot = 0; slot < STATUS_SLOTS; ++slot) {
+            uint64_t count = sum([method, slot](const ReactorMetrics& m) -> const Counter& { return m.responses[method][slot]; });
+            if (count == 0) {
+                continue;
+            }
+            out.append("web_server_responses_total{method=\"");
+            out.append(method < METHOD_COUNT ? methodName(static_cast<Method>(method)) : std::string_view("other"));
+            out.append("\",code=\"");
+            out.append(slot < TRACKED_STATUSES.size() ? std::to_string(TRACKED_STATUSES[slot]) : std::string("other"));
+            out.append("\"} ");
+            appendNumber(out, count);
+            out.append("\n");
+        }
+    }
+
+    std::array<uint64_t, LatencyHistogram::BUCKETS> buckets{};
+    uint64_t samples = 0;
+    for (size_t i = 0; i < LatencyHistogram::BUCKETS; ++i) {
+        buckets[i] = sum([i](const ReactorMetrics& m) -> const Counter& { return m.latency.counts[i]; });
+        samples += buckets[i];
+    }
+    appendFamily(out, "web_server_response_latency_seconds", "histogram",
+        "Time from a request being complete to the last byte of its response being sent.");
+    uint64_t cumulative = 0;
+    for (size_t i = 0; i < LatencyHistogram::BUCKETS; ++i) {
+        cumulative += buckets[i];
+        uint64_t bound = LatencyHistogram::upperBound(i);
+        if ((bound & (bound - 1)) != 0) {
+            continue; // Only power-of-two bounds are exported
+        }
+        out.append("web_server_response_latency_seconds_bucket{le=\"");
+        appendSeconds(out, bound);
+        out.append("\"} ");
+        appendNumber(out, cumulative);
+        out.append("\n");
+    }
+    out.append("web_server_response_latency_seconds_bucket{le=\"+Inf\"} ");
+    appendNumber(out, samples);
+    out.append("\nweb_server_response_latency_seconds_sum ");
+    appendSeconds(out, sum([](const ReactorMetrics& m) -> const Counter& { return m.latency.sumMicros; }));
+    out.append("\nweb_server_response_latency_seconds_count ");
+    appendNumber(out, samples);
+    out.append("\n");
+
+    appendFamily(out, "web_server_response_latency_quantile_seconds", "gauge",
+        "Response latency quantiles since start (upper bound of the bucket holding the quantile).");
+    for (const char* quantile : QUANTILES) {
+        uint64_t rank = static_cast<uint64_t>(std::ceil(std::atof(quantile) * static_cast<double>(samples)));
+        uint64_t seen = 0;
+        size_t index = 0;
+        for (; index + 1 < LatencyHistogram::BUCKETS; ++index) {
+            seen += buckets[index];
+            if (seen >= (std::max)(rank, uint64_t(1))) {
+                break;
+            }
+        }
+        out.append("web_server_response_latency_quantile_seconds{quantile=\"").append(quantile).append("\"} ");
+        appendSeconds(out, samples == 0 ? 0 : LatencyHistogram::upperBound(index));
+        out.append("\n");
+    }
+
+    appendSingle(out, "web_server_received_bytes_total", "counter", "Bytes received from clients.",
+        sum([](const ReactorMetrics& m) -> const Counter& { return m.bytesIn; }));
+    appendSingle(out, "web_server_sent_bytes_total", "counter", "Bytes sent to clients, file bodies included.",
+        sum([](const ReactorMetrics& m) -> const Counter& { return m.bytesOut; }));
+    appendSingle(out, "web_server_accepted_connections_total", "counter", "Connections accepted (rate() gives accepts per second).",
+        sum([](const ReactorMetrics& m) -> const Counter& { return m.accepts; }));
+    appendSingle(out, "web_server_event_loop_iterations_total", "counter", "Event-loop iterations (poll or io_uring waits).",
+        sum([](const ReactorMetrics& m) -> const Counter& { return m.iterations; }));
+    appendSingle(out, "web_server_blocking_jobs_total", "counter", "File operations handed to the I/O pool.",
+        sum([](const ReactorMetrics& m) -> const Counter& { return m.blockingJobs; }));
+    appendSingle(out, "web_server_refused_connections_total", "counter", "Connections answered 503 and closed at accept (connection cap or load shedding).",
+        sum([](const ReactorMetrics& m) -> const Counter& { return m.refusedConnections; }));
+    appendFamily(out, "web_server_event_loop_lag_seconds", "gauge", "Smoothed event-loop lag of the most loaded reactor, sampled once per second.");
+    out.append("web_server_event_loop_lag_seconds ");
+    appendSeconds(out, maximum([](const ReactorMetrics& m) -> const Counter& { return m.eventLoopLagUs; }));
+    out.append("\n");
+
+    appendFamily(out, "web_server_timeouts_total", "counter", "Connections closed by a deadline, by timeout kind.");
+    for (size_t kind = 1; kind < TIMEOUT_KIND_COUNT; ++kind) {
+        out.append("web_server_timeouts_total{kind=\"").append(TIMEOUT_LABELS[kind]).append("\"} ");
+        appendNumber(out, sum([kind](const ReactorMetrics& m) -> const Counter& { return m.timeouts[kind]; }));
+        out.append("\n");
+    }
+
+    appendFamily(out, "web_server_buffered_bytes", "gauge", "Memory held by connection buffers: input buffer capacity and owned bytes of queued responses.");
+    out.append("web_server_buffered_bytes{direction=\"input\"} ");
+    appendNumber(out, MemoryBudget::inputBytes());
+    out.append("\nweb_server_buffered_bytes{direction=\"output\"} ");
+    appendNumber(out, MemoryBudget::outputBytes());
+    out.append("\n");
+    appendSingle(out, "web_server_buffer_budget_bytes", "gauge", "Buffered bytes at which every connection stops being read (0 = unlimited).",
+        MemoryBudget::totalLimit());
+    appendSingle(out, "web_server_read_pauses_total", "counter", "Times a connection stopped being read because of the memory budget.",
+        sum([](const ReactorMetrics& m) -> const Counter& { return m.readPauses; }));
+    appendSingle(out, "web_server_open_connections", "gauge", "Connections currently open.",
+        sum([](const ReactorMetrics& m) -> const Counter& { return m.openConnections; }));
+    appendFamily(out, "web_server_connections", "gauge", "Open connections by state, sampled once per second.");
+    for (size_t state = static_cast<size_t>(ClientState::AwaitingRequest); state <= static_cast<size_t>(ClientState::ResponseReady); ++state) {
+        out.append("web_server_connections{state=\"").append(STATE_LABELS[state]).append("\"} ");
+        appendNumber(out, sum([state](const ReactorMetrics& m) -> const Counter& { return m.connectionStates[state]; }));
+        out.append("\n");
+    }
+    return out;
+}
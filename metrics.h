@@ -0,0 +1,93 @@
+#pragma once
+#include <string>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include "client.h"
+#include "router.h"
+
+static constexpr size_t CLIENT_STATE_COUNT = 7; // Entries in ClientState
+static constexpr size_t TIMEOUT_KIND_COUNT = 5; // Entries in TimeoutKind up to WriteStall (Wakeup and SocketWait never close a connection)
+static constexpr std::array<int, 16> TRACKED_STATUSES = { 200, 201, 204, 206, 304, 400, 404, 405, 408, 413, 416, 429, 431, 500, 503, 505 };
+static constexpr size_t STATUS_SLOTS = TRACKED_STATUSES.size() + 1; // Tracked codes plus "other"
+
+// Returns microseconds of a monotonic clock (latency measurements)
+uint64_t metricsClockUs();
+
+/**
+ * @brief Counter written by one thread and read by any.
+ * @details Updated with a relaxed load and store rather than an atomic increment: only the
+ *          owning reactor writes, so no locked instruction is needed and the cost is that of
+ *          a plain add. Readers on other threads see a recent value, never a torn one.
+ */
+class Counter {
+public:
+    // Adds n (owning thread only)
+    void add(uint64_t n = 1) { value.store(value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed); }
+    // Replaces the value (gauges; owning thread only)
+    void set(uint64_t n) { value.store(n, std::memory_order_relaxed); }
+    // Returns the current value (any thread)
+    uint64_t get() const { return value.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<uint64_t> value{ 0 };
+};
+
+/**
+ * @brief Fixed-size latency histogram with HDR-style log-linear buckets.
+ * @details Each power of two from 1 us to about 134 s is split into SUB_BUCKETS equal
+ *          buckets, so every recorded value is known within 25% at a constant 104 counters,
+ *          whatever the number of samples. Recording is an index computation and one add.
+ */
+class LatencyHistogram {
+public:
+    static constexpr size_t SUB_BUCKETS = 4;                    // Buckets per power of two
+    static constexpr size_t MAX_EXPONENT = 26;                  // Values up to 2^27 us (~134 s); larger ones land in the last bucket
+    static constexpr size_t BUCKETS = SUB_BUCKETS * MAX_EXPONENT; // Counters
+
+    // Records one latency (owning thread only)
+    void record(uint64_t micros);
+    // Returns the inclusive upper bound of a bucket in microseconds
+    static uint64_t upperBound(size_t index);
+    // Returns the bucket a latency falls into
+    static size_t bucketOf(uint64_t micros);
+
+    std::array<Counter, BUCKETS> counts; // Samples per bucket
+    Counter sumMicros;                   // Sum of all samples
+};
+
+/**
+ * @brief Counters of one reactor, registered for /metrics for as long as they exist.
+ * @details Owned by a Server and written only by its event-loop thread; the /metrics handler,
+ *          which may run on any reactor, reads every registered instance and sums them.
+ */
+struct ReactorMetrics {
+    std::array<std::array<Counter, STATUS_SLOTS>, METHOD_COUNT + 1> responses; // By method (Unknown last) and status slot
+    LatencyHistogram latency;                                // Request complete to last response byte sent
+    Counter bytesIn;                                         // Bytes received from clients
+    Counter bytesOut;                                        // Bytes sent to clients (heads, bodies, files)
+    Counter accepts;                                         // Connections accepted
+    Counter iterations;                                      // Event-loop iterations
+    Counter blockingJobs;                                    // File operations handed to the I/O pool
+    Counter refusedConnections;                              // Connections answered 503 and closed at accept
+    Counter readPauses;                                      // Times a connection's reads were paused by the memory budget
+    std::array<Counter, TIMEOUT_KIND_COUNT> timeouts;        // Connections closed per TimeoutKind
+    Counter openConnections;                                 // Connections currently open
+    std::array<Counter, CLIENT_STATE_COUNT> connectionStates; // Open connections per ClientState (sampled)
+    Counter eventLoopLagUs;                                  // Smoothed event-loop lag in microseconds (sampled)
+
+    // Registers the instance with /metrics
+    ReactorMetrics();
+    // Unregisters it
+    ~ReactorMetrics();
+
+    ReactorMetrics(const ReactorMetrics&) = delete;
+    ReactorMetrics& operator=(const ReactorMetrics&) = delete;
+
+    // Counts a response by request method and status code (owning thread only)
+    void countResponse(Method method, int statusCode);
+};
+
+// Renders the metrics of every registered reactor in the Prometheus text format
+std::string renderMetrics();
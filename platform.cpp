@@ -0,0 +1,271 @@
+#include "platform.h"
+
+/**
+ * @brief Initializes the socket library.
+ * @return True if successful, false otherwise
+ */
+bool socketStartup() {
+#ifdef _WIN32
+    WSAData wsaData;
+    return NO_ERROR == WSAStartup(MAKEWORD(2, 2), &wsaData);
+#else
+    return true;
+#endif
+}
+
+/**
+ * @brief Releases the socket library.
+ */
+void socketCleanup() {
+#ifdef _WIN32
+    WSACleanup();
+#endif
+}
+
+/**
+ * @brief Returns the last socket error code.
+ * @return WSAGetLastError() on Windows, errno elsewhere
+ */
+int getSocketError() {
+#ifdef _WIN32
+    return WSAGetLastError();
+#else
+    return errno;
+#endif
+}
+
+/**
+ * @brief Checks if a socket error code means the call would block.
+ * @param error Error code from getSocketError()
+ * @return True if the operation should be retried on the next readiness event
+ */
+bool isWouldBlock(int error) {
+#ifdef _WIN32
+    return error == WSAEWOULDBLOCK;
+#else
+    return error == EAGAIN || error == EWOULDBLOCK;
+#endif
+}
+
+/**
+ * @brief Switches a socket to non-blocking mode.
+ * @param s Socket descriptor
+ * @return True if successful, false otherwise
+ */
+bool setNonBlocking(SOCKET s) {
+#ifdef _WIN32
+    unsigned long flag = 1;
+    return ioctlsocket(s, FIONBIO, &flag) == NO_ERROR;
+#else
+    int flags = fcntl(s, F_GETFL, 0);
+    return flags != -1 && fcntl(s, F_SETFL, flags | O_NONBLOCK) != -1;
+#endif
+}
+
+/**
+ * @brief Maps a socket to an index suitable for a table indexed by descriptor.
+ * @details POSIX descriptors are the lowest free integers. Winsock handles are kernel
+ *          handles, which are multiples of 4 and also allocated from the low end.
+ * @param s Socket descriptor
+ * @return Dense index
+ */
+size_t socketIndex(SOCKET s) {
+#ifdef _WIN32
+    return static_cast<size_t>(s) >> 2;
+#else
+    return static_cast<size_t>(s);
+#endif
+}
+
+/**
+ * @brief Creates a directory if it doesn't exist.
+ * @param path Directory path
+ */
+void makeDir(const char* path) {
+#ifdef _WIN32
+    _mkdir(path);
+#else
+    mkdir(path, 0755);
+#endif
+}
+
+/**
+ * @brief Reads the modification time of a file.
+ * @details Nanosecond precision where the platform records it, so two writes within the
+ *          same second still produce different validators.
+ * @param path File path
+ * @param modifiedNs Receives nanoseconds since the epoch
+ * @return True if the file exists
+ */
+bool fileModified(const std::string& path, int64_t& modifiedNs) {
+#ifdef _WIN32
+    struct _stat64 st;
+    if (_stat64(path.c_str(), &st) != 0) {
+        return false;
+    }
+    modifiedNs = static_cast<int64_t>(st.st_mtime) * 1000000000;
+#else
+    struct stat st;
+    if (::stat(path.c_str(), &st) != 0) {
+        return false;
+    }
+#ifdef __linux__
+    modifiedNs = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+#else
+    modifiedNs = static_cast<int64_t>(st.st_mtime) * 1000000000;
+#endif
+#endif
+    return true;
+}
+
+/**
+ * @brief Opens a file read-only and records its size.
+ * @param path File path
+ */
+FileHandle::FileHandle(const std::string& path) : fd(-1), fileSize(0) {
+#ifdef _WIN32
+    fd = _open(path.c_str(), _O_RDONLY | _O_BINARY);
+    struct _stat64 st;
+    if (fd != -1 && _fstat64(fd, &st) == 0) {
+        fileSize = static_cast<uint64_t>(st.st_size);
+    }
+#else
+    fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat st;
+    if (fd != -1 && fstat(fd, &st) == 0) {
+        fileSize = static_cast<uint64_t>(st.st_size);
+    }
+#endif
+}
+
+/**
+ * @brief Closes the descriptor.
+ */
+FileHandle::~FileHandle() {
+    if (fd == -1) {
+        return;
+    }
+#ifdef _WIN32
+    _close(fd);
+#else
+    ::close(fd);
+#endif
+}
+
+/**
+ * @brief Returns true if the file was opened.
+ */
+bool FileHandle::isOpen() const {
+    return fd != -1;
+}
+
+/**
+ * @brief Returns the raw descriptor.
+ */
+int FileHandle::get() const {
+    return fd;
+}
+
+/**
+ * @brief Returns the file size in bytes at open time.
+ */
+uint64_t FileHandle::size() const {
+    return fileSize;
+}
+
+/**
+ * @brief Points a slice at a buffer.
+ * @param slice Slice to fill
+ * @param data First byte
+ * @param length Number of bytes
+ */
+void setSlice(IoSlice& slice, const char* data, size_t length) {
+#ifdef _WIN32
+    slice.buf = const_cast<char*>(data);
+    slice.len = static_cast<ULONG>(length);
+#else
+    slice.iov_base = const_cast<char*>(data);
+    slice.iov_len = length;
+#endif
+}
+
+/**
+ * @brief Sends several buffers with one gathered write.
+ * @details sendmsg() is used rather than writev() so that flags such as MSG_NOSIGNAL apply.
+ * @param s Destination socket
+ * @param slices Buffers in send order
+ * @param count Number of buffers
+ * @param flags send() flags
+ * @return Bytes sent, or -1 on error (including would-block)
+ */
+long long sendSlices(SOCKET s, const IoSlice* slices, size_t count, int flags) {
+#ifdef _WIN32
+    DWORD sent = 0;
+    if (WSASend(s, const_cast<IoSlice*>(slices), static_cast<DWORD>(count), &sent, static_cast<DWORD>(flags), nullptr, nullptr) != 0) {
+        return -1;
+    }
+    return sent;
+#else
+    msghdr message{};
+    message.msg_iov = const_cast<IoSlice*>(slices);
+    message.msg_iovlen = count;
+    return sendmsg(s, &message, flags);
+#endif
+}
+
+/**
+ * @brief Reads part of a file at an absolute offset.
+ * @param file Open file
+ * @param offset File offset to read from
+ * @param buffer Destination
+ * @param length Maximum number of bytes to read
+ * @return Bytes read (0 at end of file), or -1 on error
+ */
+long long readAt(const FileHandle& file, uint64_t offset, char* buffer, size_t length) {
+#ifdef _WIN32
+    if (_lseeki64(file.get(), static_cast<long long>(offset), SEEK_SET) < 0) {
+        return -1;
+    }
+    unsigned piece = static_cast<unsigned>(length < 0x40000000 ? length : 0x40000000);
+    return _read(file.get(), buffer, piece);
+#else
+    ssize_t bytesRead;
+    do {
+        bytesRead = pread(file.get(), buffer, length, static_cast<off_t>(offset));
+    } while (bytesRead < 0 && errno == EINTR);
+    return bytesRead;
+#endif
+}
+
+/**
+ * @brief Streams part of a file to a socket.
+ * @details On Linux the kernel copies page-cache pages straight to the socket (sendfile);
+ *          elsewhere a bounded chunk is read and sent.
+ * @param s Destination socket
+ * @param file Open file
+ * @param offset File offset to send from, advanced by the bytes sent
+ * @param length Maximum number of bytes to send
+ * @return Bytes sent, or -1 on error (including would-block)
+ */
+long long sendFile(SOCKET s, const FileHandle& file, uint64_t& offset, uint64_t length) {
+#ifdef __linux__
+    off_t fileOffset = static_cast<off_t>(offset);
+    ssize_t sent = ::sendfile(s, file.get(), &fileOffset, static_cast<size_t>(length));
+    if (sent > 0) {
+        offset = static_cast<uint64_t>(fileOffset);
+    }
+    return sent;
+#else
+    char chunk[64 * 1024];
+    size_t toRead = length < sizeof(chunk) ? static_cast<size_t>(length) : sizeof(chunk);
+    long long bytesRead = readAt(file, offset, chunk, toRead);
+    if (bytesRead <= 0) {
+        return -1;
+    }
+    int sent = send(s, chunk, static_cast<int>(bytesRead), SEND_FLAGS);
+    if (sent > 0) {
+        offset += static_cast<uint64_t>(sent);
+    }
+    return sent;
+#endif
+}
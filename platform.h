@@ -0,0 +1,123 @@
+#pragma once
+#include <string>
+#include <cstdint>
+/**
+ * @brief Socket platform layer.
+ * @details Maps the Winsock names used throughout the server onto BSD sockets so the
+ *          same code builds on Windows (Winsock2) and Linux/POSIX.
+ */
+#ifdef _WIN32
+#ifndef _CRT_SECURE_NO_WARNINGS
+#define _CRT_SECURE_NO_WARNINGS
+#endif
+#ifndef _WINSOCK_DEPRECATED_NO_WARNINGS
+#define _WINSOCK_DEPRECATED_NO_WARNINGS
+#endif
+
+#include <winsock2.h>
+#include <direct.h>
+#include <io.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#pragma comment(lib, "Ws2_32.lib")
+
+typedef int socklen_t;
+typedef WSABUF IoSlice; // One buffer of a gathered send
+
+static constexpr int SEND_FLAGS = 0;                    // Flags passed to every send()
+static constexpr int SEND_MORE_FLAGS = 0;               // send() flags when more data follows
+static constexpr const char* CONTENT_DIR = "C:\\temp\\"; // Directory served by GET/PUT/DELETE
+#else
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/stat.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <cerrno>
+#ifdef __linux__
+#include <sys/sendfile.h>
+#endif
+
+typedef int SOCKET;
+typedef sockaddr SOCKADDR;
+typedef iovec IoSlice; // One buffer of a gathered send
+
+#define INVALID_SOCKET (-1)
+#define SOCKET_ERROR (-1)
+#define NO_ERROR 0
+#define closesocket ::close
+
+static constexpr int SEND_FLAGS = MSG_NOSIGNAL;   // Never raise SIGPIPE on a reset peer
+#ifdef MSG_MORE
+static constexpr int SEND_MORE_FLAGS = MSG_NOSIGNAL | MSG_MORE; // Hold back a partial frame when more data follows
+#else
+static constexpr int SEND_MORE_FLAGS = MSG_NOSIGNAL;
+#endif
+static constexpr const char* CONTENT_DIR = "/tmp/"; // Directory served by GET/PUT/DELETE
+#endif
+
+// Initializes the socket library (WSAStartup on Windows, no-op elsewhere)
+bool socketStartup();
+
+// Releases the socket library (WSACleanup on Windows, no-op elsewhere)
+void socketCleanup();
+
+// Returns the last socket error code (WSAGetLastError on Windows, errno elsewhere)
+int getSocketError();
+
+// Returns true if the error code means the operation would block
+bool isWouldBlock(int error);
+
+// Switches a socket to non-blocking mode
+bool setNonBlocking(SOCKET s);
+
+// Maps a socket to a small dense index for descriptor-indexed tables
+size_t socketIndex(SOCKET s);
+
+// Creates a directory if it doesn't exist
+void makeDir(const char* path);
+
+// Reads the modification time of a file in nanoseconds since the epoch; returns false if it doesn't exist
+bool fileModified(const std::string& path, int64_t& modifiedNs);
+
+/**
+ * @brief Owns a read-only file descriptor and closes it on destruction.
+ * @details Used for file-backed response bodies that are streamed to the socket.
+ */
+class FileHandle {
+public:
+    // Opens path read-only and records its size; check isOpen()
+    explicit FileHandle(const std::string& path);
+    // Closes the descriptor
+    ~FileHandle();
+
+    FileHandle(const FileHandle&) = delete;
+    FileHandle& operator=(const FileHandle&) = delete;
+
+    // Returns true if the file was opened
+    bool isOpen() const;
+    // Returns the raw descriptor
+    int get() const;
+    // Returns the file size in bytes at open time
+    uint64_t size() const;
+
+private:
+    int fd;            // Open descriptor, -1 on failure
+    uint64_t fileSize; // Size at open time
+};
+
+// Points a slice at length bytes of data
+void setSlice(IoSlice& slice, const char* data, size_t length);
+
+// Sends count buffers with a single gathered write (sendmsg/WSASend); returns bytes sent or -1
+long long sendSlices(SOCKET s, const IoSlice* slices, size_t count, int flags);
+
+// Reads up to length bytes of file at offset without moving a shared position; returns bytes read or -1
+long long readAt(const FileHandle& file, uint64_t offset, char* buffer, size_t length);
+
+// Sends up to length bytes of file starting at offset (advanced by the bytes sent).
+// Uses sendfile() on Linux (no user-space copy); returns bytes sent or -1 (see getSocketError()).
+long long sendFile(SOCKET s, const FileHandle& file, uint64_t& offset, uint64_t length);
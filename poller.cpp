@@ -0,0 +1,205 @@
+#include "poller.h"
+
+static constexpr int MAX_EVENTS = 256; // Events collected per wait() call
+
+#ifdef __linux__
+
+/**
+ * @brief Translates PollFlags interest into edge-triggered epoll flags.
+ */
+static uint32_t toEpoll(unsigned interest) {
+    uint32_t flags = EPOLLET;
+    if (interest & POLL_READ) {
+        flags |= EPOLLIN;
+    }
+    if (interest & POLL_WRITE) {
+        flags |= EPOLLOUT;
+    }
+    return flags;
+}
+
+/**
+ * @brief Creates the epoll instance.
+ */
+Poller::Poller() : epollFd(epoll_create1(EPOLL_CLOEXEC)), readyEvents(MAX_EVENTS) {}
+
+/**
+ * @brief Closes the epoll instance.
+ */
+Poller::~Poller() {
+    if (epollFd != -1) {
+        ::close(epollFd);
+    }
+}
+
+/**
+ * @brief Returns true if epoll_create1() succeeded.
+ */
+bool Poller::isValid() const {
+    return epollFd != -1;
+}
+
+/**
+ * @brief Registers a socket with the epoll instance.
+ * @param s Socket descriptor
+ * @param interest Combination of POLL_READ / POLL_WRITE
+ * @return True if successful, false otherwise
+ */
+bool Poller::add(SOCKET s, unsigned interest) {
+    epoll_event ev{};
+    ev.events = toEpoll(interest);
+    ev.data.fd = s;
+    return epoll_ctl(epollFd, EPOLL_CTL_ADD, s, &ev) == 0;
+}
+
+/**
+ * @brief Changes the interest of a registered socket.
+ * @details EPOLL_CTL_MOD re-arms the edge, so a socket that is already ready is reported again.
+ * @param s Socket descriptor
+ * @param interest Combination of POLL_READ / POLL_WRITE
+ * @return True if successful, false otherwise
+ */
+bool Poller::modify(SOCKET s, unsigned interest) {
+    epoll_event ev{};
+    ev.events = toEpoll(interest);
+    ev.data.fd = s;
+    return epoll_ctl(epollFd, EPOLL_CTL_MOD, s, &ev) == 0;
+}
+
+/**
+ * @brief Unregisters a socket from the epoll instance.
+ * @param s Socket descriptor
+ */
+void Poller::remove(SOCKET s) {
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, s, nullptr);
+}
+
+/**
+ * @brief Waits for readiness events.
+ * @param events Output vector, cleared and filled with ready sockets
+ * @param timeoutMs Timeout in milliseconds, -1 to wait forever
+ * @return Number of ready sockets, or -1 on error
+ */
+int Poller::wait(std::vector<PollEvent>& events, int timeoutMs) {
+    events.clear();
+    int n = epoll_wait(epollFd, readyEvents.data(), static_cast<int>(readyEvents.size()), timeoutMs);
+    if (n < 0) {
+        return errno == EINTR ? 0 : -1;
+    }
+    for (int i = 0; i < n; ++i) {
+        unsigned flags = POLL_NONE;
+        if (readyEvents[i].events & EPOLLIN) {
+            flags |= POLL_READ;
+        }
+        if (readyEvents[i].events & EPOLLOUT) {
+            flags |= POLL_WRITE;
+        }
+        if (readyEvents[i].events & (EPOLLERR | EPOLLHUP)) {
+            flags |= POLL_ERROR;
+        }
+        events.push_back({ readyEvents[i].data.fd, flags });
+    }
+    return n;
+}
+
+#else
+
+/**
+ * @brief Creates an empty select() interest set.
+ */
+Poller::Poller() {}
+
+/**
+ * @brief Destroys the interest set.
+ */
+Poller::~Poller() {}
+
+/**
+ * @brief select() needs no setup, always valid.
+ */
+bool Poller::isValid() const {
+    return true;
+}
+
+/**
+ * @brief Registers a socket with the interest set.
+ * @param s Socket descriptor
+ * @param interest Combination of POLL_READ / POLL_WRITE
+ * @return True if successful, false otherwise
+ */
+bool Poller::add(SOCKET s, unsigned interest) {
+    return interests.emplace(s, interest).second;
+}
+
+/**
+ * @brief Changes the interest of a registered socket.
+ * @param s Socket descriptor
+ * @param interest Combination of POLL_READ / POLL_WRITE
+ * @return True if successful, false otherwise
+ */
+bool Poller::modify(SOCKET s, unsigned interest) {
+    auto it = interests.find(s);
+    if (it == interests.end()) {
+        return false;
+    }
+    it->second = interest;
+    return true;
+}
+
+/**
+ * @brief Unregisters a socket from the interest set.
+ * @param s Socket descriptor
+ */
+void Poller::remove(SOCKET s) {
+    interests.erase(s);
+}
+
+/**
+ * @brief Builds the fd_sets from the interest set and waits with select().
+ * @param events Output vector, cleared and filled with ready sockets
+ * @param timeoutMs Timeout in milliseconds, -1 to wait forever
+ * @return Number of ready sockets, or -1 on error
+ */
+int Poller::wait(std::vector<PollEvent>& events, int timeoutMs) {
+    events.clear();
+    fd_set readfds, writefds, errorfds;
+    FD_ZERO(&readfds);
+    FD_ZERO(&writefds);
+    FD_ZERO(&errorfds);
+    SOCKET maxFd = 0;
+    for (const auto& kv : interests) {
+        if (kv.second & POLL_READ) {
+            FD_SET(kv.first, &readfds);
+        }
+        if (kv.second & POLL_WRITE) {
+            FD_SET(kv.first, &writefds);
+        }
+        FD_SET(kv.first, &errorfds);
+        maxFd = (std::max)(maxFd, kv.first);
+    }
+    timeval timeout;
+    timeout.tv_sec = timeoutMs / 1000;
+    timeout.tv_usec = (timeoutMs % 1000) * 1000;
+    int nfd = select(static_cast<int>(maxFd) + 1, &readfds, &writefds, &errorfds, timeoutMs < 0 ? nullptr : &timeout);
+    if (nfd == SOCKET_ERROR) {
+        return -1;
+    }
+    for (const auto& kv : interests) {
+        unsigned flags = POLL_NONE;
+        if (FD_ISSET(kv.first, &readfds)) {
+            flags |= POLL_READ;
+        }
+        if (FD_ISSET(kv.first, &writefds)) {
+            flags |= POLL_WRITE;
+        }
+        if (FD_ISSET(kv.first, &errorfds)) {
+            flags |= POLL_ERROR;
+        }
+        if (flags != POLL_NONE) {
+            events.push_back({ kv.first, flags });
+        }
+    }
+    return static_cast<int>(events.size());
+}
+
+#endif
@@ -0,0 +1,62 @@
+#pragma once
+#include <vector>
+#include <map>
+#include <algorithm>
+#include "platform.h"
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#endif
+
+// Readiness flags used both for registered interest and for reported events
+enum PollFlags : unsigned {
+    POLL_NONE = 0,
+    POLL_READ = 1 << 0,
+    POLL_WRITE = 1 << 1,
+    POLL_ERROR = 1 << 2
+};
+
+/**
+ * @brief A single readiness notification returned by Poller::wait().
+ */
+struct PollEvent {
+    SOCKET socket;   // Socket that became ready
+    unsigned events; // Combination of PollFlags
+};
+
+/**
+ * @brief I/O readiness multiplexer.
+ * @details Uses an edge-triggered epoll instance on Linux, so interest is registered once per
+ *          socket and each wait() costs time proportional to the number of ready sockets.
+ *          Other platforms fall back to select() over the registered sockets.
+ *          Edge-triggered sockets must be drained until the call would block.
+ */
+class Poller {
+public:
+    // Creates the underlying epoll instance (if any)
+    Poller();
+    // Closes the underlying epoll instance (if any)
+    ~Poller();
+
+    Poller(const Poller&) = delete;
+    Poller& operator=(const Poller&) = delete;
+
+    // Returns true if the poller was created successfully
+    bool isValid() const;
+    // Registers a socket with the given interest
+    bool add(SOCKET s, unsigned interest);
+    // Changes the interest of a registered socket
+    bool modify(SOCKET s, unsigned interest);
+    // Unregisters a socket (call before closing it)
+    void remove(SOCKET s);
+    // Waits up to timeoutMs (-1 = forever) and fills events; returns the count or -1 on error
+    int wait(std::vector<PollEvent>& events, int timeoutMs);
+
+private:
+#ifdef __linux__
+    int epollFd;                          // epoll instance descriptor
+    std::vector<epoll_event> readyEvents; // Scratch buffer for epoll_wait()
+#else
+    std::map<SOCKET, unsigned> interests; // Registered sockets and their interest
+#endif
+};
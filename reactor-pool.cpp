@@ -0,0 +1,51 @@
+#include "reactor-pool.h"
+
+/**
+ * @brief Creates the reactors and binds their listening sockets.
+ * @param ip Server IP address
+ * @param port Server port shared by all reactors
+ * @param count Number of reactors, 0 for one per hardware thread
+ * @param engine I/O engine used by every reactor
+ */
+ReactorPool::ReactorPool(const std::string& ip, int port, unsigned count, IoEngine engine) {
+    if (count == 0) {
+        count = (std::max)(1u, std::thread::hardware_concurrency());
+    }
+#ifndef SO_REUSEPORT
+    if (count > 1) {
+        logError("SO_REUSEPORT not supported, running a single reactor");
+        count = 1;
+    }
+#endif
+    bool reusePort = count > 1;
+    for (unsigned i = 0; i < count; ++i) {
+        reactors.push_back(std::make_unique<Server>(ip, port, 1024, 120, reusePort, engine));
+    }
+}
+
+/**
+ * @brief Runs each reactor's event loop on its own thread and joins them.
+ */
+void ReactorPool::run() {
+    if (reactors.size() == 1) {
+        reactors[0]->run();
+        return;
+    }
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < reactors.size(); ++i) {
+        threads.emplace_back([this, i]() {
+            setLogSink("reactor-" + std::to_string(i));
+            reactors[i]->run();
+        });
+    }
+    for (std::thread& t : threads) {
+        t.join();
+    }
+}
+
+/**
+ * @brief Returns the number of reactors.
+ */
+unsigned ReactorPool::size() const {
+    return static_cast<unsigned>(reactors.size());
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include <thread>
+#include "server.h"
+
+/**
+ * @brief Multi-reactor mode: N independent Server event loops, one per thread.
+ * @details Every reactor owns its own listening socket bound with SO_REUSEPORT, its own
+ *          clients map and poller, and logs into its own sink (log/reactor-<i>/), so the
+ *          threads share no mutable state and the kernel shards connections between them.
+ *          Platforms without SO_REUSEPORT fall back to a single reactor.
+ */
+class ReactorPool {
+public:
+    // Creates `count` reactors listening on ip:port (0 = one per hardware thread)
+    ReactorPool(const std::string& ip, int port, unsigned count, IoEngine engine = IoEngine::Poll);
+
+    // Runs every reactor on its own thread and blocks until they all return
+    void run();
+
+    // Returns the number of reactors that will run
+    unsigned size() const;
+
+private:
+    std::vector<std::unique_ptr<Server>> reactors; // One server per event-loop thread
+};
@@ -0,0 +1,485 @@
+#include "request-parser.h"
+#include <cstring>
+#include <algorithm>
+#include <atomic>
+
+static constexpr size_t DEFAULT_BODY_LIMIT = 1024ull * 1024 * 1024; // Largest request body (1 GiB)
+static constexpr size_t DEFAULT_HEADER_LIMIT = 16 * 1024;           // Largest request line and headers
+
+static std::atomic<size_t> defaultBodyLimit(DEFAULT_BODY_LIMIT);
+static std::atomic<size_t> defaultHeaderLimit(DEFAULT_HEADER_LIMIT);
+
+/**
+ * @brief Returns true for the optional whitespace allowed around header values.
+ */
+static bool isOws(char c) {
+    return c == ' ' || c == '\t';
+}
+
+/**
+ * @brief Creates a parser positioned at the start of a message.
+ */
+RequestParser::RequestParser()
+    : bodyLimit(defaultBodyLimit.load(std::memory_order_relaxed)), headerLimit(defaultHeaderLimit.load(std::memory_order_relaxed)) {
+    reset();
+}
+
+/**
+ * @brief Sets the body limit used by parsers created afterwards.
+ * @param limit Largest accepted body in bytes
+ */
+void RequestParser::setDefaultBodyLimit(size_t limit) {
+    defaultBodyLimit.store(limit, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Sets the header limit used by parsers created afterwards.
+ * @details Bounds what a client trickling an endless header section can make the server
+ *          buffer; the same bound applies to each chunk-size and trailer line.
+ * @param limit Largest accepted request line and header section in bytes
+ */
+void RequestParser::setDefaultHeaderLimit(size_t limit) {
+    defaultHeaderLimit.store(limit, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Prepares for the next message.
+ * @details Pipelined messages are parsed in place by passing the end of the previous one;
+ *          after the consumed bytes are erased from the buffer, parsing restarts at 0.
+ * @param start Offset of the next message in the buffer
+ */
+void RequestParser::reset(size_t start) {
+    state = State::RequestLine;
+    pos = start;
+    messageStart = start;
+    lineStart = start;
+    method = target = version = Span{ 0, 0 };
+    headerCount = 0;
+    bodyStart = 0;
+    contentLength = 0;
+    messageLength = 0;
+    chunkRemaining = 0;
+    decodedLength = 0;
+    bodyReleased = 0;
+    contentLengthSeen = false;
+    chunked = false;
+    lastError = ParseError::None;
+}
+
+/**
+ * @brief Shifts every offset of the current message down by the bytes erased in front of it.
+ * @details Lets a parsed message that cannot be handled yet stay parsed while the messages
+ *          before it are consumed; parsing it again is not possible once a chunked body has
+ *          been decoded in place.
+ * @param dropped Bytes erased from the front of the buffer (all before the current message)
+ */
+void RequestParser::rebase(size_t dropped) {
+    auto shift = [dropped](Span& span) {
+        span.offset -= static_cast<uint32_t>(dropped);
+    };
+    shift(method);
+    shift(target);
+    shift(version);
+    for (size_t i = 0; i < headerCount; ++i) {
+        shift(headerNames[i]);
+        shift(headerValues[i]);
+    }
+    pos -= dropped;
+    messageStart -= dropped;
+    lineStart -= dropped;
+    bodyStart -= dropped;
+    if (messageLength > 0) {
+        messageLength -= dropped;
+    }
+}
+
+/**
+ * @brief Scans the bytes that arrived since the previous call.
+ * @details Lines are located with memchr from the last position, so each byte is visited once.
+ *          Empty lines before the request line are ignored (RFC 9112 section 2.2). Chunk data
+ *          is moved to the end of the decoded body as it arrives (RFC 9112 section 7.1).
+ * @param data Client input buffer
+ * @param size Bytes in the buffer
+ * @return Incomplete, Complete or Error
+ */
+ParseStatus RequestParser::parse(char* data, size_t size) {
+    while (true) {
+        switch (state) {
+            case State::RequestLine:
+            case State::HeaderLine: {
+                size_t begin, end;
+                bool line = nextLine(data, size, begin, end);
+                if (pos - messageStart > headerLimit) {
+                    return fail(ParseError::HeadersTooLarge);
+                }
+                if (!line) {
+                    return ParseStatus::Incomplete;
+                }
+                if (state == State::RequestLine) {
+                    if (end == begin) {
+                        continue;
+                    }
+                    if (!parseRequestLine(data, begin, end)) {
+                        return fail();
+                    }
+                    state = State::HeaderLine;
+                }
+                else if (end == begin) {
+                    bodyStart = pos;
+                    messageLength = bodyStart + contentLength;
+                    if (chunked) {
+                        state = State::ChunkSize;
+                    }
+                    else {
+                        state = contentLength > 0 ? State::Body : State::Complete;
+                    }
+                }
+                else if (!parseHeaderLine(data, begin, end)) {
+                    return fail();
+                }
+                break;
+            }
+            case State::Body:
+                if (size - bodyStart < contentLength) {
+                    return ParseStatus::Incomplete;
+                }
+                state = State::Complete;
+                break;
+            case State::ChunkSize:
+            case State::ChunkEnd:
+            case State::Trailer: {
+                size_t begin, end;
+                if (!nextLine(data, size, begin, end)) {
+                    if (pos - lineStart > headerLimit) {
+                        return fail(); // A framing line that never ends
+                    }
+                    return ParseStatus::Incomplete;
+                }
+                if (state == State::ChunkSize) {
+                    if (!parseChunkSize(data, begin, end)) {
+                        return fail();
+                    }
+                    if (chunkRemaining > bodyLimit - bodyReleased - decodedLength) {
+                        return fail(ParseError::BodyTooLarge);
+                    }
+                    state = chunkRemaining > 0 ? State::ChunkData : State::Trailer;
+                }
+                else if (state == State::ChunkEnd) {
+                    if (end != begin) {
+                        return fail(); // Chunk data longer than its declared size
+                    }
+                    state = State::ChunkSize;
+                }
+                else if (end == begin) {
+                    contentLength = decodedLength;
+                    messageLength = pos;
+                    state = State::Complete;
+                }
+                break;
+            }
+            case State::ChunkData: {
+                size_t length = (std::min)(size - pos, chunkRemaining);
+                if (length == 0) {
+                    return ParseStatus::Incomplete;
+                }
+                size_t target = bodyStart + decodedLength;
+                if (target != pos) {
+                    std::memmove(data + target, data + pos, length);
+                }
+                decodedLength += length;
+                chunkRemaining -= length;
+                pos = lineStart = pos + length;
+                if (chunkRemaining == 0) {
+                    state = State::ChunkEnd;
+                }
+                break;
+            }
+            case State::Complete:
+                return ParseStatus::Complete;
+            case State::Error:
+                return ParseStatus::Error;
+        }
+    }
+}
+
+/**
+ * @brief Returns the status of the last parse().
+ */
+ParseStatus RequestParser::status() const {
+    if (state == State::Complete) {
+        return ParseStatus::Complete;
+    }
+    return state == State::Error ? ParseStatus::Error : ParseStatus::Incomplete;
+}
+
+/**
+ * @brief Returns why the last parse() returned Error (None otherwise).
+ */
+ParseError RequestParser::error() const {
+    return lastError;
+}
+
+/**
+ * @brief Returns true once the empty line ending the headers has been seen.
+ */
+bool RequestParser::headersComplete() const {
+    return state != State::RequestLine && state != State::HeaderLine && state != State::Error;
+}
+
+/**
+ * @brief Returns the request target (path and query) as a view into the buffer.
+ * @details Cheaper than request() when only the target is needed, e.g. for the access log.
+ * @param buffer Buffer that was parsed, from the start of the message to the end of its headers unchanged
+ */
+std::string_view RequestParser::requestTarget(std::string_view buffer) const {
+    return std::string_view(buffer.data() + target.offset, target.length);
+}
+
+/**
+ * @brief Fills a Request with views into the buffer.
+ * @param buffer Buffer that was parsed (not modified since)
+ * @param out Request to fill
+ */
+void RequestParser::request(std::string_view buffer, Request& out) const {
+    auto view = [&buffer](Span span) {
+        return std::string_view(buffer.data() + span.offset, span.length);
+    };
+    out.method = view(method);
+    std::string_view fullTarget = view(target);
+    size_t query = fullTarget.find('?');
+    out.path = fullTarget.substr(0, query);
+    out.query = query == std::string_view::npos ? std::string_view() : fullTarget.substr(query + 1);
+    out.version = view(version);
+    out.headers.clear();
+    for (size_t i = 0; i < headerCount; ++i) {
+        out.headers.add(view(headerNames[i]), view(headerValues[i]));
+    }
+    out.body = std::string_view(buffer.data() + bodyStart, contentLength);
+}
+
+/**
+ * @brief Returns the offset just past the complete message.
+ * @details For a chunked body this is past the last chunk and trailers, beyond the decoded body.
+ */
+size_t RequestParser::messageEnd() const {
+    return messageLength;
+}
+
+/**
+ * @brief Returns the offset of the first unreleased body byte (0 after releaseBody()).
+ */
+size_t RequestParser::bodyOffset() const {
+    return bodyStart;
+}
+
+/**
+ * @brief Returns the body bytes ready at bodyOffset().
+ * @param size Bytes in the buffer passed to parse()
+ * @return Buffered Content-Length bytes, or decoded chunk data
+ */
+size_t RequestParser::bodyBuffered(size_t size) const {
+    if (state == State::Body) {
+        return (std::min)(size - bodyStart, contentLength);
+    }
+    if (state == State::Complete) {
+        return contentLength;
+    }
+    return chunked && headersComplete() ? decodedLength : 0;
+}
+
+/**
+ * @brief Hands body bytes on, so the buffer only ever holds the part not yet released.
+ * @details Every offset is rebased onto the byte after the released ones; Content-Length and
+ *          the decoded length shrink to what is still to come.
+ * @param length Body bytes released (at most bodyBuffered())
+ * @return Bytes to drop from the front of the buffer (head plus released body)
+ */
+size_t RequestParser::releaseBody(size_t length) {
+    size_t dropped = bodyStart + length;
+    if (state == State::Body || state == State::Complete) {
+        contentLength -= length;
+    }
+    else {
+        decodedLength -= length;
+    }
+    bodyReleased += length;
+    pos = pos > dropped ? pos - dropped : 0;
+    lineStart = lineStart > dropped ? lineStart - dropped : 0;
+    messageLength = messageLength > dropped ? messageLength - dropped : 0; // Only final once Complete
+    bodyStart = 0;
+    headerCount = 0;
+    method = target = version = Span{ 0, 0 };
+    return dropped;
+}
+
+/**
+ * @brief Locates the next line starting at lineStart.
+ * @param data Buffer start
+ * @param size Bytes in the buffer
+ * @param begin Receives the first byte of the line
+ * @param end Receives the end of the line (CR and LF excluded)
+ * @return False if no full line is buffered yet (pos moves to the end of the buffer)
+ */
+bool RequestParser::nextLine(const char* data, size_t size, size_t& begin, size_t& end) {
+    const void* newline = pos < size ? std::memchr(data + pos, '\n', size - pos) : nullptr;
+    if (newline == nullptr) {
+        pos = size;
+        return false;
+    }
+    begin = lineStart;
+    end = static_cast<const char*>(newline) - data;
+    pos = lineStart = end + 1;
+    if (end > begin && data[end - 1] == '\r') {
+        end--;
+    }
+    return true;
+}
+
+/**
+ * @brief Parses "hex-size[;extensions]" (extensions are ignored).
+ * @param data Buffer start
+ * @param begin First byte of the line
+ * @param end End of the line (CRLF excluded)
+ * @return False if the size is missing, not hexadecimal or too large
+ */
+bool RequestParser::parseChunkSize(const char* data, size_t begin, size_t end) {
+    size_t length = 0;
+    size_t i = begin;
+    for (; i < end; ++i) {
+        char c = data[i];
+        int digit;
+        if (c >= '0' && c <= '9') {
+            digit = c - '0';
+        }
+        else if (c >= 'a' && c <= 'f') {
+            digit = c - 'a' + 10;
+        }
+        else if (c >= 'A' && c <= 'F') {
+            digit = c - 'A' + 10;
+        }
+        else {
+            break;
+        }
+        if (length > (SIZE_MAX >> 4)) {
+            return false;
+        }
+        length = (length << 4) | static_cast<size_t>(digit);
+    }
+    while (i < end && isOws(data[i])) {
+        i++;
+    }
+    if (i == begin || (i < end && data[i] != ';') || length > SIZE_MAX - decodedLength) {
+        return false;
+    }
+    chunkRemaining = length;
+    return true;
+}
+
+/**
+ * @brief Parses "METHOD target HTTP/x.y".
+ * @param data Buffer start
+ * @param begin First byte of the line
+ * @param end End of the line (CRLF excluded)
+ * @return False if the line does not have exactly three non-empty fields
+ */
+bool RequestParser::parseRequestLine(const char* data, size_t begin, size_t end) {
+    const char* line = data + begin;
+    size_t length = end - begin;
+    const char* sp1 = static_cast<const char*>(std::memchr(line, ' ', length));
+    if (sp1 == nullptr || sp1 == line) {
+        return false;
+    }
+    size_t targetStart = sp1 - data + 1;
+    const char* sp2 = static_cast<const char*>(std::memchr(data + targetStart, ' ', end - targetStart));
+    if (sp2 == nullptr || static_cast<size_t>(sp2 - data) == targetStart) {
+        return false;
+    }
+    size_t versionStart = sp2 - data + 1;
+    if (end - versionStart < 8 || std::memcmp(data + versionStart, "HTTP/", 5) != 0
+        || std::memchr(data + versionStart, ' ', end - versionStart) != nullptr) {
+        return false;
+    }
+    method = Span{ static_cast<uint32_t>(begin), static_cast<uint32_t>(sp1 - line) };
+    target = Span{ static_cast<uint32_t>(targetStart), static_cast<uint32_t>(sp2 - data - targetStart) };
+    version = Span{ static_cast<uint32_t>(versionStart), static_cast<uint32_t>(end - versionStart) };
+    return true;
+}
+
+/**
+ * @brief Parses "Name: value" and records Content-Length and Transfer-Encoding.
+ * @param data Buffer start
+ * @param begin First byte of the line
+ * @param end End of the line (CRLF excluded)
+ * @return False if malformed, folded, over MAX_HEADERS, with an invalid Content-Length or
+ *         with a Transfer-Encoding other than chunked
+ */
+bool RequestParser::parseHeaderLine(const char* data, size_t begin, size_t end) {
+    if (isOws(data[begin]) || headerCount == HeaderList::MAX_HEADERS) {
+        return false; // Obsolete line folding is rejected (RFC 9112 section 5.2)
+    }
+    const char* colon = static_cast<const char*>(std::memchr(data + begin, ':', end - begin));
+    if (colon == nullptr) {
+        return false;
+    }
+    size_t nameEnd = colon - data;
+    while (nameEnd > begin && isOws(data[nameEnd - 1])) {
+        nameEnd--;
+    }
+    if (nameEnd == begin) {
+        return false;
+    }
+    size_t valueStart = colon - data + 1;
+    while (valueStart < end && isOws(data[valueStart])) {
+        valueStart++;
+    }
+    size_t valueEnd = end;
+    while (valueEnd > valueStart && isOws(data[valueEnd - 1])) {
+        valueEnd--;
+    }
+    std::string_view name(data + begin, nameEnd - begin);
+    std::string_view value(data + valueStart, valueEnd - valueStart);
+    if (equalsIgnoreCase(name, "Content-Length")) {
+        if (value.empty()) {
+            return false;
+        }
+        size_t length = 0;
+        for (char c : value) {
+            if (c < '0' || c > '9' || length > (SIZE_MAX - 9) / 10) {
+                return false;
+            }
+            length = length * 10 + static_cast<size_t>(c - '0');
+        }
+        if ((contentLengthSeen && contentLength != length) || chunked) {
+            return false; // Conflicting lengths (RFC 9112 section 6.3)
+        }
+        if (length > bodyLimit) {
+            lastError = ParseError::BodyTooLarge;
+            return false;
+        }
+        contentLength = length;
+        contentLengthSeen = true;
+    }
+    else if (equalsIgnoreCase(name, "Transfer-Encoding")) {
+        // Only "chunked" is supported; any other coding cannot be framed (RFC 9112 section 6.1)
+        if (!equalsIgnoreCase(value, "chunked") || chunked || contentLengthSeen) {
+            return false;
+        }
+        chunked = true;
+    }
+    headerNames[headerCount] = Span{ static_cast<uint32_t>(begin), static_cast<uint32_t>(nameEnd - begin) };
+    headerValues[headerCount] = Span{ static_cast<uint32_t>(valueStart), static_cast<uint32_t>(valueEnd - valueStart) };
+    headerCount++;
+    return true;
+}
+
+/**
+ * @brief Enters the error state.
+ * @param reason Error reported by error(), unless a more specific one was already recorded
+ */
+ParseStatus RequestParser::fail(ParseError reason) {
+    state = State::Error;
+    if (lastError == ParseError::None) {
+        lastError = reason;
+    }
+    return ParseStatus::Error;
+}
@@ -0,0 +1,131 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <cstddef>
+#include <cstdint>
+#include "request.h"
+
+/**
+ * @brief Result of feeding buffered bytes to a RequestParser.
+ */
+enum class ParseStatus {
+    Incomplete, // More bytes are needed
+    Complete,   // A whole message (headers and body) is buffered
+    Error       // The message is malformed; the connection should be answered with 400 and closed
+};
+
+/**
+ * @brief Why the last parse() returned Error.
+ */
+enum class ParseError : uint8_t {
+    None,           // No error
+    Malformed,      // The message cannot be framed (400)
+    BodyTooLarge,   // The body exceeds the configured limit (413)
+    HeadersTooLarge // The request line and headers exceed the configured limit (431)
+};
+
+/**
+ * @brief Resumable HTTP/1.1 request parser.
+ * @details Works directly on the client's input buffer and remembers how far it got, so every
+ *          byte is examined once no matter how many recv() calls a request spans. Fields are
+ *          recorded as offsets (the buffer may reallocate while it grows) and turned into
+ *          string_views by request(). Message completion is detected in the same pass, and
+ *          nothing is allocated. A chunked body is decoded in place: each chunk's data is moved
+ *          down over the framing that preceded it as it arrives, so the decoded body ends up
+ *          contiguous right after the headers and the bytes behind it are simply consumed
+ *          with the message.
+ */
+class RequestParser {
+public:
+    // Creates a parser positioned at the start of a message, with the default body and header limits
+    RequestParser();
+
+    // Sets the body limit of parsers created afterwards (bytes, decoded for chunked bodies)
+    static void setDefaultBodyLimit(size_t limit);
+    // Sets the limit of parsers created afterwards on the request line and headers (bytes)
+    static void setDefaultHeaderLimit(size_t limit);
+
+    // Scans the bytes of buffer not seen yet, starting from the message set by reset();
+    // chunked bodies are decoded in place, so the buffer must be writable
+    ParseStatus parse(char* buffer, size_t size);
+    // Returns the status of the last parse()
+    ParseStatus status() const;
+    // Returns why the last parse() failed
+    ParseError error() const;
+    // Returns true once the header section of the current message has been parsed
+    bool headersComplete() const;
+    // Builds the parsed request as views into buffer (only valid after Complete)
+    void request(std::string_view buffer, Request& out) const;
+    // Returns the request target as a view into buffer (valid from headersComplete() until releaseBody())
+    std::string_view requestTarget(std::string_view buffer) const;
+    // Returns the offset just past the complete message (headers and body); for a Content-Length
+    // body it is known as soon as the headers are
+    size_t messageEnd() const;
+    // Prepares for the next message, which starts at offset start of the buffer
+    void reset(size_t start = 0);
+    // Keeps the current message after the dropped bytes in front of it were erased from the buffer
+    void rebase(size_t dropped);
+
+    // Streaming bodies: once headersComplete(), body bytes can be handed on as they arrive
+    // instead of accumulating. After the first releaseBody() the head is gone and request()
+    // must not be called again for this message.
+    //
+    // Returns the offset of the first buffered body byte not yet released
+    size_t bodyOffset() const;
+    // Returns the (decoded) body bytes buffered at bodyOffset() for a buffer of size bytes
+    size_t bodyBuffered(size_t size) const;
+    // Forgets the head and the first length buffered body bytes; returns how many bytes the
+    // caller must now drop from the front of the buffer
+    size_t releaseBody(size_t length);
+
+private:
+    // Parser position within a message
+    enum class State {
+        RequestLine, // Reading "METHOD target VERSION"
+        HeaderLine,  // Reading header fields until the empty line
+        Body,        // Waiting for Content-Length body bytes
+        ChunkSize,   // Reading a chunk-size line
+        ChunkData,   // Moving chunk data down to the end of the decoded body
+        ChunkEnd,    // Reading the CRLF after chunk data
+        Trailer,     // Reading trailer fields until the empty line (discarded)
+        Complete,
+        Error
+    };
+
+    // Byte range within the buffer
+    struct Span {
+        uint32_t offset;
+        uint32_t length;
+    };
+
+    State state;                                // Current parser state
+    size_t pos;                                 // Next unexamined byte
+    size_t messageStart;                        // Offset the message starts at, set by reset()
+    size_t lineStart;                           // Start of the line being read
+    Span method, target, version;               // Request line fields
+    Span headerNames[HeaderList::MAX_HEADERS];  // Header field names
+    Span headerValues[HeaderList::MAX_HEADERS]; // Header field values (trimmed)
+    size_t headerCount;                         // Headers recorded
+    size_t bodyStart;                           // First body byte
+    size_t contentLength;                       // Declared body length (decoded length once a chunked body completes)
+    size_t messageLength;                       // Offset just past the message, set when it completes
+    size_t chunkRemaining;                      // Data bytes left in the current chunk
+    size_t decodedLength;                       // Chunk data bytes decoded and not yet released
+    size_t bodyReleased;                        // Body bytes handed on by releaseBody()
+    size_t bodyLimit;                           // Largest body accepted
+    size_t headerLimit;                         // Largest request line and header section accepted
+    bool contentLengthSeen;                     // A Content-Length header was parsed (it may be 0)
+    bool chunked;                               // Transfer-Encoding: chunked
+    ParseError lastError;                       // Reason for the Error state
+
+    // Parses one request line [begin, end); returns false if malformed
+    bool parseRequestLine(const char* data, size_t begin, size_t end);
+    // Parses one header line [begin, end); returns false if malformed or over the limit
+    bool parseHeaderLine(const char* data, size_t begin, size_t end);
+    // Parses a chunk-size line [begin, end) into chunkRemaining; returns false if malformed
+    bool parseChunkSize(const char* data, size_t begin, size_t end);
+    // Finds the next line from pos; returns false if it is not complete yet
+    bool nextLine(const char* data, size_t size, size_t& begin, size_t& end);
+    // Moves to the error state and returns Error
+    ParseStatus fail(ParseError reason = ParseError::Malformed);
+};
@@ -1,68 +1,129 @@
 #include "request.h"
 
 /**
- * @brief Constructs a Request from a raw HTTP request string
- * @param raw Raw HTTP request string
+ * @brief Compares two strings ignoring ASCII case
+ * @param a First string
+ * @param b Second string
+ * @return True if both have the same length and letters
  */
-Request::Request(const std::string& raw) {
-    std::istringstream stream(raw);
-    std::string line;
-
-    // Parse request line
-    if (!std::getline(stream, line) || line.empty()) {
-        return;
+bool equalsIgnoreCase(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) {
+        return false;
     }
-    std::istringstream reqLine(line);
-    reqLine >> method >> path >> version;
-
-    // Parse query string
-    auto qpos = path.find('?');
-    if (qpos != std::string::npos) {
-        query = path.substr(qpos + 1);
-        path = path.substr(0, qpos);
+    for (size_t i = 0; i < a.size(); ++i) {
+        char x = a[i];
+        char y = b[i];
+        if (x >= 'A' && x <= 'Z') {
+            x = static_cast<char>(x - 'A' + 'a');
+        }
+        if (y >= 'A' && y <= 'Z') {
+            y = static_cast<char>(y - 'A' + 'a');
+        }
+        if (x != y) {
+            return false;
+        }
     }
+    return true;
+}
 
-    // Parse headers
-    while (std::getline(stream, line) && line != "\r" && !line.empty()) {
-        auto colon = line.find(':');
-        if (colon != std::string::npos) {
-            std::string key = trim(line.substr(0, colon));
-            std::string value = trim(line.substr(colon + 1));
-            if (!value.empty() && value.back() == '\r') {
-                value.pop_back();
-            }
-            headers[key] = value;
-        }
+/**
+ * @brief Appends a header
+ * @param name Field name
+ * @param value Field value
+ * @return False if MAX_HEADERS fields are already stored
+ */
+bool HeaderList::add(std::string_view name, std::string_view value) {
+    if (count == MAX_HEADERS) {
+        return false;
     }
+    items[count++] = Header{ name, value };
+    return true;
+}
 
-    // Parse body (if any)
-    std::ostringstream bodyStream;
-    while (std::getline(stream, line)) {
-        if (!body.empty()) {
-            bodyStream << "\n";
+/**
+ * @brief Finds a header by name
+ * @param name Field name (case-insensitive)
+ * @return First matching header, or nullptr
+ */
+const Header* HeaderList::find(std::string_view name) const {
+    for (size_t i = 0; i < count; ++i) {
+        if (equalsIgnoreCase(items[i].name, name)) {
+            return &items[i];
         }
-        bodyStream << line;
     }
-    body = bodyStream.str();
+    return nullptr;
+}
+
+/**
+ * @brief Gets a header value by name
+ * @param name Field name (case-insensitive)
+ * @return Value, or an empty view if the header is absent
+ */
+std::string_view HeaderList::get(std::string_view name) const {
+    const Header* header = find(name);
+    return header ? header->value : std::string_view();
+}
+
+/**
+ * @brief Removes every header
+ */
+void HeaderList::clear() {
+    count = 0;
 }
 
 /**
  * @brief Gets the value of a query parameter by key
  * @param key Query parameter key
- * @return Value of the query parameter, or empty string if not found
+ * @return Value of the query parameter, or empty view if not found
+ */
+std::string_view Request::getQparams(std::string_view key) const {
+    std::string_view rest = query;
+    while (!rest.empty()) {
+        size_t amp = rest.find('&');
+        std::string_view pair = rest.substr(0, amp);
+        rest = amp == std::string_view::npos ? std::string_view() : rest.substr(amp + 1);
+        size_t eq = pair.find('=');
+        if (eq != std::string_view::npos && pair.substr(0, eq) == key) {
+            return pair.substr(eq + 1);
+        }
+    }
+    return std::string_view();
+}
+
+/**
+ * @brief Appends a route parameter
+ * @param name Parameter name
+ * @param value Captured value
+ * @return False if MAX_PARAMS parameters are already stored
+ */
+bool RouteParams::add(std::string_view name, std::string_view value) {
+    if (count == MAX_PARAMS) {
+        return false;
+    }
+    items[count++] = RouteParam{ name, value };
+    return true;
+}
+
+/**
+ * @brief Gets a route parameter by name
+ * @param name Parameter name (case-sensitive)
+ * @return Value, or an empty view if the parameter is absent
  */
-std::string Request::getQparams(const std::string& key) const {
-    std::istringstream qs(query);
-    std::string pair;
-    while (std::getline(qs, pair, '&')) {
-        auto eq = pair.find('=');
-        if (eq != std::string::npos) {
-            std::string k = pair.substr(0, eq);
-            std::string v = pair.substr(eq + 1);
-            if (k == key) {
-                return v;
-            }
+std::string_view RouteParams::get(std::string_view name) const {
+    for (size_t i = 0; i < count; ++i) {
+        if (items[i].name == name) {
+            return items[i].value;
         }
     }
-    return "";
-}
\ No newline at end of file
+    return std::string_view();
+}
+
+/**
+ * @brief Drops the parameters after the first newCount
+ * @param newCount Parameters to keep
+ */
+void RouteParams::truncate(size_t newCount) {
+    if (newCount < count) {
+        count = newCount;
+    }
+}
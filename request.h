@@ -1,34 +1,102 @@
 #pragma once
 #include <string>
-#include <map>
-#include <sstream>
-#include <algorithm>
-#include <cctype>
-#include "utils.h"
+#include <string_view>
+#include <array>
+#include <cstddef>
 
 /**
- * @brief Represents an HTTP request and provides utilities for parsing and accessing its components.
- * @details Parses the raw HTTP request string into method, path, version, headers, and body.
+ * @brief A header field as it appears in the connection buffer.
+ */
+struct Header {
+    std::string_view name;  // Field name as sent (case preserved)
+    std::string_view value; // Field value without surrounding whitespace
+};
+
+/**
+ * @brief Fixed-capacity list of request headers.
+ * @details Stores views only, so building it never allocates. Lookups are case-insensitive.
+ */
+class HeaderList {
+public:
+    static constexpr size_t MAX_HEADERS = 64; // Requests with more fields are rejected
+
+    // Appends a header; returns false if the list is full
+    bool add(std::string_view name, std::string_view value);
+    // Returns the first header with this name (case-insensitive), or nullptr
+    const Header* find(std::string_view name) const;
+    // Returns the value of a header, or an empty view if it is absent
+    std::string_view get(std::string_view name) const;
+    // Removes every header
+    void clear();
+
+    const Header* begin() const { return items.data(); }
+    const Header* end() const { return items.data() + count; }
+    size_t size() const { return count; }
+
+private:
+    std::array<Header, MAX_HEADERS> items; // Header storage
+    size_t count = 0;                      // Headers in use
+};
+
+/**
+ * @brief A path parameter captured by the router.
+ */
+struct RouteParam {
+    std::string_view name;  // Parameter name from the route pattern (without ':' or '*')
+    std::string_view value; // Matched text from the request path
+};
+
+/**
+ * @brief Fixed-capacity list of route parameters.
+ * @details Filled by Router::find() with views into the route table and the request path.
+ */
+class RouteParams {
+public:
+    static constexpr size_t MAX_PARAMS = 8; // Deeper captures make a route fail to match
+
+    // Appends a parameter; returns false if the list is full
+    bool add(std::string_view name, std::string_view value);
+    // Returns the value of a parameter, or an empty view if it is absent
+    std::string_view get(std::string_view name) const;
+    // Drops parameters past the first count (used when a match backtracks)
+    void truncate(size_t count);
+    // Removes every parameter
+    void clear() { count = 0; }
+
+    const RouteParam* begin() const { return items.data(); }
+    const RouteParam* end() const { return items.data() + count; }
+    size_t size() const { return count; }
+
+private:
+    std::array<RouteParam, MAX_PARAMS> items; // Parameter storage
+    size_t count = 0;                         // Parameters in use
+};
+
+/**
+ * @brief Represents a parsed HTTP request.
+ * @details Filled in by RequestParser. Every field is a view into the client's input buffer,
+ *          so a Request is only valid until that buffer is modified.
  */
 class Request {
 public:
     // HTTP method (GET, POST, etc.)
-    std::string method;
+    std::string_view method;
     // Request path (e.g., /index)
-    std::string path;
+    std::string_view path;
     // HTTP version (e.g., HTTP/1.1)
-    std::string version;
+    std::string_view version;
     // Query string (e.g., key=value&foo=bar)
-    std::string query;
-    // Map of header fields
-    std::map<std::string, std::string> headers;
+    std::string_view query;
+    // Header fields
+    HeaderList headers;
     // Request body
-    std::string body;
-
-	// Constructs a Request from a raw HTTP request string
-    Request(const std::string& raw);
+    std::string_view body;
+    // Path parameters captured by the matched route
+    RouteParams params;
 
-	// Gets the value of a query parameter by key
-    std::string getQparams(const std::string& key) const;
+	// Gets the value of a query parameter by key (empty if absent)
+    std::string_view getQparams(std::string_view key) const;
 };
 
+// Compares two strings ignoring ASCII case
+bool equalsIgnoreCase(std::string_view a, std::string_view b);
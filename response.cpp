@@ -1,10 +1,12 @@
 #include "response.h"
+#include "blocking-pool.h"
+#include <charconv>
 
 /**
  * @brief Constructs a Response with default values
  * @details Default is 200 OK with empty body
  */
-Response::Response() : statusCode(200), statusMessage("OK"), body(""), bodyLength(0) {}
+Response::Response() : statusCode(200), statusMessage("OK"), body(""), bodyLength(0), fileOffset(0) {}
 
 /**
  * @brief Creates a 200 OK response with body
@@ -82,18 +84,230 @@ Response Response::internalError(const std::string& body) {
 }
 
 /**
- * @brief Converts the response to a raw HTTP string
- * @return HTTP response string
+ * @brief Creates a 413 Content Too Large response with body
+ * @param body Response body
+ * @return Response object
  */
-std::string Response::toString() const {
+Response Response::contentTooLarge(const std::string& body) {
+    Response response;
+    response.statusCode = 413;
+    response.statusMessage = "Content Too Large";
+    response.body = body;
+    response.bodyLength = body.size();
+    response.headers["Content-Type"] = "text/plain";
+    return response;
+}
+
+/**
+ * @brief Creates a 429 Too Many Requests response
+ * @param retryAfter Seconds after which the client may try again
+ * @return Response object
+ */
+Response Response::tooManyRequests(unsigned retryAfter) {
+    Response response;
+    response.statusCode = 429;
+    response.statusMessage = "Too Many Requests";
+    response.body = "Request rate limit exceeded";
+    response.bodyLength = response.body.size();
+    response.headers["Content-Type"] = "text/plain";
+    response.headers["Retry-After"] = std::to_string(retryAfter);
+    return response;
+}
+
+/**
+ * @brief Creates a 431 Request Header Fields Too Large response with body
+ * @param body Response body
+ * @return Response object
+ */
+Response Response::headerFieldsTooLarge(const std::string& body) {
+    Response response;
+    response.statusCode = 431;
+    response.statusMessage = "Request Header Fields Too Large";
+    response.body = body;
+    response.bodyLength = body.size();
+    response.headers["Content-Type"] = "text/plain";
+    return response;
+}
+
+/**
+ * @brief Creates a 304 Not Modified response
+ * @details Has no body and no Content-Length: the client reuses its stored copy.
+ * @param headerBlock Pre-serialized validator lines (ETag, Last-Modified, Vary)
+ * @return Response object
+ */
+Response Response::notModified(const std::string& headerBlock) {
+    Response response;
+    response.statusCode = 304;
+    response.statusMessage = "Not Modified";
+    response.rawHeaders = headerBlock;
+    return response;
+}
+
+/**
+ * @brief Creates a 416 Range Not Satisfiable response
+ * @param size Current length of the representation
+ * @return Response object
+ */
+Response Response::rangeNotSatisfiable(uint64_t size) {
+    Response response;
+    response.statusCode = 416;
+    response.statusMessage = "Range Not Satisfiable";
+    response.body = "Range not satisfiable";
+    response.bodyLength = response.body.size();
+    response.headers["Content-Type"] = "text/plain";
+    response.headers["Content-Range"] = "bytes */" + std::to_string(size);
+    return response;
+}
+
+/**
+ * @brief Creates a 405 Method Not Allowed response
+ * @param allow Methods the resource supports (Allow header value)
+ * @return Response object
+ */
+Response Response::methodNotAllowed(const std::string& allow) {
+    Response response;
+    response.statusCode = 405;
+    response.statusMessage = "Method Not Allowed";
+    response.body = "Method not allowed";
+    response.bodyLength = response.body.size();
+    response.headers["Content-Type"] = "text/plain";
+    response.headers["Allow"] = allow;
+    return response;
+}
+
+/**
+ * @brief Creates a 200 OK response whose body is sent straight from a file
+ * @param file Open file; the whole file is the body
+ * @param headerBlock Pre-serialized header lines (each ending in CRLF)
+ * @return Response object
+ */
+Response Response::fromFile(std::shared_ptr<FileHandle> file, const std::string& headerBlock) {
+    Response response;
+    response.statusCode = 200;
+    response.statusMessage = "OK";
+    response.bodyLength = static_cast<size_t>(file->size());
+    response.file = std::move(file);
+    response.rawHeaders = headerBlock;
+    return response;
+}
+
+/**
+ * @brief Creates a 200 OK response whose body is shared with the content cache
+ * @param bytes Cached file contents
+ * @param headerBlock Pre-serialized header lines (each ending in CRLF)
+ * @return Response object
+ */
+Response Response::fromCache(std::shared_ptr<const std::string> bytes, const std::string& headerBlock) {
+    Response response;
+    response.statusCode = 200;
+    response.statusMessage = "OK";
+    response.bodyLength = bytes->size();
+    response.sharedBody = std::move(bytes);
+    response.rawHeaders = headerBlock;
+    return response;
+}
+
+/**
+ * @brief Creates a 200 OK response whose body is produced while it is being sent
+ * @details The head goes out with Transfer-Encoding: chunked and each piece the producer
+ *          returns becomes one chunk, so sending starts before the body is complete.
+ * @param producer Body producer, called whenever the connection can take more
+ * @param contentType Content-Type header value
+ * @return Response object
+ */
+Response Response::streamed(BodyProducer producer, const std::string& contentType) {
+    Response response;
+    response.statusCode = 200;
+    response.statusMessage = "OK";
+    response.stream = std::move(producer);
+    response.headers["Content-Type"] = contentType;
+    return response;
+}
+
+/**
+ * @brief Creates a response that is only known once a blocking file operation has run.
+ * @details The server submits the job to the I/O pool, parks the connection and calls finish
+ *          on the reactor thread when work is done.
+ * @param work Blocking part, run on a pool thread (must not touch the request or the connection)
+ * @param finish Builds the real response from the request, parsed again from the connection buffer
+ * @return Placeholder response carrying the job
+ */
+Response Response::deferred(std::function<void()> work, std::function<Response(const Request&)> finish) {
+    Response response;
+    response.job = std::make_shared<BlockingJob>();
+    response.job->work = std::move(work);
+    response.job->finish = std::move(finish);
+    return response;
+}
 
-    std::ostringstream ss;
-    ss << "HTTP/1.1 " << statusCode << " " << statusMessage << "\r\n";
+/**
+ * @brief Appends a decimal number to a string
+ * @param out Destination
+ * @param value Number to format
+ */
+static void appendNumber(std::string& out, unsigned long long value) {
+    char digits[24];
+    auto result = std::to_chars(digits, digits + sizeof(digits), value);
+    out.append(digits, result.ptr);
+}
+
+/**
+ * @brief Serializes the status line and headers
+ * @details Writes straight into out, so a reused buffer with enough capacity costs no
+ *          allocation; the body is sent separately.
+ * @param out Destination, appended to
+ */
+void Response::serializeHead(std::string& out) const {
+    out.append("HTTP/1.1 ");
+    appendNumber(out, static_cast<unsigned long long>(statusCode));
+    out.push_back(' ');
+    out.append(statusMessage).append("\r\n");
     for (const auto& header : headers) {
-        ss << header.first << ": " << header.second << "\r\n";
+        out.append(header.first).append(": ").append(header.second).append("\r\n");
+    }
+    out.append(rawHeaders);
+    if (stream) {
+        out.append("Transfer-Encoding: chunked\r\n\r\n");
+        return;
+    }
+    if (statusCode == 304) {
+        out.append("\r\n"); // Content-Length would describe the stored representation, not this message
+        return;
+    }
+    out.append("Content-Length: ");
+    appendNumber(out, bodyLength);
+    out.append("\r\n\r\n");
+}
+
+/**
+ * @brief Turns a streamed body into a fixed-length one
+ * @details Used when the client cannot decode chunked transfer coding (HTTP/1.0).
+ */
+void Response::materialize() {
+    if (!stream) {
+        return;
+    }
+    while (stream(body)) {
     }
-    ss << "Content-Length: " << bodyLength << "\r\n";
-    ss << "\r\n";
-    ss << body;
-    return ss.str();
-}
\ No newline at end of file
+    stream = nullptr;
+    bodyLength = body.size();
+}
+
+/**
+ * @brief Returns the in-memory body
+ * @return sharedBody if set, body otherwise
+ */
+const std::string& Response::bodyData() const {
+    return sharedBody ? *sharedBody : body;
+}
+
+/**
+ * @brief Converts the response to a raw HTTP string
+ * @return HTTP response string
+ */
+std::string Response::toString() const {
+    std::string out;
+    serializeHead(out);
+    out.append(bodyData());
+    return out;
+}
@@ -2,6 +2,17 @@
 #include <string>
 #include <map>
 #include <sstream>
+#include <memory>
+#include <functional>
+#include <cstdint>
+#include "platform.h"
+
+// Produces a streamed response body: appends the next piece to out (at least one byte) and
+// returns true while more follows, or returns false once the body is complete (out may hold a last piece)
+using BodyProducer = std::function<bool(std::string& out)>;
+
+class Request;
+struct BlockingJob;
 
 /**
  * @brief Represents an HTTP response and provides utilities for constructing and formatting it.
@@ -19,6 +30,18 @@ class Response {
     std::string body;
     // Body length
     size_t bodyLength;
+    // File-backed body streamed with sendFile() instead of body (null = use body)
+    std::shared_ptr<FileHandle> file;
+    // Offset of the first body byte in file
+    uint64_t fileOffset;
+    // Body shared with the content cache, used instead of body when set
+    std::shared_ptr<const std::string> sharedBody;
+    // Pre-serialized header lines written verbatim after headers
+    std::string rawHeaders;
+    // Streamed body sent with chunked transfer coding as the connection drains (null = fixed length)
+    BodyProducer stream;
+    // Blocking file operation the response waits for; the server parks the connection until it ran (null = ready)
+    std::shared_ptr<BlockingJob> job;
 
     // Constructs a Response with default values
     Response();
@@ -35,8 +58,34 @@ class Response {
     static Response created(const std::string& body = "");
     // Creates a 500 Internal Server Error response with body
     static Response internalError(const std::string& body = "");
-    // Converts the response to a raw HTTP string
-
+    // Creates a 413 Content Too Large response
+    static Response contentTooLarge(const std::string& body = "");
+    // Creates a 429 Too Many Requests response asking the client to wait retryAfter seconds
+    static Response tooManyRequests(unsigned retryAfter);
+    // Creates a 431 Request Header Fields Too Large response
+    static Response headerFieldsTooLarge(const std::string& body = "");
+    // Creates a 304 Not Modified response carrying only the given validator header lines
+    static Response notModified(const std::string& headerBlock);
+    // Creates a 416 Range Not Satisfiable response for a representation of size bytes
+    static Response rangeNotSatisfiable(uint64_t size);
+    // Creates a 405 Method Not Allowed response listing the allowed methods
+    static Response methodNotAllowed(const std::string& allow);
+    // Creates a 200 OK response whose body is streamed from an open file, with pre-serialized header lines
+    static Response fromFile(std::shared_ptr<FileHandle> file, const std::string& headerBlock);
+    // Creates a 200 OK response from cached bytes and pre-serialized header lines
+    static Response fromCache(std::shared_ptr<const std::string> bytes, const std::string& headerBlock);
+    // Creates a 200 OK response whose body is pulled from producer piece by piece
+    static Response streamed(BodyProducer producer, const std::string& contentType);
+    // Creates a placeholder for a response built by finish once work has run on the blocking I/O pool
+    static Response deferred(std::function<void()> work, std::function<Response(const Request&)> finish);
 
+    // Appends the status line and headers (through the blank line) to out without allocating
+    // when out already has capacity
+    void serializeHead(std::string& out) const;
+    // Returns the in-memory body (sharedBody if set, body otherwise)
+    const std::string& bodyData() const;
+    // Runs a streamed body's producer to completion into body (for clients without chunked support)
+    void materialize();
+    // Converts the response to a raw HTTP string (headers only for file-backed or streamed bodies)
     std::string toString() const;
 };
\ No newline at end of file
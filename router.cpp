@@ -0,0 +1,302 @@
+#include "router.h"
+#include <algorithm>
+
+namespace {
+
+// Method tokens in enum order
+constexpr std::string_view METHOD_NAMES[METHOD_COUNT] = {
+    "GET", "HEAD", "POST", "PUT", "DELETE", "OPTIONS", "TRACE", "PATCH", "CONNECT"
+};
+
+constexpr size_t METHOD_TABLE_SIZE = 16; // Perfect hash table size (power of two)
+
+/**
+ * @brief Hashes a method token from its length and first two characters.
+ * @details Collision-free over METHOD_NAMES (checked at compile time below).
+ */
+constexpr size_t methodHash(std::string_view token) {
+    return (token.size() + (static_cast<size_t>(static_cast<unsigned char>(token[0])) << 3)
+        + static_cast<unsigned char>(token[1])) & (METHOD_TABLE_SIZE - 1);
+}
+
+// Slot contents of the method hash table
+struct MethodSlot {
+    std::string_view name;
+    Method method;
+};
+
+/**
+ * @brief Builds the method hash table at compile time.
+ */
+constexpr std::array<MethodSlot, METHOD_TABLE_SIZE> buildMethodTable() {
+    std::array<MethodSlot, METHOD_TABLE_SIZE> table{};
+    for (auto& slot : table) {
+        slot = MethodSlot{ std::string_view(), Method::Unknown };
+    }
+    for (size_t i = 0; i < METHOD_COUNT; ++i) {
+        table[methodHash(METHOD_NAMES[i])] = MethodSlot{ METHOD_NAMES[i], static_cast<Method>(i) };
+    }
+    return table;
+}
+
+/**
+ * @brief Returns true if every method landed in its own slot.
+ */
+constexpr bool isPerfect(const std::array<MethodSlot, METHOD_TABLE_SIZE>& table) {
+    size_t used = 0;
+    for (const auto& slot : table) {
+        used += slot.method != Method::Unknown ? 1 : 0;
+    }
+    return used == METHOD_COUNT;
+}
+
+constexpr std::array<MethodSlot, METHOD_TABLE_SIZE> METHOD_TABLE = buildMethodTable();
+static_assert(isPerfect(METHOD_TABLE), "methodHash() collides; adjust it for the new method");
+
+/**
+ * @brief Returns the segment of path starting at pos (after skipping slashes) and advances pos past it.
+ * @return Segment text, empty once the path is exhausted
+ */
+std::string_view nextSegment(std::string_view path, size_t& pos) {
+    while (pos < path.size() && path[pos] == '/') {
+        pos++;
+    }
+    size_t start = pos;
+    while (pos < path.size() && path[pos] != '/') {
+        pos++;
+    }
+    return path.substr(start, pos - start);
+}
+
+} // namespace
+
+/**
+ * @brief Maps a method token to its enum value.
+ * @details One hash and one comparison against the candidate token; methods are case-sensitive.
+ * @param token Method from the request line
+ * @return Method, or Method::Unknown
+ */
+Method parseMethod(std::string_view token) {
+    if (token.size() < 3 || token.size() > 7) {
+        return Method::Unknown;
+    }
+    const MethodSlot& slot = METHOD_TABLE[methodHash(token)];
+    return slot.name == token ? slot.method : Method::Unknown;
+}
+
+/**
+ * @brief Returns the token of a method.
+ * @param method Method
+ * @return Token, or an empty view for Method::Unknown
+ */
+std::string_view methodName(Method method) {
+    size_t index = static_cast<size_t>(method);
+    return index < METHOD_COUNT ? METHOD_NAMES[index] : std::string_view();
+}
+
+/**
+ * @brief Creates a router with an empty root node (the "/" route).
+ */
+Router::Router() {
+    addNode("");
+}
+
+/**
+ * @brief Registers a route.
+ * @param method Method the handler serves
+ * @param pattern Path pattern, e.g. "/echo", "/files/:name" or a trailing "*name" wildcard
+ * @param handler Handler called for matching requests
+ * @return False if a wildcard is not the last segment or the route already exists
+ */
+bool Router::add(Method method, std::string_view pattern, Handler handler) {
+    Route route;
+    route.handler = std::move(handler);
+    return insert(method, pattern, std::move(route));
+}
+
+/**
+ * @brief Registers a route served by a coroutine handler.
+ * @param method Method the handler serves
+ * @param pattern Path pattern, as for add()
+ * @param handler Coroutine started for matching requests
+ * @return False if a wildcard is not the last segment or the route already exists
+ */
+bool Router::addAsync(Method method, std::string_view pattern, AsyncHandler handler) {
+    Route route;
+    route.async = std::move(handler);
+    return insert(method, pattern, std::move(route));
+}
+
+/**
+ * @brief Adds the trie nodes of a pattern and stores its route.
+ * @param method Method the route serves
+ * @param pattern Path pattern
+ * @param route Handler to store
+ * @return False if a wildcard is not the last segment or the route already exists
+ */
+bool Router::insert(Method method, std::string_view pattern, Route route) {
+    if (method == Method::Unknown) {
+        return false;
+    }
+    uint32_t node = 0;
+    size_t pos = 0;
+    for (std::string_view segment = nextSegment(pattern, pos); !segment.empty(); segment = nextSegment(pattern, pos)) {
+        if (segment[0] == ':' || segment[0] == '*') {
+            bool isWildcard = segment[0] == '*';
+            uint32_t child = isWildcard ? nodes[node].wildcard : nodes[node].param;
+            if (child == NONE) {
+                child = addNode(segment.substr(1));
+                (isWildcard ? nodes[node].wildcard : nodes[node].param) = child;
+            }
+            else if (nodes[child].segment != segment.substr(1)) {
+                return false; // One parameter name per position keeps captures unambiguous
+            }
+            node = child;
+            if (isWildcard && pos < pattern.size() && !nextSegment(pattern, pos).empty()) {
+                return false;
+            }
+            continue;
+        }
+        uint32_t child = findChild(node, segment);
+        if (child == NONE) {
+            child = addNode(segment);
+            std::vector<uint32_t>& children = nodes[node].children;
+            auto it = std::lower_bound(children.begin(), children.end(), segment, [this](uint32_t index, std::string_view key) {
+                return nodes[index].segment < key;
+            });
+            children.insert(it, child);
+        }
+        node = child;
+    }
+    int32_t& slot = nodes[node].handlers[static_cast<size_t>(method)];
+    if (slot != NO_HANDLER) {
+        return false;
+    }
+    slot = static_cast<int32_t>(routes.size());
+    routes.push_back(std::move(route));
+    return true;
+}
+
+/**
+ * @brief Looks up the handler for a request.
+ * @param method Request method
+ * @param path Request path (without query)
+ * @param params Receives the captured parameters (views into path)
+ * @param route Receives the route when Found
+ * @return Found, MethodNotAllowed or NotFound
+ */
+Router::Match Router::find(Method method, std::string_view path, RouteParams& params, const Route*& route) const {
+    params.clear();
+    route = nullptr;
+    if (method == Method::Unknown) {
+        return Match::NotFound; // Unknown tokens are rejected by the caller before routing
+    }
+    uint32_t anyMatch = NONE;
+    uint32_t node = match(0, path, 0, method, params, anyMatch);
+    if (node != NONE) {
+        route = &routes[nodes[node].handlers[static_cast<size_t>(method)]];
+        return Match::Found;
+    }
+    params.clear();
+    return anyMatch != NONE ? Match::MethodNotAllowed : Match::NotFound;
+}
+
+/**
+ * @brief Lists the methods that have a route for a path.
+ * @param path Request path
+ * @return Comma-separated methods, empty if no route matches
+ */
+std::string Router::allowedMethods(std::string_view path) const {
+    std::string allow;
+    RouteParams params;
+    for (size_t i = 0; i < METHOD_COUNT; ++i) {
+        uint32_t anyMatch = NONE;
+        if (match(0, path, 0, static_cast<Method>(i), params, anyMatch) != NONE) {
+            if (!allow.empty()) {
+                allow += ", ";
+            }
+            allow += METHOD_NAMES[i];
+        }
+        params.clear();
+    }
+    return allow;
+}
+
+/**
+ * @brief Binary-searches a node's literal children.
+ */
+uint32_t Router::findChild(uint32_t node, std::string_view segment) const {
+    const std::vector<uint32_t>& children = nodes[node].children;
+    auto it = std::lower_bound(children.begin(), children.end(), segment, [this](uint32_t index, std::string_view key) {
+        return nodes[index].segment < key;
+    });
+    return it != children.end() && nodes[*it].segment == segment ? *it : NONE;
+}
+
+/**
+ * @brief Appends a node with no children or handlers.
+ */
+uint32_t Router::addNode(std::string_view segment) {
+    Node node;
+    node.segment = std::string(segment);
+    node.handlers.fill(NO_HANDLER);
+    nodes.push_back(std::move(node));
+    return static_cast<uint32_t>(nodes.size() - 1);
+}
+
+/**
+ * @brief Depth-first match of the remaining path, trying literal, parameter and wildcard children in turn.
+ * @param node Current node
+ * @param path Request path
+ * @param pos Offset of the next unmatched byte
+ * @param method Method the terminal node must serve
+ * @param params Captured parameters (rolled back when a branch fails)
+ * @param anyMatch Set to the first non-wildcard node that matches the whole path with any method
+ *                 (a catch-all "*name" route does not make other methods 405)
+ * @return Node serving method, or NONE
+ */
+uint32_t Router::match(uint32_t node, std::string_view path, size_t pos, Method method, RouteParams& params, uint32_t& anyMatch) const {
+    const Node& current = nodes[node];
+    size_t next = pos;
+    std::string_view segment = nextSegment(path, next);
+    if (segment.empty()) {
+        bool served = current.handlers[static_cast<size_t>(method)] != NO_HANDLER;
+        if (anyMatch == NONE && std::any_of(current.handlers.begin(), current.handlers.end(), [](int32_t slot) { return slot != NO_HANDLER; })) {
+            anyMatch = node;
+        }
+        if (served) {
+            return node;
+        }
+    }
+    else {
+        uint32_t child = findChild(node, segment);
+        if (child != NONE) {
+            uint32_t found = match(child, path, next, method, params, anyMatch);
+            if (found != NONE) {
+                return found;
+            }
+        }
+        if (current.param != NONE && params.size() < RouteParams::MAX_PARAMS) {
+            size_t mark = params.size();
+            params.add(nodes[current.param].segment, segment);
+            uint32_t found = match(current.param, path, next, method, params, anyMatch);
+            if (found != NONE) {
+                return found;
+            }
+            params.truncate(mark);
+        }
+    }
+    // A wildcard also matches an empty remainder ("/*path" serves "/")
+    if (current.wildcard != NONE && params.size() < RouteParams::MAX_PARAMS) {
+        const Node& wildcard = nodes[current.wildcard];
+        size_t start = pos;
+        while (start < path.size() && path[start] == '/') {
+            start++;
+        }
+        if (wildcard.handlers[static_cast<size_t>(method)] != NO_HANDLER) {
+            params.add(wildcard.segment, path.substr(start));
+            return current.wildcard;
+        }
+    }
+    return NONE;
+}
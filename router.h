@@ -0,0 +1,106 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <array>
+#include <functional>
+#include <cstdint>
+#include <cstddef>
+#include "request.h"
+#include "response.h"
+#include "task.h"
+
+/**
+ * @brief HTTP methods the router can dispatch on.
+ */
+enum class Method : uint8_t {
+    Get,
+    Head,
+    Post,
+    Put,
+    Delete,
+    Options,
+    Trace,
+    Patch,
+    Connect,
+    Unknown // Not a registered method token
+};
+
+static constexpr size_t METHOD_COUNT = static_cast<size_t>(Method::Unknown); // Dispatchable methods
+
+// Maps a method token to its enum value with a perfect hash (Unknown if it is not a known method)
+Method parseMethod(std::string_view token);
+
+// Returns the token of a method ("GET", ...)
+std::string_view methodName(Method method);
+
+/**
+ * @brief Route table mapping (method, path pattern) to handlers.
+ * @details Patterns are split into '/'-separated segments stored in a prefix trie. A segment
+ *          is literal text, ":name" (matches one segment) or "*name" (matches the rest of the
+ *          path, possibly empty, and must be last). Literal segments win over parameters,
+ *          which win over wildcards; a path falls back to the next candidate when the better
+ *          one has no handler for the request's method. Each trie node holds one handler slot
+ *          per method, so dispatch is a perfect-hash method lookup plus one binary search per
+ *          path segment, independent of the number of routes. Captured values are views into
+ *          the request path. Routes are registered once at startup; lookups never allocate.
+ *          A route holds either a plain handler, which returns the response right away, or a
+ *          coroutine handler, which the server resumes as what it awaits completes.
+ */
+class Router {
+public:
+    // Handler invoked with the request (route parameters in request.params)
+    using Handler = std::function<Response(const Request&)>;
+    // Coroutine handler; the request stays valid until the returned Task finishes
+    using AsyncHandler = std::function<Task<Response>(Request&)>;
+
+    // Handler registered for a method on a pattern (exactly one of the two is set)
+    struct Route {
+        Handler handler;     // Synchronous handler
+        AsyncHandler async;  // Coroutine handler
+    };
+
+    // Outcome of a lookup
+    enum class Match {
+        Found,            // A handler exists for the method
+        MethodNotAllowed, // The path matches, but not for this method
+        NotFound          // No route matches the path
+    };
+
+    // Creates a table with only the root node
+    Router();
+
+    // Registers handler for method on pattern; returns false if the pattern is malformed or taken
+    bool add(Method method, std::string_view pattern, Handler handler);
+    // Registers a coroutine handler for method on pattern; returns false if the pattern is malformed or taken
+    bool addAsync(Method method, std::string_view pattern, AsyncHandler handler);
+    // Finds the route for method and path, capturing parameters into params
+    Match find(Method method, std::string_view path, RouteParams& params, const Route*& route) const;
+    // Returns the methods registered for path as an Allow header value (e.g. "GET, HEAD")
+    std::string allowedMethods(std::string_view path) const;
+
+private:
+    static constexpr uint32_t NONE = UINT32_MAX; // Missing child
+    static constexpr int32_t NO_HANDLER = -1;    // Missing handler
+
+    // Trie node for one pattern segment
+    struct Node {
+        std::string segment;                         // Literal text, or the parameter name for ':' and '*' nodes
+        std::vector<uint32_t> children;              // Literal children, sorted by segment
+        uint32_t param = NONE;                       // ":name" child
+        uint32_t wildcard = NONE;                    // "*name" child
+        std::array<int32_t, METHOD_COUNT> handlers;  // Index into routes per method
+    };
+
+    std::vector<Node> nodes;       // Trie nodes, root first
+    std::vector<Route> routes;     // Registered handlers
+
+    // Registers route for method on pattern; returns false if the pattern is malformed or taken
+    bool insert(Method method, std::string_view pattern, Route route);
+    // Returns the literal child of node named segment, or NONE
+    uint32_t findChild(uint32_t node, std::string_view segment) const;
+    // Creates a node and returns its index
+    uint32_t addNode(std::string_view segment);
+    // Matches path from pos below node; returns the node with a handler for method (or NONE)
+    uint32_t match(uint32_t node, std::string_view path, size_t pos, Method method, RouteParams& params, uint32_t& anyMatch) const;
+};
@@ -1,49 +1,69 @@
 #include "server.h"
+#include "uring-engine.h"
+#include "content-cache.h"
 
 /**
- * @brief Server constructor: initializes Winsock and sets up the listening socket.
+ * @brief Server constructor: initializes the socket library and sets up the listening socket.
  * @param ip Server IP address
  * @param port Server port
  * @param bufferSize Buffer size for client data
+ * @param idleTimeout Idle timeout in seconds
+ * @param reusePort Share ip:port with other servers through SO_REUSEPORT
+ * @param ioEngine I/O engine driving the event loop
  */
-Server::Server(const std::string& ip, int port, std::size_t bufferSize, std::time_t idleTimeout)
-	: ip_(ip), port_(port), BUFF_SIZE(bufferSize), CLIENT_TIMEOUT(idleTimeout), iteration(0)
+Server::Server(const std::string& ip, int port, std::size_t bufferSize, std::time_t idleTimeout, bool reusePort, IoEngine ioEngine)
+	: ip_(ip), port_(port), BUFF_SIZE(bufferSize), CLIENT_TIMEOUT(idleTimeout), iteration(0), engine(ioEngine), loopTime(TimerWheel::now()), asyncSequence(0), acceptPending(false)
 {
-    WSAData wsaData;
-    if (NO_ERROR != WSAStartup(MAKEWORD(2, 2), &wsaData)) {
-        logError("Error at WSAStartup()", WSAGetLastError());
+    registerRoutes();
+    if (!socketStartup()) {
+        logError("Error at WSAStartup()", getSocketError());
         listenSocket = INVALID_SOCKET;
         return;
     }
     listenSocket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
     if (INVALID_SOCKET == listenSocket) {
-        logError("Error at socket()", WSAGetLastError());
-        WSACleanup();
+        logError("Error at socket()", getSocketError());
+        socketCleanup();
         return;
     }
+#ifndef _WIN32
+    // Allow quick restarts while old connections sit in TIME_WAIT
+    int reuse = 1;
+    setsockopt(listenSocket, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+#ifdef SO_REUSEPORT
+    // Each reactor owns its own listen socket; the kernel load-balances accepts between them
+    if (reusePort && SOCKET_ERROR == setsockopt(listenSocket, SOL_SOCKET, SO_REUSEPORT, &reuse, sizeof(reuse))) {
+        logError("Error at setsockopt(SO_REUSEPORT)", getSocketError());
+    }
+#endif
+#endif
     sockaddr_in serverService;
     serverService.sin_family = AF_INET;
     serverService.sin_addr.s_addr = inet_addr(ip_.c_str());
     serverService.sin_port = htons(port_);
     if (SOCKET_ERROR == bind(listenSocket, (SOCKADDR*)&serverService, sizeof(serverService))) {
-        logError("Error at bind()", WSAGetLastError());
-        WSACleanup();
+        logError("Error at bind()", getSocketError());
+        closesocket(listenSocket);
+        listenSocket = INVALID_SOCKET;
+        socketCleanup();
         return;
     }
 }
 
 /**
- * @brief Server destructor: cleans up all client connections and Winsock.
+ * @brief Server destructor: cleans up all client connections and the socket library.
  */
 Server::~Server() {
-    for (auto& kv : clients) {
-        closesocket(kv.first);
-    }
+    clients.forEach([this](Client& client) {
+        closesocket(client.socket);
+        admission.releaseConnection();
+    });
     clients.clear();
     if (listenSocket != INVALID_SOCKET) {
         closesocket(listenSocket);
     }
-    WSACleanup();
+    socketCleanup();
+    AccessLog::flush(); // Records still batched on this reactor's thread
     // Ensure all log files are closed (handled by ofstream destructors)
 }
 
@@ -52,285 +72,1562 @@ Server::~Server() {
  * @return True if successful, false otherwise
  */
 bool Server::listen() {
-    if (SOCKET_ERROR == ::listen(listenSocket, 5)) {
-        logError("Error at listen()", WSAGetLastError());
-        WSACleanup();
+    if (SOCKET_ERROR == ::listen(listenSocket, admission.limits().backlog)) {
+        logError("Error at listen()", getSocketError());
+        return false;
+    }
+    if (!setNonBlocking(listenSocket)) {
+        logError("Error at ioctlsocket()", getSocketError());
         return false;
     }
-    unsigned long flag = 1;
-    if (ioctlsocket(listenSocket, FIONBIO, &flag) != NO_ERROR) {
-        logError("Error at ioctlsocket()", WSAGetLastError());
-        WSACleanup();
+    if (engine == IoEngine::Poll && (!poller.isValid() || !poller.add(listenSocket, POLL_READ))) {
+        logError("Error registering listen socket with poller", getSocketError());
         return false;
     }
     return true;
 }
 
 /**
- * @brief Adds a new client to the clients map.
+ * @brief Adds a new client to the connection table and registers it with the poller.
+ * @details Connections over the connection cap, or arriving while the reactor sheds load,
+ *          are answered with a 503 and closed instead.
  * @param clientSocket Client socket
  * @param addr Client address
- * @return True if successful, false otherwise
+ * @return The new client, or nullptr on failure or refusal (the socket is closed)
  */
-bool Server::addClient(SOCKET clientSocket, const sockaddr_in& addr) {
-    unsigned long flag = 1;
-    if (ioctlsocket(clientSocket, FIONBIO, &flag) != NO_ERROR) {
+Client* Server::addClient(SOCKET clientSocket, const sockaddr_in& addr) {
+    if (!setNonBlocking(clientSocket)) {
         closesocket(clientSocket);
-        return false;
+        return nullptr;
     }
-    auto result = clients.emplace(
-        std::piecewise_construct,
-        std::forward_as_tuple(clientSocket),
-        std::forward_as_tuple(clientSocket, addr)
-    );
-    if (!result.second) {
+    if (admission.overloaded() || !admission.admitConnection()) {
+        refuseConnection(clientSocket);
+        return nullptr;
+    }
+    Client* added = clients.add(clientSocket, addr, &bufferPool);
+    if (added == nullptr) {
+        admission.releaseConnection();
         closesocket(clientSocket);
-        return false;
+        return nullptr;
     }
+    // Interest is registered once here and only modified on state changes
+    Client& client = *added;
+    client.interest = POLL_READ;
+    if (engine == IoEngine::Poll && !poller.add(clientSocket, client.interest)) {
+        logError("Error registering client with poller", getSocketError(), client.clientAddr);
+        clients.remove(clientSocket);
+        admission.releaseConnection();
+        closesocket(clientSocket);
+        return nullptr;
+    }
+    metrics.accepts.add();
+    metrics.openConnections.set(clients.size());
     // Log client connection to client state log file
-    logClientState(result.first->second.clientAddr, "None", "Connected");
-    return true;
+    logClientState(client.clientAddr, "None", "Connected");
+    updateTimeout(client);
+    if (!housekeeping.isLinked()) {
+        timers.schedule(housekeeping, loopTime + HOUSEKEEPING_INTERVAL_MS);
+    }
+    return added;
 }
 
 /**
- * @brief Dispatches the request to the appropriate handler and prepares the response.
+ * @brief Unregisters a client from the poller, closes its socket and erases it.
+ * @details Erasing the client also disarms its timer. While an io_uring send is in flight the
+ *          kernel may still read the queued responses, so the client is only aborted and shut
+ *          down here; the send then fails promptly and its completion removes the client.
+ * @param clientSocket Client socket
+ */
+void Server::removeClient(SOCKET clientSocket) {
+    Client* client = clients.find(clientSocket);
+    if (client != nullptr && client->sendInFlight) {
+        client->state = ClientState::Aborted;
+        client->timeout = TimeoutKind::None;
+        timers.cancel(client->timer);
+#ifndef _WIN32
+        shutdown(clientSocket, SHUT_RDWR);
+#endif
+        return;
+    }
+    if (client != nullptr && client->async && client->async->armed &&
+        (client->async->wait == AsyncWait::Readable || client->async->wait == AsyncWait::Writable)) {
+        // The handler's socket closes with its coroutine frame
+        abandonAsyncSocket(client->async->socket);
+    }
+    if (engine == IoEngine::Poll) {
+        poller.remove(clientSocket);
+    }
+#ifndef _WIN32
+    // Terminates I/O still queued on the socket (io_uring) before the descriptor goes away
+    shutdown(clientSocket, SHUT_RDWR);
+#endif
+    closesocket(clientSocket);
+    if (client != nullptr) {
+        admission.releaseConnection();
+    }
+    clients.remove(clientSocket);
+    metrics.openConnections.set(clients.size());
+}
+
+/**
+ * @brief Updates the poller interest to match the client's state.
+ * @details AwaitingRequest needs read events and ResponseReady needs write events as well as
+ *          read events for pipelined requests, so the poller is touched only when the client
+ *          moves between the two.
  * @param client Reference to client object
  */
-void Server::dispatch(Client& client) {
-    Request request(client.inBuffer); // Parse the buffered request
-    client.inBuffer.clear();
+void Server::updateInterest(Client& client) {
+    unsigned wanted = client.interest;
+    if (client.state == ClientState::AwaitingRequest || client.state == ClientState::AwaitingHandler) {
+        wanted = POLL_READ;
+    }
+    else if (client.state == ClientState::ResponseReady) {
+        wanted = POLL_READ | POLL_WRITE;
+    }
+    if (client.readPaused) {
+        wanted &= ~static_cast<unsigned>(POLL_READ);
+    }
+    if (wanted == client.interest) {
+        return;
+    }
+    if (!poller.modify(client.socket, wanted)) {
+        logError("Error updating poller interest", getSocketError(), client.clientAddr);
+        client.setAborted();
+        return;
+    }
+    client.interest = wanted;
+}
+
+/**
+ * @brief Pulls the next piece of a streamed body into out.body, framed as one chunk.
+ * @details The producer appends straight behind a fixed-width size line that is filled in
+ *          afterwards (chunk-size may have leading zeros), so the piece is never copied. The
+ *          last piece is followed by the zero-size chunk that ends the body.
+ * @param out Streamed response; its body is replaced
+ */
+static void produceChunk(OutboundResponse& out) {
+    static const char HEX[] = "0123456789abcdef";
+    std::string& body = out.body;
+    body.assign(CHUNK_HEADER_SIZE, '0');
+    bool more = out.stream(body);
+    size_t length = body.size() - CHUNK_HEADER_SIZE;
+    if (length == 0) {
+        body.clear();
+    }
+    else {
+        for (size_t i = 0; i < CHUNK_HEADER_SIZE - 2; ++i) {
+            body[CHUNK_HEADER_SIZE - 3 - i] = HEX[(length >> (4 * i)) & 0xF];
+        }
+        body[CHUNK_HEADER_SIZE - 2] = '\r';
+        body[CHUNK_HEADER_SIZE - 1] = '\n';
+        body.append("\r\n");
+    }
+    if (!more) {
+        body.append("0\r\n\r\n");
+        out.stream = nullptr;
+    }
+}
+
+/**
+ * @brief Dispatches every complete request in the input buffer and queues the responses in order.
+ * @details Pipelined requests are handled back to back until the buffer holds no complete
+ *          request, MAX_PIPELINE responses are queued, or a request asked to close the
+ *          connection. Consumed bytes are removed from inBuffer once, after the batch. A handler
+ *          that defers a file operation to the I/O pool, or a coroutine handler that suspends,
+ *          parks the client in AwaitingHandler with its request still in inBuffer; once it can
+ *          go on, dispatch() runs again and finishes that request first. A coroutine handler is
+ *          only started with nothing queued ahead of it: behind earlier responses its request
+ *          is held, parsed, until they are sent, and so is any request once the responses
+ *          queued ahead of it reach the per-connection memory limit.
+ * @param client Reference to client object
+ * @return True if at least one response was queued
+ */
+bool Server::dispatch(Client& client) {
+    size_t consumed = 0;
+    bool queued = false;
+    bool held = false;
+    while ((client.keepAlive || client.inRequest()) && client.outQueue.size() < MAX_PIPELINE) {
+        uint64_t started = metricsClockUs();
+        ParseStatus status = client.parser.parse(client.inBuffer.data(), client.inBuffer.size());
+        if (status == ParseStatus::Incomplete) {
+            break;
+        }
+        stampParse(client, status, started);
+        Request request; // Views into inBuffer, valid until it changes
+        Response response;
+        Method method = Method::Unknown;
+        bool http11 = false;
+        if (status == ParseStatus::Error) {
+            // The rest of the stream cannot be framed, so answer and close
+            client.keepAlive = false;
+            client.async.reset();
+            if (client.parser.error() == ParseError::BodyTooLarge) {
+                response = Response::contentTooLarge("Request body exceeds the limit");
+            }
+            else if (client.parser.error() == ParseError::HeadersTooLarge) {
+                response = Response::headerFieldsTooLarge("Request header section exceeds the limit");
+            }
+            else {
+                response = handleBadRequest("Malformed HTTP request");
+            }
+        }
+        else if (client.job) {
+            // The parked request's file operation is done: build its response
+            std::shared_ptr<BlockingJob> job = std::move(client.job);
+            if (!job->headReleased) {
+                client.parser.request(client.inBuffer.view(), request);
+            }
+            method = job->method;
+            started = job->startedUs;
+            http11 = request.version == "HTTP/1.1";
+            response = job->finish(request);
+        }
+        else if (client.async) {
+            // Coroutine handler: run it on until it returns or waits on something else
+            if (!client.async->task.done() && !runAsync(client)) {
+                break; // Parked: the message stays in inBuffer until the handler resumes
+            }
+            method = client.async->method;
+            started = client.async->startedUs;
+            http11 = client.async->request.version == "HTTP/1.1";
+            response = client.async->task.take();
+            client.async.reset();
+        }
+        else if (client.upload) {
+            // Streamed PUT: write what is left of the body and move the file into place
+            method = Method::Put;
+            response = writeUpload(client) ? completePut(std::move(client.upload)) : handleInternalError("Error writing file: " + client.upload->target());
+            client.upload.reset();
+        }
+        else {
+            client.parser.request(client.inBuffer.view(), request);
+            method = parseMethod(request.method);
+            const Router::Route* target = nullptr;
+            Router::Match match = router.find(method, request.path, request.params, target);
+            bool async = match == Router::Match::Found && target->async;
+            bool overBudget = client.outputBytes >= MemoryBudget::connectionLimit();
+            if ((async || overBudget) && !client.outQueue.empty()) {
+                held = true;
+                break;
+            }
+            bool admitted = admitRequest(client, response);
+            client.keepAlive = isKeepAlive(request);
+            client.requests++;
+            if (admitted && async) {
+                startAsync(client, *target, method, started);
+                continue; // Runs it through the coroutine branch
+            }
+            http11 = request.version == "HTTP/1.1";
+            if (admitted) {
+                response = route(request, method, match, target);
+            }
+        }
+        if (response.job && deferResponse(client, response, request, method, started)) {
+            break; // Parked: the message stays in inBuffer until the job is back
+        }
+        if (response.stream && !http11) {
+            response.materialize(); // Chunked transfer coding is HTTP/1.1 only
+        }
+        queueResponse(client, response, method, started);
+        consumed = status == ParseStatus::Error ? client.inBuffer.size() : client.parser.messageEnd();
+        client.parser.reset(consumed);
+        if (consumed < client.inBuffer.size()) {
+            client.access.firstByteUs = client.lastReadUs; // The next request's bytes are already here
+        }
+        queued = true;
+    }
+    if (consumed > 0) {
+        // Keep the bytes of any following request and restart the parser on them
+        client.inBuffer.consume(consumed);
+        if (held) {
+            client.parser.rebase(consumed); // Already parsed (a chunked body is decoded in place)
+        }
+        else {
+            client.parser.reset();
+        }
+    }
+    if (!client.outQueue.empty()) {
+        if (client.state != ClientState::ResponseReady) {
+            client.setResponseReady();
+        }
+    }
+    else if (client.state == ClientState::RequestBuffered) {
+        finishResponse(client);
+    }
+    return queued;
+}
+
+/**
+ * @brief Hands a handler's blocking file operation to the I/O pool and parks the client.
+ * @details Only a request with nothing queued ahead of it is parked, so the message is still
+ *          the first one in inBuffer and the parser keeps its offsets until the job is back.
+ *          Behind queued responses (or without a wakeup descriptor) the operation runs inline
+ *          and the response is built right away.
+ * @param client Reference to client object
+ * @param response Deferred response; replaced by the final one if the job ran inline
+ * @param request The request being answered
+ * @param method Request method, for the response counters
+ * @param startedUs metricsClockUs() when the request was dispatched
+ * @return True if the client was parked
+ */
+bool Server::deferResponse(Client& client, Response& response, const Request& request, Method method, uint64_t startedUs) {
+    std::shared_ptr<BlockingJob> job = std::move(response.job);
+    if (!client.outQueue.empty() || completions.handle() == -1) {
+        job->work();
+        response = job->finish(request);
+        return false;
+    }
+    job->client = client.timer.key;
+    job->method = method;
+    job->startedUs = startedUs;
+    job->completions = &completions;
+    metrics.blockingJobs.add();
+    BlockingPool::submit(std::move(job));
+    client.setAwaitingHandler();
+    return true;
+}
+
+/**
+ * @brief Moves the clients of the jobs the I/O pool finished back to RequestBuffered.
+ * @details Jobs whose connection was closed meanwhile are dropped, and jobs that belong to no
+ *          connection run their completion. Shared by the poll loop and the io_uring engine, which
+ *          pass the function that advances a client's FSM.
+ * @param advance Called for each client whose job is back
+ */
+void Server::finishJobs(const std::function<void(Client&)>& advance) {
+    finishedJobs.clear();
+    completions.drain(finishedJobs);
+    for (std::shared_ptr<BlockingJob>& job : finishedJobs) {
+        if (job->complete) {
+            job->complete();
+            continue;
+        }
+        Client* client = clients.get(job->client);
+        if (client == nullptr || client->state != ClientState::AwaitingHandler) {
+            continue;
+        }
+        if (job->finish) {
+            client->job = std::move(job);
+            client->setRequestBuffered();
+        }
+        else if (client->async) {
+            // A coroutine handler's runBlocking() is done
+            client->async->wait = AsyncWait::None;
+            resumeAsync(*client);
+        }
+        advance(*client);
+    }
+    finishedJobs.clear();
+}
+
+/**
+ * @brief Creates the coroutine of a coroutine handler for the request at the front of inBuffer.
+ * @details The head is copied so the handler's Request outlives changes to inBuffer; the body
+ *          stays there and is handed out by nextBodyChunk(). The coroutine starts suspended and
+ *          is first resumed by runAsync().
+ * @param client Client whose request headers are complete and start at offset 0 of inBuffer
+ * @param target Route holding the coroutine handler
+ * @param method Request method
+ * @param startedUs metricsClockUs() when the request was dispatched
+ */
+void Server::startAsync(Client& client, const Router::Route& target, Method method, uint64_t startedUs) {
+    std::shared_ptr<AsyncCall> call = std::make_shared<AsyncCall>();
+    call->head.assign(client.inBuffer.data(), client.parser.bodyOffset());
+    client.parser.request(call->head, call->request);
+    call->request.body = std::string_view();
+    const Router::Route* found = nullptr;
+    router.find(method, call->request.path, call->request.params, found); // Captures again, into the copy
+    call->method = method;
+    call->startedUs = startedUs;
+    call->task = target.async(call->request);
+    call->waiter = call->task.handle();
+    client.async = std::move(call);
+}
+
+/**
+ * @brief Starts a coroutine handler as soon as its request headers are in.
+ * @details The handler then reads the body with nextBodyChunk() while it arrives, so a large
+ *          body never piles up in inBuffer.
+ * @param client Client in AwaitingRequest whose request headers are complete
+ * @return True if the request is routed to a coroutine handler, which was started
+ */
+bool Server::beginAsync(Client& client) {
+    Request request;
+    client.parser.request(client.inBuffer.view(), request); // The body view is not complete and is not used
+    Method method = parseMethod(request.method);
+    const Router::Route* target = nullptr;
+    if (router.find(method, request.path, request.params, target) != Router::Match::Found || !target->async) {
+        return false;
+    }
     client.keepAlive = isKeepAlive(request);
-    Response response;
-
-    if (request.method == "GET") {
-		response = handleGet(request);
-    }
-    else if (request.method == "POST") {
-        response = handlePost(request);
-	}
-	else if (request.method == "HEAD") {
-		response = handleHead(request);
-	}
-    else if (request.method == "PUT") {
-        response = handlePut(request);
-	}
-    else if (request.method == "DELETE") {
-		response = handleDelete(request);
-	}
-	else if (request.method == "TRACE") {
-		response = handleTrace(request);
-    }
-    else if (request.method == "OPTIONS") {
-        response = handleOptions(request);
+    client.requests++;
+    Response refusal;
+    if (!admitRequest(client, refusal)) {
+        rejectRequest(client, refusal, method);
+        return true;
+    }
+    startAsync(client, *target, method, metricsClockUs());
+    return true;
+}
+
+/**
+ * @brief Resumes a coroutine handler until it returns or has to wait.
+ * @details Waits that can be satisfied right away (buffered body bytes, a blocking operation
+ *          without an I/O pool) are, and the handler is resumed again. Otherwise the client is
+ *          parked: in AwaitingRequest while the handler waits for body bytes, else in
+ *          AwaitingHandler, where updateTimeout() arms a sleep, the engine watches an awaited
+ *          socket and a blocking operation is handed to the I/O pool. Body bytes handed out are
+ *          released from inBuffer as soon as the handler suspends again.
+ * @param client Client with a coroutine handler
+ * @return True once the handler has returned its response
+ */
+bool Server::runAsync(Client& client) {
+    AsyncCall& call = *client.async;
+    while (!call.task.done()) {
+        switch (call.wait) {
+            case AsyncWait::None:
+                break;
+            case AsyncWait::BodyChunk:
+                if (!takeBodyChunk(client)) {
+                    return false;
+                }
+                break;
+            case AsyncWait::Blocking:
+                if (completions.handle() == -1 || !BlockingPool::enabled()) {
+                    call.work(); // No I/O pool: run it on the loop after all
+                    break;
+                }
+                if (!call.armed) {
+                    std::shared_ptr<BlockingJob> job = std::make_shared<BlockingJob>();
+                    job->work = std::move(call.work);
+                    job->owner = client.async; // The work may refer to the coroutine frame
+                    job->client = client.timer.key;
+                    job->completions = &completions;
+                    call.armed = true;
+                    metrics.blockingJobs.add();
+                    BlockingPool::submit(std::move(job));
+                }
+                [[fallthrough]];
+            default:
+                if (client.state != ClientState::AwaitingHandler) {
+                    client.setAwaitingHandler();
+                }
+                return false;
+        }
+        call.wait = AsyncWait::None;
+        AsyncCall::setCurrent(&call);
+        call.waiter.resume();
+        AsyncCall::setCurrent(nullptr);
+        if (call.chunkLength > 0) {
+            client.inBuffer.consume(client.parser.releaseBody(call.chunkLength));
+            call.chunkLength = 0;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Runs a coroutine handler on after a wake-up and moves the client on once it returns.
+ * @details A handler that returns after the whole request was received is answered through
+ *          dispatch(). One that returns before reading all of its body is answered right away
+ *          and the connection closed, since the rest of the body would have to be read first.
+ * @param client Client with a coroutine handler
+ */
+void Server::resumeAsync(Client& client) {
+    if (!runAsync(client)) {
+        return;
+    }
+    if (client.parser.parse(client.inBuffer.data(), client.inBuffer.size()) != ParseStatus::Incomplete) {
+        client.setRequestBuffered();
+        return;
+    }
+    Response response = client.async->task.take();
+    Method method = client.async->method;
+    client.async.reset();
+    rejectRequest(client, response, method);
+}
+
+/**
+ * @brief Hands the waiting handler the body bytes buffered so far.
+ * @details The parser is run first, as bytes may have arrived while the handler waited on
+ *          something else. An empty chunk tells the handler the body is complete.
+ * @param client Client whose handler waits for a body chunk
+ * @return False if no body bytes are buffered yet (the client then waits in AwaitingRequest),
+ *         or if the body is malformed (the client moves to RequestBuffered to be answered)
+ */
+bool Server::takeBodyChunk(Client& client) {
+    AsyncCall& call = *client.async;
+    ParseStatus status = client.parser.parse(client.inBuffer.data(), client.inBuffer.size());
+    if (status == ParseStatus::Error) {
+        client.setRequestBuffered();
+        return false;
+    }
+    size_t length = client.parser.bodyBuffered(client.inBuffer.size());
+    if (length == 0 && status != ParseStatus::Complete) {
+        if (client.state != ClientState::AwaitingRequest) {
+            client.setAwaitingRequest();
+        }
+        return false;
+    }
+    call.chunk = std::string_view(client.inBuffer.data() + client.parser.bodyOffset(), length);
+    call.chunkLength = length;
+    return true;
+}
+
+/**
+ * @brief Returns true if reading more from the client would exceed the memory budget.
+ * @details Every read stops once all connections together hold the total budget. A single
+ *          connection stops at its own limit while it has a complete request or responses to
+ *          work off, since doing so frees memory; an incomplete request alone is instead
+ *          refused by rejectOversized() when it cannot fit.
+ * @param client Client about to be read
+ */
+bool Server::readsOverBudget(const Client& client) const {
+    if (MemoryBudget::exhausted()) {
+        return true;
+    }
+    bool draining = client.outputBytes > 0 || client.state != ClientState::AwaitingRequest;
+    return draining && client.inBuffer.size() + client.outputBytes >= MemoryBudget::connectionLimit();
+}
+
+/**
+ * @brief Stops reading from the client until the memory budget allows it again.
+ * @details The poll engine drops read interest and io_uring cancels the multishot receive;
+ *          resumeReads() retries at the end of every iteration, and a timer keeps iterations
+ *          coming while memory held by other reactors is what has to be freed.
+ * @param client Client to pause
+ */
+void Server::pauseReads(Client& client) {
+    if (client.readPaused) {
+        return;
+    }
+    client.readPaused = true;
+    pausedReads.push_back(client.timer.key);
+    metrics.readPauses.add();
+    if (!readRecheck.isLinked()) {
+        timers.schedule(readRecheck, loopTime + READ_RECHECK_MS);
+    }
+}
+
+/**
+ * @brief Resumes reading from the paused clients the memory budget allows again.
+ * @param resume Engine-specific restart of the client's reads
+ */
+void Server::resumeReads(const std::function<void(Client&)>& resume) {
+    if (pausedReads.empty()) {
+        return;
+    }
+    size_t kept = 0;
+    for (size_t i = 0; i < pausedReads.size(); ++i) {
+        Client* client = clients.get(pausedReads[i]);
+        if (client == nullptr || !client->readPaused) {
+            continue;
+        }
+        if (readsOverBudget(*client)) {
+            pausedReads[kept++] = pausedReads[i];
+            continue;
+        }
+        client->readPaused = false;
+        resume(*client);
+    }
+    pausedReads.resize(kept);
+    if (!pausedReads.empty() && !readRecheck.isLinked()) {
+        timers.schedule(readRecheck, loopTime + READ_RECHECK_MS);
+    }
+}
+
+/**
+ * @brief Stamps the end of the headers and of the message on the request being parsed.
+ * @details Called after every parse(). Each stamp is set once per request, so parsing a held
+ *          or parked request again does not move it. The target is copied for the access log
+ *          as soon as the headers are in, before a streamed body releases them.
+ * @param client Client whose parser just ran
+ * @param status Result of the parse
+ * @param nowUs Current metricsClockUs()
+ */
+void Server::stampParse(Client& client, ParseStatus status, uint64_t nowUs) {
+    AccessRecord& access = client.access;
+    if (access.headersUs == 0 && client.parser.headersComplete()) {
+        access.headersUs = nowUs;
+        if (AccessLog::enabled()) {
+            access.target.assign(client.parser.requestTarget(client.inBuffer.view()));
+        }
+    }
+    if (access.bodyUs == 0 && status != ParseStatus::Incomplete) {
+        access.bodyUs = nowUs;
+    }
+}
+
+/**
+ * @brief Refuses a request that would not fit in memory before its body is read.
+ * @details Only requests buffered whole are checked: streamed uploads and coroutine handlers
+ *          take their body piece by piece. A Content-Length body is refused as soon as the
+ *          headers are in; a chunked one once it has outgrown the limit.
+ * @param client Client in AwaitingRequest with an incomplete request buffered
+ * @return True if the request was answered with 413 and the connection will close
+ */
+bool Server::rejectOversized(Client& client) {
+    if (!client.parser.headersComplete() || client.upload || client.async) {
+        return false;
+    }
+    size_t needed = (std::max)(client.parser.messageEnd(), client.inBuffer.size());
+    if (needed <= MemoryBudget::connectionLimit()) {
+        return false;
+    }
+    Request request;
+    client.parser.request(client.inBuffer.view(), request); // The body view is not complete and is not used
+    client.requests++;
+    Response error = Response::contentTooLarge("Request body exceeds the in-memory limit");
+    rejectRequest(client, error, parseMethod(request.method));
+    return true;
+}
+
+/**
+ * @brief Records the socket a parked coroutine handler waits on.
+ * @param client Client to check
+ * @return True if the caller has to start watching client.async->socket
+ */
+bool Server::armAsyncSocket(Client& client) {
+    if (!client.async || client.state != ClientState::AwaitingHandler) {
+        return false;
+    }
+    AsyncCall& call = *client.async;
+    if ((call.wait != AsyncWait::Readable && call.wait != AsyncWait::Writable) || call.armed) {
+        return false;
+    }
+    call.armed = true;
+    asyncSequence = (asyncSequence + 1) & 0xFFFFFF;
+    asyncSockets[call.socket] = AsyncSocketWatch{ client.timer.key, asyncSequence };
+    return true;
+}
+
+/**
+ * @brief Resumes the coroutine handler waiting on a socket that became ready.
+ * @param socket Watched socket
+ * @param events Poll events reported for it
+ * @return Client of the resumed handler, or nullptr if nobody waits on the socket any more
+ */
+Client* Server::wakeAsyncSocket(SOCKET socket, unsigned events) {
+    auto it = asyncSockets.find(socket);
+    if (it == asyncSockets.end()) {
+        return nullptr;
+    }
+    uint64_t handle = it->second.client;
+    asyncSockets.erase(it);
+    if (engine == IoEngine::Poll) {
+        poller.remove(socket);
+    }
+    Client* client = clients.get(handle);
+    if (client == nullptr || !client->async || client->state != ClientState::AwaitingHandler) {
+        return nullptr;
+    }
+    client->async->events = events;
+    client->async->wait = AsyncWait::None;
+    resumeAsync(*client);
+    return client;
+}
+
+/**
+ * @brief Stops watching a handler's socket whose wait ends without an event.
+ * @details The poll engine unregisters the socket at once. An io_uring poll is already queued
+ *          and would keep a reference to the handler's file after the handler closes it, so it
+ *          is recorded in abandonedWatches for the engine to cancel before its next submission.
+ * @param socket Watched socket
+ */
+void Server::abandonAsyncSocket(SOCKET socket) {
+    auto it = asyncSockets.find(socket);
+    if (it == asyncSockets.end()) {
+        return;
+    }
+    if (engine == IoEngine::Poll) {
+        poller.remove(socket);
     }
     else {
-        response = handleBadRequest("Unsupported HTTP method");
+        abandonedWatches.emplace_back(socket, it->second.sequence);
+    }
+    asyncSockets.erase(it);
+}
+
+/**
+ * @brief Advances a client woken by a timer, a job or another socket, then reaps it if it closed.
+ * @param client Client to advance
+ */
+void Server::resumeClient(Client& client) {
+    processClient(client, POLL_WRITE);
+    if (client.state == ClientState::Aborted || client.state == ClientState::Completed) {
+        removeClient(client.socket);
+    }
+}
+
+/**
+ * @brief Serializes a response's head and queues it behind the client's earlier responses.
+ * @param client Reference to client object
+ * @param response Response to send; its body is moved out
+ * @param method Request method, for the response counters
+ * @param startedUs metricsClockUs() when the request was dispatched
+ */
+void Server::queueResponse(Client& client, Response& response, Method method, uint64_t startedUs) {
+    metrics.countResponse(method, response.statusCode);
+    response.headers["Connection"] = client.keepAlive ? "keep-alive" : "close";
+    OutboundResponse out;
+    out.head = client.takeHeadBuffer();
+    response.serializeHead(out.head);
+    out.body = std::move(response.body);
+    out.sharedBody = std::move(response.sharedBody);
+    out.file = response.file;
+    out.fileOffset = response.fileOffset;
+    out.fileRemaining = response.file ? response.bodyLength : 0;
+    out.access = std::move(client.access);
+    out.access.method = method;
+    out.access.status = static_cast<uint16_t>(response.statusCode);
+    out.access.dispatchUs = startedUs;
+    out.access.handledUs = metricsClockUs();
+    client.access = AccessRecord();
+    if (response.stream) {
+        // The first chunk leaves together with the head
+        out.stream = std::move(response.stream);
+        produceChunk(out);
     }
+    client.chargeOutput(static_cast<int64_t>(out.ownedSize()));
+    client.outQueue.push_back(std::move(out));
+}
+
+/**
+ * @brief Starts streaming the body of a PUT to disk as soon as its headers are in.
+ * @details The head is validated like a buffered PUT; from then on body bytes are written to
+ *          the upload's temporary file as they arrive and dropped from inBuffer, so an upload
+ *          needs no more memory than one read. A request rejected on its head is answered
+ *          right away and the connection closed without reading the body.
+ * @param client Client in AwaitingRequest whose request headers are complete
+ * @return True if the request is now an upload (or was answered), false to buffer it as usual
+ */
+bool Server::startUpload(Client& client) {
+    Request request;
+    client.parser.request(client.inBuffer.view(), request); // The body view is not complete and is not used
+    if (parseMethod(request.method) != Method::Put) {
+        return false;
+    }
+    const Router::Route* target = nullptr;
+    if (router.find(Method::Put, request.path, request.params, target) != Router::Match::Found || !target->handler) {
+        return false;
+    }
+    client.keepAlive = isKeepAlive(request);
+    client.requests++;
+    Response error;
+    if (!admitRequest(client, error) || !beginPut(request, client.upload, error)) {
+        rejectRequest(client, error, Method::Put);
+    }
+    return true;
+}
+
+/**
+ * @brief Writes the body bytes buffered for the client's upload and releases them.
+ * @details Called after every read, so the socket is only read again once the previous bytes
+ *          reached the file: when the disk falls behind, reads pause and TCP flow control
+ *          slows the sender instead of the input buffer growing.
+ * @param client Client with an active upload
+ * @return False if the write failed
+ */
+bool Server::writeUpload(Client& client) {
+    size_t length = client.parser.bodyBuffered(client.inBuffer.size());
+    bool written = client.upload->write(client.inBuffer.data() + client.parser.bodyOffset(), length);
+    client.inBuffer.consume(client.parser.releaseBody(length));
+    return written;
+}
 
-	response.headers["Connection"] = client.keepAlive ? "keep-alive" : "close";
-    client.outBuffer = response.toString();
+/**
+ * @brief Answers a request whose body will not be read and closes the connection after it.
+ * @param client Reference to client object
+ * @param response Response to send
+ * @param method Request method, for the response counters
+ */
+void Server::rejectRequest(Client& client, Response& response, Method method) {
+    client.upload.reset();
+    client.keepAlive = false;
+    client.inBuffer.clear();
+    client.parser.reset();
+    queueResponse(client, response, method, metricsClockUs());
     client.setResponseReady();
 }
 
 /**
- * @brief Accepts a new client connection.
+ * @brief Registers every endpoint with the router.
+ * @details Literal routes take precedence over the static file wildcard routes, so new
+ *          endpoints are added here without touching the file handlers.
+ */
+void Server::registerRoutes() {
+    router.add(Method::Get, "/health", [](const Request&) { return health(); });
+    router.add(Method::Get, "/metrics", [](const Request&) { return handleMetrics(); });
+    router.add(Method::Get, "/*path", handleGet);
+    router.add(Method::Head, "/*path", handleHead);
+    router.add(Method::Post, "/echo", handlePost);
+    router.add(Method::Put, "/*path", handlePut);
+    router.add(Method::Delete, "/*path", handleDelete);
+    router.add(Method::Trace, "/trace", handleTrace);
+    router.add(Method::Options, "/*path", handleOptions);
+    router.addAsync(Method::Get, "/delay/:ms", handleDelay);
+    router.addAsync(Method::Post, "/crc32", handleCrc32);
+}
+
+/**
+ * @brief Runs the synchronous handler registered for a request's method and path.
+ * @param request Parsed request; request.params holds the captured path parameters
+ * @param method Request method
+ * @param match Outcome of router.find()
+ * @param target Route found (Found only)
+ * @return Handler response, 400 for an unknown method, 405 if a literal route serves the path
+ *         under other methods, 400 if no route matches (as the per-method handlers answered
+ *         paths they did not serve; GET, HEAD, PUT, DELETE and OPTIONS have catch-all routes)
+ */
+Response Server::route(Request& request, Method method, Router::Match match, const Router::Route* target) {
+    if (method == Method::Unknown) {
+        return handleBadRequest("Unsupported HTTP method");
+    }
+    switch (match) {
+        case Router::Match::Found:
+            return target->handler(request);
+        case Router::Match::MethodNotAllowed:
+            return Response::methodNotAllowed(router.allowedMethods(request.path));
+        default:
+            return handleBadRequest(std::string(methodName(method)) + " not supported on " + std::string(request.path));
+    }
+}
+
+/**
+ * @brief Accepts pending client connections, at most one batch at a time.
+ * @details The listen socket is edge-triggered, so accept() is repeated until it would block;
+ *          when the batch fills up first, acceptPending makes the loop come back without
+ *          waiting once the other ready sockets were served, so a connection storm cannot
+ *          starve the connections already open.
  */
 void Server::acceptConnection() {
-    sockaddr_in from;
-    int fromLen = sizeof(from);
-    SOCKET clientSocket = accept(listenSocket, (sockaddr*)&from, &fromLen);
-    if (INVALID_SOCKET == clientSocket) {
-        logError("Error at accept()", WSAGetLastError());
-        return;
+    acceptPending = false;
+    for (size_t accepted = 0; accepted < ACCEPT_BATCH; ++accepted) {
+        sockaddr_in from;
+        socklen_t fromLen = sizeof(from);
+        SOCKET clientSocket = accept(listenSocket, (sockaddr*)&from, &fromLen);
+        if (INVALID_SOCKET == clientSocket) {
+            int error = getSocketError();
+            if (!isWouldBlock(error)) {
+                logError("Error at accept()", error);
+            }
+            return;
+        }
+        if (Client* client = addClient(clientSocket, from)) {
+            client->setAwaitingRequest();
+        }
+    }
+    acceptPending = true;
+}
+
+/**
+ * @brief Answers a connection that is not admitted and closes it.
+ * @details The 503 was serialized once by AdmissionControl and fits an empty send buffer,
+ *          so one non-blocking send() is enough; it is best effort, as the connection is
+ *          dropped either way.
+ * @param clientSocket Accepted, non-blocking socket
+ */
+void Server::refuseConnection(SOCKET clientSocket) {
+    const std::string& refusal = admission.refusal();
+    int sent = send(clientSocket, refusal.data(), static_cast<int>(refusal.size()), 0);
+    (void)sent;
+    closesocket(clientSocket);
+    metrics.refusedConnections.add();
+}
+
+/**
+ * @brief Decides whether a new request is served.
+ * @details Requests are shed with the pre-serialized 503 while the event loop lags, and
+ *          answered 429 once the client address has used up its token bucket.
+ * @param client Client the request arrived on
+ * @param refusal Receives the response to send instead when the request is not served
+ * @return True if the request may run its handler
+ */
+bool Server::admitRequest(Client& client, Response& refusal) {
+    if (admission.overloaded()) {
+        refusal = admission.shedResponse();
+        return false;
     }
-    if (addClient(clientSocket, from)) {
-        clients[clientSocket].setAwaitingRequest();
+    if (!admission.admitRequest(client.clientAddr, loopTime)) {
+        refusal = Response::tooManyRequests(admission.retryAfter(client.clientAddr));
+        return false;
     }
+    return true;
 }
 
 /**
  * @brief Receives a message from the client and buffers it.
+ * @details Reads straight into the client's pooled input buffer until recv() would block, as
+ *          required by edge-triggered readiness. A read that fills the whole window doubles the
+ *          read size (up to MAX_READ_SIZE) for connections moving bulk data.
  * @param client Reference to client object
  */
 void Server::receiveMessage(Client& client) {
-    if (client.state != ClientState::AwaitingRequest) {
-        logError("receiveMessage called in invalid client state", WSAGetLastError());
+    if (client.state != ClientState::AwaitingRequest && client.state != ClientState::AwaitingHandler && client.state != ClientState::ResponseReady) {
+        logError("receiveMessage called in invalid client state", getSocketError());
     }
-    std::string recvBuffer(BUFF_SIZE, '\0');
-    int bytesRecv = recv(client.socket, &recvBuffer[0], static_cast<int>(recvBuffer.size() - 1), 0);
-    if (SOCKET_ERROR == bytesRecv) {
-        client.setAborted();
-        logError("Error at recv()", WSAGetLastError(), client.clientAddr);
-        closesocket(client.socket);
+    bool received = false;
+    while (true) {
+        if (readsOverBudget(client)) {
+            pauseReads(client); // The rest stays in the socket until the budget allows more
+            break;
+        }
+        char* window = client.inBuffer.prepare(client.readSize);
+        size_t windowSize = client.inBuffer.writable();
+        int bytesRecv = recv(client.socket, window, static_cast<int>(windowSize), 0);
+        if (SOCKET_ERROR == bytesRecv) {
+            int error = getSocketError();
+            if (isWouldBlock(error)) {
+                break;
+            }
+            client.setAborted();
+            logError("Error at recv()", error, client.clientAddr);
+            return;
+        }
+        if (bytesRecv == 0) {
+            client.setCompleted();
+            return;
+        }
+        client.inBuffer.commit(static_cast<size_t>(bytesRecv));
+        metrics.bytesIn.add(static_cast<uint64_t>(bytesRecv));
+        received = true;
+        if (static_cast<size_t>(bytesRecv) == windowSize) {
+            client.readSize = (std::min)(windowSize * 2, MAX_READ_SIZE);
+        }
+        // Parsed (and an upload written) per read, so a streamed body never piles up in inBuffer
+        if (client.keepAlive || client.inRequest()) {
+            onBuffered(client, static_cast<size_t>(bytesRecv));
+        }
+        if (client.state == ClientState::Aborted) {
+            return;
+        }
+    }
+    if (!client.keepAlive && !client.inRequest()) {
+        // Bytes after a request that closes the connection are discarded
+        client.inBuffer.clear();
         return;
     }
-    if (bytesRecv == 0) {
-        client.setCompleted();
-        closesocket(client.socket);
+    if (!received && client.inBuffer.empty()) {
+        client.inBuffer.clear(); // Spurious wakeup: give the borrowed buffer back
+    }
+}
+
+/**
+ * @brief Buffers received bytes and moves the client to RequestBuffered once a request is complete.
+ * @details Used by engines that receive into their own buffers (io_uring provided buffers).
+ *          Bytes after a request that closes the connection are discarded.
+ * @param client Reference to client object
+ * @param data Received bytes
+ * @param length Number of received bytes
+ */
+void Server::onReceived(Client& client, const char* data, size_t length) {
+    metrics.bytesIn.add(length);
+    if (!client.keepAlive && !client.inRequest()) {
+        return;
+    }
+    client.inBuffer.append(data, length);
+    onBuffered(client, length);
+}
+
+/**
+ * @brief Moves the client to RequestBuffered once the buffered bytes complete a request.
+ * @details Shared by the poll loop and the io_uring engine. Bytes that arrive while responses
+ *          are pending are only buffered; dispatch() picks up the requests they complete.
+ * @param client Reference to client object
+ * @param length Number of bytes just added to the end of inBuffer
+ */
+void Server::onBuffered(Client& client, size_t length) {
+    uint64_t now = metricsClockUs();
+    client.lastReadUs = now;
+    if (client.access.firstByteUs == 0) {
+        client.access.firstByteUs = now;
+    }
+    client.readProgress = true;
+    if (client.state != ClientState::AwaitingRequest) {
         return;
     }
-    recvBuffer.resize(bytesRecv);
-    client.inBuffer.append(recvBuffer);
+    // Logged before parsing, which may rewrite chunked body bytes in place
+    logEvent("web-server-received.log", client.clientAddr, client.inBuffer.data() + client.inBuffer.size() - length, length);
 	// If incomplete request, keep buffering (state remains AwaitingRequest)
-    if (!isRequestComplete(client.inBuffer)) {
+    ParseStatus status = client.parser.parse(client.inBuffer.data(), client.inBuffer.size());
+    stampParse(client, status, now);
+    if (status == ParseStatus::Incomplete) {
+        if (client.parser.headersComplete() && (client.upload || client.async || startUpload(client) || beginAsync(client))) {
+            if (client.upload && !writeUpload(client)) {
+                Response error = handleInternalError("Error writing file: " + client.upload->target());
+                rejectRequest(client, error, Method::Put);
+            }
+            if (client.async) {
+                resumeAsync(client); // Hands the handler the body bytes received so far
+            }
+            return;
+        }
+        if (rejectOversized(client)) {
+            return;
+        }
 		logEvent("web-server-received.log", client.clientAddr, "Partial request received, waiting for more data.");
         return;
     }
-	// Else full request received, log and chnage state to RequestBuffered
-    logEvent("web-server-received.log", client.clientAddr, recvBuffer);
+    if (status == ParseStatus::Error) {
+        logError("Malformed request", 0, client.clientAddr);
+    }
+	// Else full request received, chnage state to RequestBuffered
     client.setRequestBuffered();
 }
 
 /**
- * @brief Sends a message to the client.
+ * @brief Collects the unsent heads and in-memory bodies of the queued responses for one gathered send.
+ * @details Each response contributes up to two slices starting at the send cursor. Gathering
+ *          stops after a response with a file body, which has to be streamed before anything
+ *          queued behind it. Shared by the poll loop and the io_uring engine.
+ * @param client Reference to client object
+ * @param slices Output slices
+ * @param maxSlices Capacity of slices (at least 2)
+ * @param moreFollows Set to true if queued output remains beyond the gathered slices
+ * @return Number of slices filled
+ */
+size_t Server::gatherOutput(Client& client, IoSlice* slices, size_t maxSlices, bool& moreFollows) {
+    size_t count = 0;
+    size_t offset = client.outOffset;
+    moreFollows = false;
+    for (const OutboundResponse& out : client.outQueue) {
+        if (count + 2 > maxSlices || moreFollows) {
+            moreFollows = true;
+            break;
+        }
+        if (offset < out.head.size()) {
+            setSlice(slices[count++], out.head.data() + offset, out.head.size() - offset);
+            offset = 0;
+        }
+        else {
+            offset -= out.head.size();
+        }
+        const std::string& body = out.bodyData();
+        if (offset < body.size()) {
+            setSlice(slices[count++], body.data() + offset, body.size() - offset);
+        }
+        offset = 0;
+        moreFollows = out.fileRemaining > 0 || out.stream != nullptr;
+    }
+    return count;
+}
+
+/**
+ * @brief Sends the queued responses to the client.
+ * @details Consecutive in-memory responses leave in a single gathered send; file bodies are
+ *          streamed with sendFile(). Writes until the queue is empty or the socket would block.
  * @param client Reference to client object
  */
 void Server::sendMessage(Client& client) {
-    if (client.state != ClientState::ResponseReady || client.outBuffer.empty()) {
-        logError("sendMessage called in invalid state or empty buffer", WSAGetLastError());
+    if (client.state != ClientState::ResponseReady || client.outQueue.empty()) {
+        logError("sendMessage called in invalid state or empty buffer", getSocketError());
         return;
     }
-    int bytesSent = send(client.socket, client.outBuffer.c_str(), (int)client.outBuffer.size(), 0);
-    if (SOCKET_ERROR == bytesSent) {
-        client.setAborted();
-        logError("Error at send()", WSAGetLastError());
-        closesocket(client.socket);
+    IoSlice slices[MAX_SEND_SLICES];
+    while (client.state == ClientState::ResponseReady && !client.outQueue.empty()) {
+        OutboundResponse& front = client.outQueue.front();
+        if (client.outOffset < front.memorySize()) {
+            bool moreFollows = false;
+            size_t count = gatherOutput(client, slices, MAX_SEND_SLICES, moreFollows);
+            // Hold the last segment back while more output follows so it leaves in full packets
+            long long bytesSent = sendSlices(client.socket, slices, count, moreFollows ? SEND_MORE_FLAGS : SEND_FLAGS);
+            if (bytesSent < 0) {
+                int error = getSocketError();
+                if (isWouldBlock(error)) {
+                    // Wait for the next writable event
+                    return;
+                }
+                client.setAborted();
+                logError("Error at send()", error, client.clientAddr);
+                return;
+            }
+            onSent(client, static_cast<size_t>(bytesSent));
+            continue;
+        }
+        if (front.stream) {
+            nextChunk(client);
+            continue;
+        }
+        // Then stream the file-backed body without copying it through user space
+        long long bytesSent = sendFile(client.socket, *front.file, front.fileOffset, front.fileRemaining);
+        if (bytesSent <= 0) {
+            int error = getSocketError();
+            if (bytesSent < 0 && isWouldBlock(error)) {
+                return;
+            }
+            client.setAborted();
+            logError("Error at sendfile()", error, client.clientAddr);
+            return;
+        }
+        onFileSent(client, static_cast<uint64_t>(bytesSent));
+    }
+}
+
+/**
+ * @brief Logs a range of a response's head and in-memory body as sent.
+ * @param client Reference to client object
+ * @param out Response being sent
+ * @param offset Offset of the range within head and body
+ * @param length Length of the range
+ */
+static void logSent(const Client& client, const OutboundResponse& out, size_t offset, size_t length) {
+    if (!logEnabled(LogCategory::Payload)) {
         return;
     }
-    // Log sent data with timestamp
-    std::string sentData = client.outBuffer.substr(0, bytesSent);
-    logEvent("web-server-sent.log", client.clientAddr, sentData);
-    if (bytesSent < client.outBuffer.size()) {
-        client.outBuffer = client.outBuffer.substr(bytesSent);
-        // No console output, just log
+    const std::string& body = out.bodyData();
+    if (offset + length <= out.head.size()) {
+        logEvent("web-server-sent.log", client.clientAddr, out.head.data() + offset, length);
+    }
+    else if (offset >= out.head.size()) {
+        logEvent("web-server-sent.log", client.clientAddr, body.data() + (offset - out.head.size()), length);
+    }
+    else {
+        std::string joined = out.head.substr(offset);
+        joined.append(body, 0, length - joined.size());
+        logEvent("web-server-sent.log", client.clientAddr, joined.data(), joined.size());
+    }
+}
+
+/**
+ * @brief Advances the send cursor over the queued responses and pops the completed ones.
+ * @details The cursor is an offset into the front response, so a partial send never copies
+ *          the unsent rest. Shared by the poll loop and the io_uring engine.
+ * @param client Reference to client object
+ * @param length Number of bytes the socket accepted
+ */
+void Server::onSent(Client& client, size_t length) {
+    client.writeProgress = client.writeProgress || length > 0;
+    metrics.bytesOut.add(length);
+    while (length > 0 && !client.outQueue.empty()) {
+        OutboundResponse& front = client.outQueue.front();
+        size_t total = front.memorySize();
+        size_t chunk = (std::min)(length, total - client.outOffset);
+        // Log sent data with timestamp
+        logSent(client, front, client.outOffset, chunk);
+        if (front.access.firstSentUs == 0) {
+            front.access.firstSentUs = metricsClockUs();
+        }
+        front.access.bytes += chunk;
+        client.outOffset += chunk;
+        length -= chunk;
+        if (client.outOffset < total || front.fileRemaining > 0 || front.stream) {
+            return;
+        }
+        completeResponse(client);
+    }
+    if (client.outQueue.empty()) {
+        finishResponse(client);
+    }
+}
+
+/**
+ * @brief Accounts for file body bytes sent and pops the response once its body is out.
+ * @param client Reference to client object
+ * @param length Number of file bytes the socket accepted
+ */
+void Server::onFileSent(Client& client, uint64_t length) {
+    client.writeProgress = client.writeProgress || length > 0;
+    metrics.bytesOut.add(length);
+    OutboundResponse& front = client.outQueue.front();
+    front.access.bytes += length;
+    front.fileRemaining -= length;
+    if (front.fileRemaining > 0) {
         return;
     }
-    client.outBuffer.clear();
-    client.keepAlive ? client.setAwaitingRequest() : client.setCompleted();
+    completeResponse(client);
+    if (client.outQueue.empty()) {
+        finishResponse(client);
+    }
+}
+
+/**
+ * @brief Pops the fully sent front response, keeping its head buffer for reuse.
+ * @details Its last byte is out, so this is where the request's access log record is written.
+ * @param client Reference to client object
+ */
+void Server::completeResponse(Client& client) {
+    OutboundResponse& front = client.outQueue.front();
+    uint64_t now = metricsClockUs();
+    metrics.latency.record(now - front.access.dispatchUs);
+    if (AccessLog::enabled()) {
+        front.access.lastSentUs = now;
+        AccessLog::record(client.clientAddr, front.access);
+    }
+    client.chargeOutput(-static_cast<int64_t>(front.ownedSize()));
+    client.recycleHead(front);
+    client.outQueue.pop_front();
+    client.outOffset = 0;
+}
+
+/**
+ * @brief Replaces the front response's sent head and body with its next chunk.
+ * @details Called once everything queued so far for a streamed response is out, so the
+ *          producer only runs as fast as the client reads.
+ * @param client Reference to client object
+ */
+void Server::nextChunk(Client& client) {
+    OutboundResponse& front = client.outQueue.front();
+    int64_t before = static_cast<int64_t>(front.ownedSize());
+    client.recycleHead(front);
+    front.sharedBody.reset();
+    produceChunk(front);
+    client.chargeOutput(static_cast<int64_t>(front.ownedSize()) - before);
+    client.outOffset = 0;
+}
+
+/**
+ * @brief Moves the client to its next state once every queued response is sent.
+ * @details Requests held back by MAX_PIPELINE may already be complete in inBuffer, in which
+ *          case the client goes straight back to RequestBuffered.
+ * @param client Reference to client object
+ */
+void Server::finishResponse(Client& client) {
+    client.outOffset = 0;
+    if (!client.keepAlive) {
+        client.setCompleted();
+        return;
+    }
+    client.setAwaitingRequest();
+    if (client.inBuffer.empty()) {
+        // Idle again: the next request starts with a small read
+        client.readSize = (std::max)(MIN_READ_SIZE, client.readSize / 2);
+    }
+    else if (client.parser.parse(client.inBuffer.data(), client.inBuffer.size()) != ParseStatus::Incomplete) {
+        client.setRequestBuffered();
+    }
+    else {
+        rejectOversized(client); // Arrived behind the responses just sent
+    }
 }
 
 /**
  * @brief Main server loop: handles connections and client events.
- * @details Uses select() and non-blocking sockets for non-blocking I/O multiplexing.
+ * @details Uses the poller (edge-triggered epoll on Linux) and non-blocking sockets, so each
+ *          iteration only visits the sockets that are actually ready.
  */
 void Server::run() {
     if (listenSocket == INVALID_SOCKET) {
-        logError("Initialization failed", WSAGetLastError());
+        logError("Initialization failed", getSocketError());
         return;
     }
+#ifdef __linux__
+    std::unique_ptr<UringEngine> uring;
+    if (engine == IoEngine::Uring) {
+        uring = std::make_unique<UringEngine>(*this);
+        if (!uring->isValid()) {
+            logError("io_uring unavailable, falling back to the poll engine");
+            uring.reset();
+            engine = IoEngine::Poll;
+        }
+    }
+#else
+    if (engine == IoEngine::Uring) {
+        logError("io_uring is only available on Linux, falling back to the poll engine");
+        engine = IoEngine::Poll;
+    }
+#endif
     if (!listen()) {
-        logError("Listen failed", WSAGetLastError());
-        WSACleanup();
+        logError("Listen failed", getSocketError());
+        socketCleanup();
         return;
     }
 	std::cout << "Server listening on " << ip_ << ":" << port_ << std::endl;
+    if (BlockingPool::enabled() && completions.handle() != -1) {
+        ContentCache::local().setCompletions(&completions);
+    }
+#ifdef __linux__
+    if (uring) {
+        uring->run();
+        return;
+    }
+#endif
+    // Content changes arrive as readability on the cache's inotify descriptor
+    SOCKET watchSocket = static_cast<SOCKET>(ContentCache::local().watchHandle());
+    if (watchSocket != INVALID_SOCKET && !poller.add(watchSocket, POLL_READ)) {
+        logError("Error watching the content directory", getSocketError());
+    }
+    // Jobs finished by the I/O pool arrive as readability on the completion eventfd
+    SOCKET jobSocket = static_cast<SOCKET>(completions.handle());
+    if (jobSocket != INVALID_SOCKET && !poller.add(jobSocket, POLL_READ)) {
+        logError("Error watching the I/O pool completions", getSocketError());
+    }
     while (true) {
-
-        // Log iteration separator in log files with timestamp
-        std::string separator = "\n=================== Iteration: " + std::to_string(iteration) + " | " + getTimestamp() + " ===================\n";
-		logData("web-server-received.log", separator);
-		logData("web-server-sent.log", separator);
-        iteration++;
-
-        fd_set readfds, writefds, errorfds;
-        if (!pollEvents(readfds, writefds, errorfds)) {
-            logError("Polling events failed", WSAGetLastError());
-            WSACleanup();
+        logIteration();
+        if (!pollEvents()) {
+            logError("Polling events failed", getSocketError());
+            socketCleanup();
             return;
         }
-        if (FD_ISSET(listenSocket, &readfds)) {
-            acceptConnection();
-        }
-        std::vector<SOCKET> clientsToRemove;
-        for (auto& kv : clients) {
-            Client& client = kv.second;
-            processClient(client, readfds, writefds, errorfds);
+        for (const PollEvent& event : events) {
+            if (event.socket == listenSocket) {
+                acceptPending = true; // Accepted after the open connections were served
+                continue;
+            }
+            if (event.socket == watchSocket) {
+                ContentCache::local().processEvents();
+                continue;
+            }
+            if (event.socket == jobSocket) {
+                finishJobs([this](Client& client) { resumeClient(client); });
+                continue;
+            }
+            Client* found = clients.find(event.socket);
+            if (found == nullptr) {
+                // A socket a coroutine handler waits on
+                if (Client* woken = wakeAsyncSocket(event.socket, event.events)) {
+                    resumeClient(*woken);
+                }
+                continue;
+            }
+            Client& client = *found;
+            processClient(client, event.events);
             if (client.state == ClientState::Aborted || client.state == ClientState::Completed) {
-                closesocket(client.socket);
-                clientsToRemove.push_back(client.socket);
+                removeClient(event.socket);
             }
         }
-        for (SOCKET sock : clientsToRemove) {
-            clients.erase(sock);
+        if (acceptPending) {
+            acceptConnection();
         }
+        expireTimers([this](Client& client) { resumeClient(client); });
+        resumeReads([this](Client& client) {
+            updateInterest(client); // Adding read interest back reports data already waiting
+            if (client.state == ClientState::Aborted) {
+                removeClient(client.socket);
+            }
+        });
+        admission.loopDone(metricsClockUs());
     }
 }
 
 /**
- * @brief Prepares socket sets for select().
- * @param readfds Read file descriptor set
- * @param writefds Write file descriptor set
+ * @brief Logs an iteration separator in the data log files and bumps the loop counter.
  */
-void Server::prepareFdSets(fd_set& readfds, fd_set& writefds, fd_set& errorfds) {
-    FD_ZERO(&readfds);
-    FD_ZERO(&writefds);
-	FD_ZERO(&errorfds);
-
-    FD_SET(listenSocket, &readfds);
-	FD_SET(listenSocket, &errorfds);
-
-    for (auto& kv : clients) {
-        if (kv.second.state == ClientState::AwaitingRequest) {
-            FD_SET(kv.first, &readfds);
-        }
-        if (kv.second.state == ClientState::ResponseReady) {
-            FD_SET(kv.first, &writefds);
-        }
-		FD_SET(kv.first, &errorfds);
+void Server::logIteration() {
+    long long current = iteration++;
+    metrics.iterations.add();
+    if (!logEnabled(LogCategory::Data)) {
+        return;
     }
+    // Log iteration separator in log files with timestamp
+    std::string separator = "\n=================== Iteration: " + std::to_string(current) + " | " + getTimestamp() + " ===================\n";
+	logData("web-server-received.log", separator);
+	logData("web-server-sent.log", separator);
 }
 
 /**
- * @brief Polls sockets for events using select().
- * @param readfds Read file descriptor set
- * @param writefds Write file descriptor set
- * @param errorfds Error file descriptor set
+ * @brief Polls sockets for events using the poller.
+ * @details Blocks until the next timer deadline at most, or indefinitely when no timer is armed;
+ *          does not block while connections are left over from a full accept batch.
  * @return True if successful, false otherwise
  */
-bool Server::pollEvents(fd_set& readfds, fd_set& writefds, fd_set& errorfds) {
-    prepareFdSets(readfds, writefds, errorfds);
-    timeval timeout;
-    timeout.tv_sec = 30; // 30 seconds timeout
-    timeout.tv_usec = 0;
-    int nfd = select(0, &readfds, &writefds, &errorfds, &timeout);
-    if (nfd == SOCKET_ERROR) {
-        logError("Error at select()", WSAGetLastError());
+bool Server::pollEvents() {
+    int nfd = poller.wait(events, acceptPending ? 0 : timers.timeoutMs(TimerWheel::now()));
+    loopTime = TimerWheel::now();
+    admission.loopWoke(metricsClockUs());
+    if (nfd < 0) {
+        logError("Error at poll()", getSocketError());
         return false;
     }
-    if (nfd == 0) {
-        // Timeout occurred, no sockets ready
-        // Optionally handle idle tasks here
-        return true;
-    }
     return true;
 }
 
 /**
  * @brief Processes a client based on its state and socket readiness.
  * @param client Reference to client object
- * @param readfds Read file descriptor set
- * @param writefds Write file descriptor set
- * @param errorfds Error file descriptor set
+ * @param readyEvents Combination of PollFlags reported for the client socket
  */
-void Server::processClient(Client& client, fd_set& readfds, fd_set& writefds, fd_set& errorfds) {
-    SOCKET sock = client.socket;
+void Server::processClient(Client& client, unsigned readyEvents) {
     // Handle socket errors
-    if (FD_ISSET(sock, &errorfds)) {
-        logError("Socket exception", WSAGetLastError());
+    if (readyEvents & POLL_ERROR) {
+        logError("Socket exception", getSocketError(), client.clientAddr);
         client.setAborted();
         return;
     }
-    if (FD_ISSET(sock, &readfds) && client.state == ClientState::AwaitingRequest) {
+    if ((readyEvents & POLL_READ) && (client.state == ClientState::AwaitingRequest || client.state == ClientState::AwaitingHandler ||
+                                      client.state == ClientState::ResponseReady)) {
         receiveMessage(client);
     }
-    if (client.state == ClientState::RequestBuffered) {
-        dispatch(client);
-    }
-    if (FD_ISSET(sock, &writefds) && client.state == ClientState::ResponseReady) {
+    bool writable = (readyEvents & POLL_WRITE) != 0;
+    while (client.state == ClientState::RequestBuffered || client.state == ClientState::ResponseReady) {
+        bool queued = dispatch(client);
+        // The socket is almost always writable, so try sending new responses before waiting for an event
+        if (client.state != ClientState::ResponseReady || !(queued || writable)) {
+            break;
+        }
         sendMessage(client);
+        if (client.state != ClientState::RequestBuffered) {
+            break;
+        }
+    }
+    updateInterest(client);
+    updateTimeout(client);
+    if (armAsyncSocket(client)) {
+        unsigned wanted = client.async->wait == AsyncWait::Readable ? POLL_READ : POLL_WRITE;
+        if (!poller.add(client.async->socket, wanted)) {
+            logError("Error watching a handler socket", getSocketError(), client.clientAddr);
+            asyncSockets.erase(client.async->socket);
+            client.setAborted();
+        }
+    }
+}
+
+/**
+ * @brief Returns the name used in the state log for a timeout.
+ */
+static const char* timeoutName(TimeoutKind kind) {
+    switch (kind) {
+        case TimeoutKind::Idle: return "IdleTimeout";
+        case TimeoutKind::Header: return "HeaderTimeout";
+        case TimeoutKind::Body: return "BodyTimeout";
+        case TimeoutKind::WriteStall: return "WriteStallTimeout";
+        default: return "Timeout";
+    }
+}
+
+/**
+ * @brief Arms the client's timer for the deadline that matches its state.
+ * @details A connection waiting for its next request gets the keep-alive idle timeout
+ *          (CLIENT_TIMEOUT), and a new or partially received request the header timeout;
+ *          both run from the moment they start. The body and write-stall timeouts restart
+ *          whenever bytes move in the guarded direction. A coroutine handler parked on its own
+ *          socket gets SOCKET_WAIT_TIMEOUT_MS, after which it is resumed as if the socket failed.
+ *          The timer is only touched when the kind changes or a restart is due.
+ * @param client Reference to client object
+ */
+void Server::updateTimeout(Client& client) {
+    TimeoutKind kind = TimeoutKind::None;
+    uint64_t delay = 0;
+    bool restart = false;
+    if (client.state == ClientState::AwaitingRequest) {
+        if (client.inBuffer.empty() && client.requests > 0 && !client.upload && !client.async) {
+            kind = TimeoutKind::Idle;
+            delay = static_cast<uint64_t>(CLIENT_TIMEOUT) * 1000;
+        }
+        else if (!client.parser.headersComplete()) {
+            kind = TimeoutKind::Header;
+            delay = HEADER_TIMEOUT_MS;
+        }
+        else {
+            kind = TimeoutKind::Body;
+            delay = BODY_TIMEOUT_MS;
+            restart = client.readProgress;
+        }
+    }
+    else if (client.state == ClientState::ResponseReady) {
+        kind = TimeoutKind::WriteStall;
+        delay = WRITE_STALL_TIMEOUT_MS;
+        restart = client.writeProgress;
+    }
+    else if (client.state == ClientState::AwaitingHandler && client.async && client.async->wait == AsyncWait::Timer) {
+        kind = TimeoutKind::Wakeup;
+        delay = client.async->delayMs;
+    }
+    else if (client.state == ClientState::AwaitingHandler && client.async &&
+             (client.async->wait == AsyncWait::Readable || client.async->wait == AsyncWait::Writable)) {
+        kind = TimeoutKind::SocketWait;
+        delay = SOCKET_WAIT_TIMEOUT_MS;
     }
-    else if (client.isIdle()) {
-        logClientState(client.clientAddr, "AwaitingRequest", "IdleTimeout-Aborted");
+    client.readProgress = false;
+    client.writeProgress = false;
+    if (kind == TimeoutKind::None) {
+        timers.cancel(client.timer);
+    }
+    else if (kind != client.timeout || restart) {
+        timers.schedule(client.timer, loopTime + delay);
+    }
+    client.timeout = kind;
+}
+
+/**
+ * @brief Advances the timer wheel and closes every client whose deadline passed.
+ * @details Only timers that are due are visited, so the cost follows the number of expiring
+ *          connections rather than the number of open ones. The housekeeping timer flushes
+ *          the access log batch and reports pool occupancy once per second while clients are
+ *          connected, plus once after the last one leaves. A Wakeup timer is not a deadline: it
+ *          resumes the coroutine handler that slept.
+ * @param advance Moves a woken client on (engine specific)
+ */
+void Server::expireTimers(const std::function<void(Client&)>& advance) {
+    expired.clear();
+    timers.advance(loopTime, expired);
+    for (TimerNode* node : expired) {
+        if (node == &housekeeping) {
+            AccessLog::flush();
+            reportPool();
+            sampleConnections();
+            admission.pruneBuckets(loopTime);
+            metrics.eventLoopLagUs.set(admission.lagUs());
+            if (!clients.empty()) {
+                timers.schedule(housekeeping, loopTime + HOUSEKEEPING_INTERVAL_MS);
+            }
+            continue;
+        }
+        if (node == &readRecheck) {
+            continue; // Paused reads are retried at the end of every iteration
+        }
+        Client* found = clients.get(node->key);
+        if (found == nullptr) {
+            continue;
+        }
+        Client& client = *found;
+        if (client.timeout == TimeoutKind::Wakeup) {
+            // A coroutine handler's sleepFor() is over
+            client.timeout = TimeoutKind::None;
+            client.async->wait = AsyncWait::None;
+            resumeAsync(client);
+            advance(client);
+            continue;
+        }
+        if (client.timeout == TimeoutKind::SocketWait) {
+            // The handler's socket did not become ready in time: stop watching it and resume
+            // the handler with false, as for an error on the socket
+            client.timeout = TimeoutKind::None;
+            abandonAsyncSocket(client.async->socket);
+            client.async->events = POLL_ERROR;
+            client.async->wait = AsyncWait::None;
+            resumeAsync(client);
+            advance(client);
+            continue;
+        }
+        std::string state = clientStateToString(client.state);
+        if (client.upload) {
+            state += "(Upload)";
+        }
+        else if (client.async) {
+            state += "(Async)";
+        }
+        logClientState(client.clientAddr, state, std::string(timeoutName(client.timeout)) + "-Aborted");
+        metrics.timeouts[static_cast<size_t>(client.timeout)].add();
         client.state = ClientState::Aborted;
+        removeClient(client.socket);
+    }
+}
+
+/**
+ * @brief Logs the buffer pool occupancy to web-server-pool.log when it changed since the last report.
+ * @details Called from the housekeeping timer, so the log shows how many pooled buffers the
+ *          reactor's connections hold over time.
+ */
+void Server::reportPool() {
+    std::string report = bufferPool.describe();
+    if (report == lastPoolReport) {
+        return;
     }
-}
\ No newline at end of file
+    logData("web-server-pool.log", report);
+    lastPoolReport = std::move(report);
+}
+
+/**
+ * @brief Counts the open connections per state for /metrics.
+ * @details Runs from the housekeeping timer, so the cost of walking the connection table is
+ *          paid once per second rather than on every state change.
+ */
+void Server::sampleConnections() {
+    std::array<uint64_t, CLIENT_STATE_COUNT> counts{};
+    clients.forEach([&counts](Client& client) {
+        counts[static_cast<size_t>(client.state)]++;
+    });
+    for (size_t i = 0; i < CLIENT_STATE_COUNT; ++i) {
+        metrics.connectionStates[i].set(counts[i]);
+    }
+}
@@ -1,20 +1,54 @@
 ﻿#pragma once
-#define _CRT_SECURE_NO_WARNINGS
-#define _WINSOCK_DEPRECATED_NO_WARNINGS
-
-#include <winsock2.h>
-#pragma comment(lib, "Ws2_32.lib")
 #include <string>
 #include <iostream>
-#include <map>
 #include <ctime>
 #include <algorithm>
 #include <vector>
 #include <fstream>
 #include <sstream>
+#include <memory>
+#include <functional>
+#include <unordered_map>
 #include "client.h"
+#include "connection-table.h"
 #include "utils.h"
 #include "http-utils.h"
+#include "platform.h"
+#include "poller.h"
+#include "timer-wheel.h"
+#include "router.h"
+#include "metrics.h"
+#include "blocking-pool.h"
+#include "admission.h"
+
+class UringEngine;
+
+static constexpr size_t MAX_PIPELINE = 64;    // Responses queued per connection before parsing pauses
+static constexpr size_t MAX_SEND_SLICES = 64; // Buffers gathered into one send
+static constexpr size_t ACCEPT_BATCH = 64;    // Connections accepted per event-loop iteration (poll engine)
+static constexpr size_t CHUNK_HEADER_SIZE = 10; // "xxxxxxxx\r\n": fixed-width chunk-size line of streamed bodies
+static constexpr uint64_t HEADER_TIMEOUT_MS = 20 * 1000;      // Time allowed to receive a request's headers
+static constexpr uint64_t BODY_TIMEOUT_MS = 30 * 1000;        // Longest pause while receiving a request body
+static constexpr uint64_t WRITE_STALL_TIMEOUT_MS = 30 * 1000; // Longest pause in draining queued responses
+static constexpr uint64_t SOCKET_WAIT_TIMEOUT_MS = 30 * 1000; // Longest a coroutine handler waits on readable()/writable()
+static constexpr uint64_t HOUSEKEEPING_INTERVAL_MS = 1000;    // Period of the pool report while clients are connected
+static constexpr uint64_t READ_RECHECK_MS = 10;               // Period of the memory budget check while reads are paused
+
+/**
+ * @brief Handler-owned socket a parked coroutine handler waits on.
+ */
+struct AsyncSocketWatch {
+    uint64_t client;   // Connection handle of the parked client
+    uint32_t sequence; // Distinguishes this watch from earlier ones on the same descriptor (io_uring)
+};
+
+/**
+ * @brief I/O engine selectable at startup.
+ */
+enum class IoEngine {
+    Poll,  // Readiness polling through Poller (epoll on Linux, select elsewhere)
+    Uring  // Completion-based io_uring engine (Linux only, falls back to Poll)
+};
 
 /**
  * Main Server class for TCP non-blocking async HTTP server.
@@ -22,38 +56,138 @@
  */
 class Server {
 public:
-	// Constructor: initializes Winsock and sets up the listening socket.
-    Server(const std::string& ip, int port, std::size_t bufferSize = 1024, std::time_t idleTImeout = 120);
-	// Destructor: cleans up all client connections and Winsock.
+	// Constructor: initializes the socket library and sets up the listening socket.
+	// With reusePort, several servers may bind the same ip:port (SO_REUSEPORT) and the kernel shards connections.
+    Server(const std::string& ip, int port, std::size_t bufferSize = 1024, std::time_t idleTImeout = 120, bool reusePort = false,
+           IoEngine ioEngine = IoEngine::Poll);
+	// Destructor: cleans up all client connections and the socket library.
     ~Server();
 	// Main server loop: handles connections and client events.
     void run();
 private:
+    friend class UringEngine; // Drives the same client FSM from io_uring completions
+
     std::string ip_; // Server IP address
     int port_;       // Server port
     SOCKET listenSocket; // Listening socket
-    std::map<SOCKET, Client> clients; // Connected clients
+    TimerWheel timers; // Per-connection deadlines (outlives clients)
+    BufferPool bufferPool; // Slab pool for client input buffers (outlives clients)
+    ConnectionTable clients; // Connected clients
     const std::size_t BUFF_SIZE; // Max size of the buffer
-    const time_t CLIENT_TIMEOUT; // 2 minutes
+    const time_t CLIENT_TIMEOUT; // Keep-alive idle timeout in seconds
     long long iteration; // Loop iteration counter
+    IoEngine engine; // I/O engine driving the loop
+    Poller poller; // Readiness multiplexer (epoll on Linux, select elsewhere)
+    std::vector<PollEvent> events; // Ready sockets returned by the last poll
+    uint64_t loopTime; // TimerWheel::now() when the current iteration woke up
+    TimerNode housekeeping; // Periodic maintenance timer (pool report)
+    std::vector<TimerNode*> expired; // Scratch list filled by timers.advance()
+    std::string lastPoolReport; // Buffer pool occupancy last written to the log
+    Router router; // Route table built once by registerRoutes()
+    ReactorMetrics metrics; // Counters reported by /metrics, written only by this reactor
+    CompletionQueue completions; // Jobs the I/O pool finished for this reactor's clients
+    std::vector<std::shared_ptr<BlockingJob>> finishedJobs; // Scratch list filled by completions.drain()
+    std::unordered_map<SOCKET, AsyncSocketWatch> asyncSockets; // Sockets coroutine handlers wait on, by descriptor
+    uint32_t asyncSequence; // Last AsyncSocketWatch::sequence handed out
+    std::vector<std::pair<SOCKET, uint32_t>> abandonedWatches; // Socket and sequence of io_uring polls to cancel
+    AdmissionControl admission; // Connection cap, per-address rate limits and load shedding
+    bool acceptPending; // The last accept batch was full: more connections may be waiting
+    std::vector<uint64_t> pausedReads; // Handles of clients whose reads are paused by the memory budget
+    TimerNode readRecheck; // Wakes the loop to retry paused reads (memory may be freed by another reactor)
 
     // Starts listening for incoming connections
     bool listen();
-    // Accepts a new client connection
+    // Accepts up to one batch of pending client connections
     void acceptConnection();
+    // Answers a connection that is not admitted with the pre-serialized 503 and closes it
+    void refuseConnection(SOCKET clientSocket);
+    // Applies load shedding and the client's rate limit to a new request; false with refusal set if it is not served
+    bool admitRequest(Client& client, Response& refusal);
     // Receives a message from a client
     void receiveMessage(Client& client);
-    // Sends a message to a client
+    // Sends the queued responses to a client
     void sendMessage(Client& client);
-    // Adds a new client to the clients map
-    bool addClient(SOCKET clientSocket, const sockaddr_in& addr);
-    // Prepares socket sets for select()
-    void prepareFdSets(fd_set& readfds, fd_set& writefds, fd_set& errorfds);
-    // Polls sockets for events using select()
-    bool pollEvents(fd_set& readfds, fd_set& writefds, fd_set& errorfds);
-    // Processes a client based on its state and socket readiness
-    void processClient(Client& client, fd_set& readfds, fd_set& writefds, fd_set& errorfds);
-    // Dispatches the request to the appropriate handler and prepares the response
-    void dispatch(Client& client); // FSM: RequestBuffered → ResponseReady
+    // Fills slices with unsent queued output for one gathered send (shared by all engines)
+    size_t gatherOutput(Client& client, IoSlice* slices, size_t maxSlices, bool& moreFollows);
+    // Buffers received bytes and advances the FSM when a request is complete (shared by all engines)
+    void onReceived(Client& client, const char* data, size_t length);
+    // Advances the FSM after length bytes were added to the client's input buffer
+    void onBuffered(Client& client, size_t length);
+    // Advances the send cursor and the FSM once every queued response is done (shared by all engines)
+    void onSent(Client& client, size_t length);
+    // Accounts for file body bytes sent (shared by all engines)
+    void onFileSent(Client& client, uint64_t length);
+    // Replaces the sent front response's in-memory parts with its next body chunk (shared by all engines)
+    void nextChunk(Client& client);
+    // Moves the client to AwaitingRequest (or RequestBuffered) or Completed after the last response
+    void finishResponse(Client& client);
+    // Adds a new client to the connection table; nullptr on failure
+    Client* addClient(SOCKET clientSocket, const sockaddr_in& addr);
+    // Removes a client from the poller and the connection table, closing its socket
+    void removeClient(SOCKET clientSocket);
+    // Pops the fully sent front response and records its latency
+    void completeResponse(Client& client);
+    // Re-registers poller interest if the client's state needs a different one
+    void updateInterest(Client& client);
+    // Logs the iteration separator and bumps the loop counter
+    void logIteration();
+    // Polls sockets for events using the poller
+    bool pollEvents();
+    // Processes a client based on its state and the ready events
+    void processClient(Client& client, unsigned readyEvents);
+    // Arms the client's timer for the deadline that matches its state
+    void updateTimeout(Client& client);
+    // Expires due timers: aborts timed-out clients, wakes sleeping handlers (then calls advance) and runs housekeeping
+    void expireTimers(const std::function<void(Client&)>& advance);
+    // Logs the buffer pool occupancy when it changed
+    void reportPool();
+    // Records how many open connections are in each state for /metrics
+    void sampleConnections();
+    // Dispatches every complete buffered request and queues the responses; true if any was queued
+    bool dispatch(Client& client); // FSM: RequestBuffered → ResponseReady
+    // Hands a deferred response's file operation to the I/O pool and parks the client; false if it ran inline
+    bool deferResponse(Client& client, Response& response, const Request& request, Method method, uint64_t startedUs);
+    // Resumes the clients whose I/O pool jobs are done (shared by all engines)
+    void finishJobs(const std::function<void(Client&)>& advance);
+    // Serializes a response's head, counts it and appends it to the client's output queue
+    void queueResponse(Client& client, Response& response, Method method, uint64_t startedUs);
+    // Starts streaming a PUT body to disk once its headers are in; false if the request is not an upload
+    bool startUpload(Client& client);
+    // Writes the buffered part of an upload's body and drops it from the input buffer
+    bool writeUpload(Client& client);
+    // Answers a request that cannot be read further (rejected upload, write error) and closes after it
+    void rejectRequest(Client& client, Response& response, Method method);
+    // Registers every endpoint with the router
+    void registerRoutes();
+    // Runs the synchronous handler router.find() matched, or answers 400, 404 or 405
+    Response route(Request& request, Method method, Router::Match match, const Router::Route* target);
+    // Starts a coroutine handler on the request at the front of inBuffer (headers complete)
+    void startAsync(Client& client, const Router::Route& target, Method method, uint64_t startedUs);
+    // Starts a coroutine handler while the request body is still arriving; false if the route is not one
+    bool beginAsync(Client& client);
+    // Resumes the client's coroutine handler until it returns (true) or waits on something not ready yet
+    bool runAsync(Client& client);
+    // Runs the client's coroutine handler after a wake-up and moves the client on once it returns
+    void resumeAsync(Client& client);
+    // Hands the handler the next buffered piece of the body; false if it has to wait for more
+    bool takeBodyChunk(Client& client);
+    // Returns true if reading more from the client would exceed the memory budget
+    bool readsOverBudget(const Client& client) const;
+    // Stops reading from the client until the memory budget allows it again
+    void pauseReads(Client& client);
+    // Calls resume for every paused client the memory budget now allows to read (shared by all engines)
+    void resumeReads(const std::function<void(Client&)>& resume);
+    // Answers 413 and closes if the incomplete request at the front of inBuffer cannot fit in memory
+    bool rejectOversized(Client& client);
+    // Stamps headers and message completion on the request being parsed (access log phases)
+    void stampParse(Client& client, ParseStatus status, uint64_t nowUs);
+    // Records the socket a parked handler waits on; false if there is no new socket wait
+    bool armAsyncSocket(Client& client);
+    // Resumes the handler waiting on socket; returns its client, or nullptr if the watch is stale
+    Client* wakeAsyncSocket(SOCKET socket, unsigned events);
+    // Stops watching a handler's socket whose wait ends without an event (timeout or closed connection)
+    void abandonAsyncSocket(SOCKET socket);
+    // Advances a client woken by something other than its own socket (poll engine) and reaps it if it closed
+    void resumeClient(Client& client);
 };
 
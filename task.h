@@ -0,0 +1,81 @@
+#pragma once
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <utility>
+
+/**
+ * @brief Lazily started coroutine that produces a T.
+ * @details A Task does not run until it is awaited or resumed by its owner. Awaiting it from
+ *          another coroutine starts it and suspends the caller; when it returns, the caller is
+ *          resumed straight from its final suspend point (symmetric transfer), so chains of
+ *          awaited Tasks do not grow the stack. The top-level Task of a coroutine handler is
+ *          owned and resumed by the Server. The code base does not use exceptions, so one that
+ *          escapes a coroutine terminates the process.
+ */
+template <typename T>
+class Task {
+public:
+    // Resumes the awaiting coroutine, if any, once the Task has returned
+    struct FinalAwaiter {
+        bool await_ready() const noexcept { return false; }
+        template <typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> finished) noexcept {
+            std::coroutine_handle<> continuation = finished.promise().continuation;
+            return continuation ? continuation : std::noop_coroutine();
+        }
+        void await_resume() const noexcept {}
+    };
+
+    struct promise_type {
+        std::optional<T> value;               // Result, set by co_return
+        std::coroutine_handle<> continuation; // Coroutine awaiting this one, resumed when it returns
+
+        Task get_return_object() noexcept { return Task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+        std::suspend_always initial_suspend() const noexcept { return {}; }
+        FinalAwaiter final_suspend() const noexcept { return {}; }
+        void return_value(T result) { value.emplace(std::move(result)); }
+        void unhandled_exception() const noexcept { std::terminate(); }
+    };
+
+    Task() = default;
+    Task(Task&& other) noexcept : coroutine(std::exchange(other.coroutine, nullptr)) {}
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            reset();
+            coroutine = std::exchange(other.coroutine, nullptr);
+        }
+        return *this;
+    }
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+    ~Task() { reset(); }
+
+    // Returns the coroutine, for the owner that starts it
+    std::coroutine_handle<> handle() const { return coroutine; }
+    // Returns true once the coroutine has returned
+    bool done() const { return !coroutine || coroutine.done(); }
+    // Moves the result out (only after done())
+    T take() { return std::move(*coroutine.promise().value); }
+
+    // Awaiting a Task starts it and resumes the caller with its result
+    bool await_ready() const noexcept { return done(); }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+        coroutine.promise().continuation = awaiting;
+        return coroutine;
+    }
+    T await_resume() { return take(); }
+
+private:
+    std::coroutine_handle<promise_type> coroutine; // Owned coroutine frame, null when empty
+
+    explicit Task(std::coroutine_handle<promise_type> coroutine) : coroutine(coroutine) {}
+
+    // Destroys the coroutine frame
+    void reset() {
+        if (coroutine) {
+            coroutine.destroy();
+            coroutine = nullptr;
+        }
+    }
+};
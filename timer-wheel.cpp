@@ -0,0 +1,203 @@
+#include "timer-wheel.h"
+#include <chrono>
+#include <climits>
+
+static constexpr uint64_t SLOT_MASK = TimerWheel::SLOTS - 1;
+
+/**
+ * @brief Creates a disarmed timer.
+ */
+TimerNode::TimerNode() : prev(nullptr), next(nullptr), deadline(0), key(0) {}
+
+/**
+ * @brief Removes the timer from its wheel so the wheel never points at a dead owner.
+ */
+TimerNode::~TimerNode() {
+    unlink();
+}
+
+/**
+ * @brief Removes the node from its slot list (no-op when not armed).
+ */
+void TimerNode::unlink() {
+    if (next == nullptr) {
+        return;
+    }
+    prev->next = next;
+    next->prev = prev;
+    prev = next = nullptr;
+}
+
+/**
+ * @brief Creates an empty wheel.
+ * @param nowMs Current time from now()
+ */
+TimerWheel::TimerWheel(uint64_t nowMs) : current(nowMs / TICK_MS) {
+    for (auto& level : slots) {
+        for (TimerNode& sentinel : level) {
+            sentinel.prev = sentinel.next = &sentinel;
+        }
+    }
+}
+
+/**
+ * @brief Detaches the timers still armed so their owners can outlive the wheel.
+ */
+TimerWheel::~TimerWheel() {
+    for (auto& level : slots) {
+        for (TimerNode& sentinel : level) {
+            while (sentinel.next != &sentinel) {
+                sentinel.next->unlink();
+            }
+            sentinel.prev = sentinel.next = nullptr;
+        }
+    }
+}
+
+/**
+ * @brief Returns a monotonic timestamp in milliseconds (unaffected by wall clock changes).
+ */
+uint64_t TimerWheel::now() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+/**
+ * @brief Arms a timer, replacing any deadline it already had.
+ * @details The deadline is rounded up to the next tick so a timer never fires early.
+ * @param node Timer to arm
+ * @param deadlineMs Absolute expiry time in now() milliseconds
+ */
+void TimerWheel::schedule(TimerNode& node, uint64_t deadlineMs) {
+    node.unlink();
+    uint64_t tick = (deadlineMs + TICK_MS - 1) / TICK_MS;
+    node.deadline = tick > current ? tick : current + 1;
+    link(node);
+}
+
+/**
+ * @brief Disarms a timer.
+ * @param node Timer to disarm
+ */
+void TimerWheel::cancel(TimerNode& node) {
+    node.unlink();
+}
+
+/**
+ * @brief Advances the wheel to nowMs.
+ * @details Runs of ticks with nothing due are skipped in one jump, so a long poll timeout
+ *          costs one slot scan rather than one step per elapsed tick.
+ * @param nowMs Current time from now()
+ * @param expired Receives the expired timers, in expiry order
+ */
+void TimerWheel::advance(uint64_t nowMs, std::vector<TimerNode*>& expired) {
+    uint64_t target = nowMs / TICK_MS;
+    while (current < target) {
+        uint64_t due = nextTick();
+        if (due > target) {
+            current = target;
+            return;
+        }
+        current = due - 1;
+        step(expired);
+    }
+}
+
+/**
+ * @brief Returns when advance() next has work to do.
+ * @return Milliseconds in the now() clock, or UINT64_MAX if no timer is armed
+ */
+uint64_t TimerWheel::nextDeadline() const {
+    uint64_t tick = nextTick();
+    return tick == UINT64_MAX ? UINT64_MAX : tick * TICK_MS;
+}
+
+/**
+ * @brief Returns how long a poll may block before the next timer is due.
+ * @param nowMs Current time from now()
+ * @return Milliseconds (0 if already due), or -1 if no timer is armed
+ */
+int TimerWheel::timeoutMs(uint64_t nowMs) const {
+    uint64_t deadline = nextDeadline();
+    if (deadline == UINT64_MAX) {
+        return -1;
+    }
+    if (deadline <= nowMs) {
+        return 0;
+    }
+    uint64_t wait = deadline - nowMs;
+    return wait > static_cast<uint64_t>(INT_MAX) ? INT_MAX : static_cast<int>(wait);
+}
+
+/**
+ * @brief Finds the first tick after current at which a level 0 slot fires or a higher slot cascades.
+ * @return Tick, or UINT64_MAX if every slot is empty
+ */
+uint64_t TimerWheel::nextTick() const {
+    uint64_t best = UINT64_MAX;
+    for (unsigned level = 0; level < LEVELS; ++level) {
+        unsigned shift = level * SLOT_BITS;
+        uint64_t position = current >> shift;
+        for (uint64_t offset = 1; offset <= SLOTS; ++offset) {
+            const TimerNode& sentinel = slots[level][(position + offset) & SLOT_MASK];
+            if (sentinel.next != &sentinel) {
+                uint64_t tick = (position + offset) << shift;
+                if (tick < best) {
+                    best = tick;
+                }
+                break;
+            }
+        }
+    }
+    return best;
+}
+
+/**
+ * @brief Links a timer into the level whose span covers its distance from current.
+ * @details Slots are indexed by the deadline's own bits at that level, so a timer cascades
+ *          exactly when the level below wraps onto its range. Deadlines beyond the top level
+ *          are parked in the farthest top-level slot and re-linked when it cascades.
+ * @param node Timer with deadline set
+ */
+void TimerWheel::link(TimerNode& node) {
+    uint64_t delta = node.deadline - current;
+    unsigned level = 0;
+    while (level + 1 < LEVELS && delta >= (uint64_t(1) << ((level + 1) * SLOT_BITS))) {
+        level++;
+    }
+    uint64_t slot = node.deadline >> (level * SLOT_BITS);
+    if (delta >= (uint64_t(1) << (LEVELS * SLOT_BITS))) {
+        slot = (current >> (level * SLOT_BITS)) - 1; // Farthest slot: one full rotation away
+    }
+    TimerNode& sentinel = slots[level][slot & SLOT_MASK];
+    node.prev = sentinel.prev;
+    node.next = &sentinel;
+    sentinel.prev->next = &node;
+    sentinel.prev = &node;
+}
+
+/**
+ * @brief Moves to the next tick, cascading every level that wrapped and expiring level 0's slot.
+ * @param expired Receives the timers due at the new tick
+ */
+void TimerWheel::step(std::vector<TimerNode*>& expired) {
+    current++;
+    for (unsigned level = 1; level < LEVELS; ++level) {
+        unsigned shift = level * SLOT_BITS;
+        if ((current & ((uint64_t(1) << shift) - 1)) != 0) {
+            break;
+        }
+        TimerNode& sentinel = slots[level][(current >> shift) & SLOT_MASK];
+        while (sentinel.next != &sentinel) {
+            TimerNode* node = sentinel.next;
+            node->unlink();
+            link(*node);
+        }
+    }
+    TimerNode& sentinel = slots[0][current & SLOT_MASK];
+    while (sentinel.next != &sentinel) {
+        TimerNode* node = sentinel.next;
+        node->unlink();
+        expired.push_back(node);
+    }
+}
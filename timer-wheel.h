@@ -0,0 +1,79 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * @brief Intrusive timer embedded in the object it times out.
+ * @details Linked into one slot list of a TimerWheel while armed; unlinking needs only the
+ *          neighbours, so cancelling and rescheduling are O(1) and a destroyed owner removes
+ *          itself from the wheel.
+ */
+struct TimerNode {
+    TimerNode* prev;   // Previous node in the slot list (null when not armed)
+    TimerNode* next;   // Next node in the slot list (null when not armed)
+    uint64_t deadline; // Expiry tick
+    uint64_t key;      // Owner identifier reported on expiry (e.g. the client socket)
+
+    TimerNode();
+    // Unlinks the node if it is still armed
+    ~TimerNode();
+
+    TimerNode(const TimerNode&) = delete;
+    TimerNode& operator=(const TimerNode&) = delete;
+
+    // Returns true while the node is scheduled
+    bool isLinked() const { return next != nullptr; }
+    // Removes the node from its slot list
+    void unlink();
+};
+
+/**
+ * @brief Hierarchical timing wheel with millisecond deadlines.
+ * @details Four levels of 64 slots; level 0 has TICK_MS resolution and each higher level
+ *          covers 64 times the span of the one below (up to ~46 hours). A timer sits in the
+ *          level matching how far away it is and cascades one level down each time the level
+ *          below wraps, so scheduling, cancelling and expiring are O(1) per timer and an
+ *          advance only touches slots that are due, independent of how many timers are armed.
+ *          Used from a single reactor thread.
+ */
+class TimerWheel {
+public:
+    static constexpr uint64_t TICK_MS = 10;           // Resolution of level 0
+    static constexpr unsigned LEVELS = 4;             // Number of wheel levels
+    static constexpr unsigned SLOT_BITS = 6;          // log2 of the slots per level
+    static constexpr unsigned SLOTS = 1u << SLOT_BITS; // Slots per level
+
+    // Creates an empty wheel positioned at nowMs
+    explicit TimerWheel(uint64_t nowMs = now());
+    // Detaches every timer still armed
+    ~TimerWheel();
+
+    TimerWheel(const TimerWheel&) = delete;
+    TimerWheel& operator=(const TimerWheel&) = delete;
+
+    // Returns the monotonic clock in milliseconds
+    static uint64_t now();
+
+    // Arms (or re-arms) node to expire at deadlineMs; past deadlines expire on the next advance
+    void schedule(TimerNode& node, uint64_t deadlineMs);
+    // Disarms node if it is armed
+    void cancel(TimerNode& node);
+    // Moves the wheel to nowMs and appends every expired node (already unlinked) to expired
+    void advance(uint64_t nowMs, std::vector<TimerNode*>& expired);
+    // Returns the time at which advance() next has work to do, or UINT64_MAX if nothing is armed
+    uint64_t nextDeadline() const;
+    // Returns the milliseconds to wait from nowMs before advancing, or -1 if nothing is armed
+    int timeoutMs(uint64_t nowMs) const;
+
+private:
+    TimerNode slots[LEVELS][SLOTS]; // Slot list sentinels
+    uint64_t current;               // Last processed tick
+
+    // Returns the tick at which the next slot fires or cascades, or UINT64_MAX
+    uint64_t nextTick() const;
+    // Links node into the slot matching its deadline relative to current
+    void link(TimerNode& node);
+    // Processes tick current + 1: cascades wrapped levels and expires level 0's slot
+    void step(std::vector<TimerNode*>& expired);
+};
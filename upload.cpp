@@ -0,0 +1,128 @@
+#include "upload.h"
+#include <atomic>
+#include <cstdio>
+#include <cerrno>
+#ifdef _WIN32
+#include <process.h>
+#endif
+
+static constexpr int MAX_TEMP_ATTEMPTS = 8; // Names tried before giving up on a temporary file
+
+static std::atomic<uint64_t> uploadCounter(0); // Unique suffix for temporary files across reactors
+
+/**
+ * @brief Returns the current process id, used to keep temporary names apart between servers.
+ */
+static unsigned long processId() {
+#ifdef _WIN32
+    return static_cast<unsigned long>(_getpid());
+#else
+    return static_cast<unsigned long>(getpid());
+#endif
+}
+
+/**
+ * @brief Creates a fresh temporary file next to the target.
+ * @details The name starts with a dot so it can never be resolved as content, and O_EXCL
+ *          guarantees that two uploads never share one.
+ * @param targetPath Final location of the upload
+ * @param baseName Base name of the target
+ */
+FileUpload::FileUpload(const std::string& targetPath, const std::string& baseName)
+    : targetPath(targetPath), baseName(baseName), fd(-1), written(0), committed(false) {
+    std::string dir = targetPath.substr(0, targetPath.find_last_of("\\/") + 1);
+    for (int attempt = 0; attempt < MAX_TEMP_ATTEMPTS && fd == -1; ++attempt) {
+        tempPath = dir + ".upload-" + std::to_string(processId()) + "-"
+            + std::to_string(uploadCounter.fetch_add(1, std::memory_order_relaxed)) + ".tmp";
+#ifdef _WIN32
+        fd = _open(tempPath.c_str(), _O_WRONLY | _O_CREAT | _O_EXCL | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+        fd = ::open(tempPath.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+#endif
+        if (fd == -1 && errno != EEXIST) {
+            break;
+        }
+    }
+}
+
+/**
+ * @brief Discards an upload that was never committed.
+ */
+FileUpload::~FileUpload() {
+    close();
+    if (!committed && !tempPath.empty()) {
+        std::remove(tempPath.c_str());
+    }
+}
+
+/**
+ * @brief Returns true if the temporary file is open for writing.
+ */
+bool FileUpload::isOpen() const {
+    return fd != -1;
+}
+
+/**
+ * @brief Appends bytes to the temporary file.
+ * @details Writes go through the page cache, so they cost a copy but no disk wait in the
+ *          common case; short writes are retried until everything is out.
+ * @param data Bytes to write
+ * @param length Number of bytes
+ * @return False if the file is closed or the write failed (e.g. disk full)
+ */
+bool FileUpload::write(const char* data, size_t length) {
+    while (length > 0 && fd != -1) {
+#ifdef _WIN32
+        unsigned piece = static_cast<unsigned>(length < 0x40000000 ? length : 0x40000000);
+        int result = _write(fd, data, piece);
+#else
+        ssize_t result = ::write(fd, data, length);
+        if (result < 0 && errno == EINTR) {
+            continue;
+        }
+#endif
+        if (result <= 0) {
+            return false;
+        }
+        data += result;
+        length -= static_cast<size_t>(result);
+        written += static_cast<uint64_t>(result);
+    }
+    return fd != -1;
+}
+
+/**
+ * @brief Renames the temporary file over the target.
+ * @param replaced Set to true if a file already existed at the target
+ * @return False if the file could not be closed or moved
+ */
+bool FileUpload::commit(bool& replaced) {
+    if (fd == -1) {
+        return false;
+    }
+    close();
+#ifdef _WIN32
+    replaced = _access(targetPath.c_str(), 0) == 0;
+    committed = MoveFileExA(tempPath.c_str(), targetPath.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    struct stat st;
+    replaced = ::stat(targetPath.c_str(), &st) == 0;
+    committed = std::rename(tempPath.c_str(), targetPath.c_str()) == 0;
+#endif
+    return committed;
+}
+
+/**
+ * @brief Closes the temporary file.
+ */
+void FileUpload::close() {
+    if (fd == -1) {
+        return;
+    }
+#ifdef _WIN32
+    _close(fd);
+#else
+    ::close(fd);
+#endif
+    fd = -1;
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include "platform.h"
+
+/**
+ * @brief A file being written by a PUT request.
+ * @details Bytes go to a temporary file next to the target as they arrive; commit() renames
+ *          it over the target in one step, so readers see either the old file or the complete
+ *          new one, never a partial upload. An upload that is not committed (client gone,
+ *          write error) removes its temporary file.
+ */
+class FileUpload {
+public:
+    // Creates the temporary file for targetPath; check isOpen()
+    FileUpload(const std::string& targetPath, const std::string& baseName);
+    // Closes and removes the temporary file unless it was committed
+    ~FileUpload();
+
+    FileUpload(const FileUpload&) = delete;
+    FileUpload& operator=(const FileUpload&) = delete;
+
+    // Returns true if the temporary file was created
+    bool isOpen() const;
+    // Appends length bytes; returns false on a write error
+    bool write(const char* data, size_t length);
+    // Moves the temporary file over the target; replaced tells whether the target existed
+    bool commit(bool& replaced);
+
+    // Returns the path the upload is committed to
+    const std::string& target() const { return targetPath; }
+    // Returns the base name of the target (cache invalidation key)
+    const std::string& name() const { return baseName; }
+    // Returns the bytes written so far
+    uint64_t size() const { return written; }
+
+private:
+    std::string targetPath; // Final location
+    std::string baseName;   // Target base name without extension
+    std::string tempPath;   // Temporary file in the same directory
+    int fd;                 // Temporary file descriptor, -1 once closed
+    uint64_t written;       // Bytes written
+    bool committed;         // True once renamed into place
+
+    // Closes the descriptor if it is open
+    void close();
+};
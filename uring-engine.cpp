@@ -0,0 +1,494 @@
+#include "uring-engine.h"
+#ifdef __linux__
+#include "content-cache.h"
+#include <poll.h>
+#include <cerrno>
+#include <algorithm>
+#include <cstring>
+
+static constexpr unsigned RING_ENTRIES = 4096;   // Submission queue size
+static constexpr unsigned RECV_BUFFERS = 4096;   // Provided receive buffers (power of two)
+static constexpr unsigned RECV_BUFFER_SIZE = 4096; // Size of each provided receive buffer
+static constexpr uint16_t RECV_GROUP = 0;        // Buffer group used by multishot receives
+static constexpr uint64_t FILE_CHUNK_SIZE = 64 * 1024; // File body bytes staged per send
+
+/**
+ * @brief Sets up the ring and registers the provided receive buffers.
+ * @param server Server whose clients and FSM are driven
+ */
+UringEngine::UringEngine(Server& server)
+    : server(server), ring(RING_ENTRIES), valid(false), tickArmed(false), tickArmedAt(0) {
+    tickDeadline.tv_sec = 0;
+    tickDeadline.tv_nsec = 0;
+    valid = ring.isValid() && ring.registerBuffers(RECV_BUFFERS, RECV_BUFFER_SIZE, RECV_GROUP);
+}
+
+/**
+ * @brief Returns true if io_uring and provided buffer rings are supported.
+ */
+bool UringEngine::isValid() const {
+    return valid;
+}
+
+/**
+ * @brief Packs an operation, descriptor and connection generation into user_data.
+ */
+uint64_t UringEngine::pack(Op op, SOCKET s, uint32_t generation) {
+    return (static_cast<uint64_t>(op) << 56) | (static_cast<uint64_t>(generation & 0xFFFFFF) << 32) | static_cast<uint32_t>(s);
+}
+
+/**
+ * @brief Runs the completion loop: one io_uring_enter per iteration submits every queued SQE.
+ */
+void UringEngine::run() {
+    armAccept();
+    armWatch();
+    armJobs();
+    while (true) {
+        server.logIteration();
+        int ret = ring.submitAndWait(1);
+        server.loopTime = TimerWheel::now();
+        server.admission.loopWoke(metricsClockUs());
+        if (ret < 0 && ret != -EINTR && ret != -EBUSY) {
+            logError("Error at io_uring_enter()", -ret);
+            return;
+        }
+        while (io_uring_cqe* cqe = ring.peekCqe()) {
+            io_uring_cqe completion = *cqe;
+            ring.advanceCqe();
+            handleCompletion(completion);
+        }
+        server.expireTimers([this](Client& client) { advance(client); });
+        server.resumeReads([this](Client& client) {
+            if (!receiving[client.socket]) {
+                armRecv(client.socket);
+            }
+        });
+        cancelAwaits();
+        server.admission.loopDone(metricsClockUs());
+        armTick();
+    }
+}
+
+/**
+ * @brief Queues a multishot accept on the listen socket.
+ */
+void UringEngine::armAccept() {
+    io_uring_sqe* sqe = ring.getSqe();
+    if (sqe == nullptr) {
+        logError("io_uring submission queue full (accept)");
+        return;
+    }
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->fd = server.listenSocket;
+    sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+    sqe->user_data = pack(OP_ACCEPT, server.listenSocket, 0);
+}
+
+/**
+ * @brief Queues a multishot receive that picks buffers from the provided-buffer ring.
+ * @param s Client socket
+ */
+void UringEngine::armRecv(SOCKET s) {
+    io_uring_sqe* sqe = ring.getSqe();
+    if (sqe == nullptr) {
+        logError("io_uring submission queue full (recv)");
+        return;
+    }
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = s;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = RECV_GROUP;
+    sqe->user_data = pack(OP_RECV, s, generations[s]);
+    receiving[s] = 1;
+}
+
+/**
+ * @brief Cancels the multishot receive of a client whose reads are paused.
+ * @details Receives already completed are still delivered; the final completion does not
+ *          re-arm while the client is paused, and resumeReads() arms a new one afterwards.
+ * @param s Client socket
+ */
+void UringEngine::cancelRecv(SOCKET s) {
+    io_uring_sqe* sqe = ring.getSqe();
+    if (sqe == nullptr) {
+        logError("io_uring submission queue full (cancel)");
+        return; // The receive keeps running: reads are not paused, only slower to stop
+    }
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->fd = -1;
+    sqe->addr = pack(OP_RECV, s, generations[s]);
+    sqe->user_data = pack(OP_CANCEL, s, 0);
+}
+
+/**
+ * @brief Queues one gathered send (IORING_OP_SENDMSG) of the client's queued responses.
+ * @details The slices point into outQueue entries, which stay untouched until the completion;
+ *          sendInFlight keeps removeClient() from freeing them before it arrives.
+ *          File-backed bodies are read into their response's body in bounded chunks once the
+ *          headers are out, since sendfile() needs readiness that this engine does not track.
+ * @param client Reference to client object
+ */
+void UringEngine::armSend(Client& client) {
+    OutboundResponse& front = client.outQueue.front();
+    if (client.outOffset == front.memorySize() && front.fileRemaining > 0) {
+        // The head is out: the next file chunk becomes the in-memory body
+        int64_t before = static_cast<int64_t>(front.ownedSize());
+        client.recycleHead(front);
+        front.sharedBody.reset();
+        size_t chunk = static_cast<size_t>((std::min)(front.fileRemaining, FILE_CHUNK_SIZE));
+        front.body.resize(chunk);
+        ssize_t bytesRead = pread(front.file->get(), &front.body[0], chunk, static_cast<off_t>(front.fileOffset));
+        if (bytesRead <= 0) {
+            logError("Error at pread()", errno, client.clientAddr);
+            client.setAborted();
+            return;
+        }
+        front.body.resize(static_cast<size_t>(bytesRead));
+        client.chargeOutput(static_cast<int64_t>(front.ownedSize()) - before);
+        front.fileOffset += static_cast<uint64_t>(bytesRead);
+        front.fileRemaining -= static_cast<uint64_t>(bytesRead);
+        client.outOffset = 0;
+    }
+    else if (client.outOffset == front.memorySize() && front.stream) {
+        server.nextChunk(client);
+    }
+    std::unique_ptr<SendSlot>& slot = sends[client.socket];
+    if (!slot) {
+        slot = std::make_unique<SendSlot>();
+    }
+    bool moreFollows = false;
+    std::memset(&slot->message, 0, sizeof(slot->message));
+    slot->message.msg_iov = slot->slices;
+    slot->message.msg_iovlen = server.gatherOutput(client, slot->slices, MAX_SEND_SLICES, moreFollows);
+    io_uring_sqe* sqe = ring.getSqe();
+    if (sqe == nullptr) {
+        logError("io_uring submission queue full (send)", -1, client.clientAddr);
+        client.setAborted();
+        return;
+    }
+    sqe->opcode = IORING_OP_SENDMSG;
+    sqe->fd = client.socket;
+    sqe->addr = reinterpret_cast<uint64_t>(&slot->message);
+    sqe->len = 1;
+    sqe->msg_flags = moreFollows ? SEND_MORE_FLAGS : SEND_FLAGS;
+    sqe->user_data = pack(OP_SEND, client.socket, generations[client.socket]);
+    client.sendInFlight = true;
+}
+
+/**
+ * @brief Makes sure a timeout wakes the loop by the timer wheel's next deadline.
+ * @details At most one absolute CLOCK_MONOTONIC timeout is in flight (the clock behind
+ *          TimerWheel::now()). When the next deadline moves earlier the pending timeout is
+ *          updated in place; a timeout that fires late or for nothing just leads to an empty
+ *          advance and a new timeout.
+ */
+void UringEngine::armTick() {
+    uint64_t deadline = server.timers.nextDeadline();
+    if (deadline == UINT64_MAX || (tickArmed && tickArmedAt <= deadline)) {
+        return;
+    }
+    io_uring_sqe* sqe = ring.getSqe();
+    if (sqe == nullptr) {
+        return;
+    }
+    tickDeadline.tv_sec = static_cast<long long>(deadline / 1000);
+    tickDeadline.tv_nsec = static_cast<long long>(deadline % 1000) * 1000000;
+    sqe->fd = -1;
+    sqe->timeout_flags = IORING_TIMEOUT_ABS;
+    if (tickArmed) {
+        // The new expiry is copied when the update is submitted
+        sqe->opcode = IORING_OP_TIMEOUT_REMOVE;
+        sqe->addr = pack(OP_TICK, 0, 0);
+        sqe->addr2 = reinterpret_cast<uint64_t>(&tickDeadline);
+        sqe->timeout_flags |= IORING_TIMEOUT_UPDATE;
+        sqe->user_data = pack(OP_TICK_UPDATE, 0, 0);
+    }
+    else {
+        sqe->opcode = IORING_OP_TIMEOUT;
+        sqe->addr = reinterpret_cast<uint64_t>(&tickDeadline);
+        sqe->len = 1;
+        sqe->user_data = pack(OP_TICK, 0, 0);
+    }
+    tickArmed = true;
+    tickArmedAt = deadline;
+}
+
+/**
+ * @brief Queues a multishot poll that reports content directory changes.
+ */
+void UringEngine::armWatch() {
+    int watchFd = ContentCache::local().watchHandle();
+    if (watchFd == -1) {
+        return;
+    }
+    io_uring_sqe* sqe = ring.getSqe();
+    if (sqe == nullptr) {
+        logError("io_uring submission queue full (watch)");
+        return;
+    }
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = watchFd;
+    sqe->poll32_events = POLLIN;
+    sqe->len = IORING_POLL_ADD_MULTI;
+    sqe->user_data = pack(OP_WATCH, watchFd, 0);
+}
+
+/**
+ * @brief Queues a multishot poll that reports jobs finished by the I/O pool.
+ */
+void UringEngine::armJobs() {
+    int jobsFd = server.completions.handle();
+    if (jobsFd == -1) {
+        return;
+    }
+    io_uring_sqe* sqe = ring.getSqe();
+    if (sqe == nullptr) {
+        logError("io_uring submission queue full (jobs)");
+        return;
+    }
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = jobsFd;
+    sqe->poll32_events = POLLIN;
+    sqe->len = IORING_POLL_ADD_MULTI;
+    sqe->user_data = pack(OP_JOBS, jobsFd, 0);
+}
+
+/**
+ * @brief Queues a one-shot poll on the socket a parked coroutine handler waits on.
+ * @details The watch's sequence number goes into user_data, so a completion for an earlier
+ *          watch on a reused descriptor is recognised and ignored.
+ * @param client Client whose handler may have started a socket wait
+ */
+void UringEngine::armAwait(Client& client) {
+    if (!server.armAsyncSocket(client)) {
+        return;
+    }
+    SOCKET s = client.async->socket;
+    io_uring_sqe* sqe = ring.getSqe();
+    if (sqe == nullptr) {
+        logError("io_uring submission queue full (await)");
+        server.asyncSockets.erase(s);
+        client.setAborted();
+        return;
+    }
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = s;
+    sqe->poll32_events = client.async->wait == AsyncWait::Readable ? POLLIN : POLLOUT;
+    sqe->user_data = pack(OP_AWAIT, s, server.asyncSockets[s].sequence);
+}
+
+/**
+ * @brief Cancels the polls of socket waits that timed out or whose connection was removed.
+ * @details Removal goes by user_data, so it works after the handler closed the descriptor and
+ *          cannot hit a later watch on the same descriptor. A poll that already fired makes the
+ *          removal fail harmlessly; either way its completion finds no matching watch.
+ */
+void UringEngine::cancelAwaits() {
+    for (const auto& [s, sequence] : server.abandonedWatches) {
+        io_uring_sqe* sqe = ring.getSqe();
+        if (sqe == nullptr) {
+            logError("io_uring submission queue full (poll remove)");
+            break;
+        }
+        sqe->opcode = IORING_OP_POLL_REMOVE;
+        sqe->fd = -1;
+        sqe->addr = pack(OP_AWAIT, s, sequence);
+        sqe->user_data = pack(OP_CANCEL, s, 0);
+    }
+    server.abandonedWatches.clear();
+}
+
+/**
+ * @brief Routes a completion to the handler for its operation.
+ * @param cqe Completion entry (copied out of the ring)
+ */
+void UringEngine::handleCompletion(const io_uring_cqe& cqe) {
+    Op op = static_cast<Op>(cqe.user_data >> 56);
+    uint32_t generation = static_cast<uint32_t>(cqe.user_data >> 32) & 0xFFFFFF;
+    SOCKET s = static_cast<SOCKET>(cqe.user_data & 0xFFFFFFFF);
+    switch (op) {
+        case OP_ACCEPT:
+            onAccept(cqe);
+            break;
+        case OP_RECV:
+            onRecv(s, generation, cqe);
+            break;
+        case OP_SEND:
+            onSend(s, generation, cqe);
+            break;
+        case OP_TICK:
+            // Due timers are expired after every batch of completions
+            tickArmed = false;
+            break;
+        case OP_TICK_UPDATE:
+        case OP_CANCEL:
+            break;
+        case OP_WATCH:
+            ContentCache::local().processEvents();
+            if (!(cqe.flags & IORING_CQE_F_MORE)) {
+                armWatch();
+            }
+            break;
+        case OP_AWAIT: {
+            auto it = server.asyncSockets.find(s);
+            if (it == server.asyncSockets.end() || it->second.sequence != generation) {
+                break; // The handler or its connection is gone
+            }
+            unsigned events = 0;
+            if (cqe.res < 0 || (cqe.res & (POLLERR | POLLHUP))) {
+                events |= POLL_ERROR;
+            }
+            if (Client* client = server.wakeAsyncSocket(s, events)) {
+                advance(*client);
+            }
+            break;
+        }
+        case OP_JOBS:
+            server.finishJobs([this](Client& client) { advance(client); });
+            if (!(cqe.flags & IORING_CQE_F_MORE)) {
+                armJobs();
+            }
+            break;
+    }
+}
+
+/**
+ * @brief Returns the live client for a completion.
+ * @details A descriptor can be closed and reused while completions for its previous
+ *          connection are still queued; those carry an old generation and are ignored.
+ * @return Client pointer, or nullptr if the completion is stale
+ */
+Client* UringEngine::findClient(SOCKET s, uint32_t generation) {
+    if (s < 0 || static_cast<size_t>(s) >= generations.size() || (generations[s] & 0xFFFFFF) != generation) {
+        return nullptr;
+    }
+    return server.clients.find(s);
+}
+
+/**
+ * @brief Handles a multishot accept completion.
+ * @param cqe Completion entry; res is the accepted descriptor or -errno
+ */
+void UringEngine::onAccept(const io_uring_cqe& cqe) {
+    if (!(cqe.flags & IORING_CQE_F_MORE)) {
+        armAccept();
+    }
+    if (cqe.res < 0) {
+        logError("Error at accept()", -cqe.res);
+        return;
+    }
+    SOCKET s = cqe.res;
+    sockaddr_in from{};
+    socklen_t fromLen = sizeof(from);
+    getpeername(s, (sockaddr*)&from, &fromLen);
+    if (static_cast<size_t>(s) >= generations.size()) {
+        generations.resize(s + 1, 0);
+        receiving.resize(s + 1, 0);
+        sends.resize(s + 1);
+    }
+    generations[s]++;
+    if (Client* client = server.addClient(s, from)) {
+        client->setAwaitingRequest();
+        armRecv(s);
+    }
+}
+
+/**
+ * @brief Handles a multishot receive completion.
+ * @param s Client socket
+ * @param generation Connection generation the receive was queued for
+ * @param cqe Completion entry; res is the byte count, 0 on EOF or -errno
+ */
+void UringEngine::onRecv(SOCKET s, uint32_t generation, const io_uring_cqe& cqe) {
+    bool hasBuffer = (cqe.flags & IORING_CQE_F_BUFFER) != 0;
+    uint16_t bufferId = static_cast<uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+    Client* client = findClient(s, generation);
+    if (client == nullptr || client->state == ClientState::Aborted) {
+        // Stale, or a removed client kept until its send completes
+        if (hasBuffer) {
+            ring.recycleBuffer(bufferId);
+        }
+        return;
+    }
+    if (cqe.res > 0) {
+        server.onReceived(*client, ring.buffer(bufferId), static_cast<size_t>(cqe.res));
+        ring.recycleBuffer(bufferId);
+        if (!client->readPaused && server.readsOverBudget(*client)) {
+            server.pauseReads(*client);
+            cancelRecv(s);
+        }
+    }
+    else if (cqe.res == 0) {
+        client->setCompleted();
+    }
+    else if (cqe.res != -ENOBUFS && cqe.res != -ECANCELED) {
+        logError("Error at recv()", -cqe.res, client->clientAddr);
+        client->setAborted();
+    }
+    // Multishot receives end on errors, buffer exhaustion or cancellation; re-arm while the client lives and may read
+    if (!(cqe.flags & IORING_CQE_F_MORE)) {
+        receiving[s] = 0;
+        if (!client->readPaused && client->state != ClientState::Completed && client->state != ClientState::Aborted) {
+            armRecv(s);
+        }
+    }
+    advance(*client);
+}
+
+/**
+ * @brief Handles a send completion.
+ * @param s Client socket
+ * @param generation Connection generation the send was queued for
+ * @param cqe Completion entry; res is the byte count or -errno
+ */
+void UringEngine::onSend(SOCKET s, uint32_t generation, const io_uring_cqe& cqe) {
+    Client* client = findClient(s, generation);
+    if (client == nullptr) {
+        return;
+    }
+    client->sendInFlight = false;
+    if (client->state == ClientState::Aborted) {
+        // The client was removed while this send ran: advance() finishes the removal
+    }
+    else if (cqe.res < 0) {
+        logError("Error at send()", -cqe.res, client->clientAddr);
+        client->setAborted();
+    }
+    else {
+        server.onSent(*client, static_cast<size_t>(cqe.res));
+    }
+    advance(*client);
+}
+
+/**
+ * @brief Advances the client FSM after a completion.
+ * @details Dispatches buffered requests (including ones that arrived while a response was
+ *          in flight), queues sends for ready responses and closes finished clients.
+ * @param client Reference to client object
+ */
+void UringEngine::advance(Client& client) {
+    while (true) {
+        if (client.state == ClientState::RequestBuffered || client.state == ClientState::ResponseReady) {
+            server.dispatch(client);
+        }
+        if (client.state == ClientState::ResponseReady) {
+            if (!client.sendInFlight) {
+                armSend(client);
+                continue;
+            }
+            server.updateTimeout(client);
+            return;
+        }
+        armAwait(client);
+        if (client.state == ClientState::Completed || client.state == ClientState::Aborted) {
+            server.removeClient(client.socket);
+        }
+        else {
+            server.updateTimeout(client);
+        }
+        return;
+    }
+}
+#endif
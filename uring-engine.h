@@ -0,0 +1,92 @@
+#pragma once
+#ifdef __linux__
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include "server.h"
+#include "uring.h"
+
+/**
+ * @brief Completion-based I/O engine built on io_uring.
+ * @details Keeps one multishot accept on the listen socket and one multishot receive per
+ *          connection, both fed by provided buffers, and issues sends as SQEs that are
+ *          submitted in one batch per loop iteration. Completions drive the same ClientState
+ *          FSM as the poll loop through Server::onReceived() / Server::onSent().
+ */
+class UringEngine {
+public:
+    // Sets up the ring and the provided-buffer pool for the given server
+    explicit UringEngine(Server& server);
+
+    // Returns true if io_uring is usable on this kernel
+    bool isValid() const;
+
+    // Runs the completion loop (the server must already be listening)
+    void run();
+
+private:
+    // Operation tag stored in the top byte of each SQE's user_data
+    enum Op : uint8_t {
+        OP_ACCEPT = 1,
+        OP_RECV,
+        OP_SEND,
+        OP_TICK,
+        OP_TICK_UPDATE,
+        OP_WATCH,
+        OP_JOBS,
+        OP_AWAIT,
+        OP_CANCEL
+    };
+
+    // Message header and slices of an in-flight gathered send (must outlive the SQE)
+    struct SendSlot {
+        msghdr message;
+        IoSlice slices[MAX_SEND_SLICES];
+    };
+
+    Server& server;                   // Server whose clients and FSM are driven
+    IoUring ring;                     // Submission/completion rings
+    bool valid;                       // Ring and buffers set up successfully
+    std::vector<uint32_t> generations; // Connection generation per descriptor (detects stale completions)
+    std::vector<uint8_t> receiving;   // Whether a multishot receive is armed per descriptor
+    std::vector<std::unique_ptr<SendSlot>> sends; // Send state per descriptor (heap-pinned)
+    __kernel_timespec tickDeadline;   // Absolute expiry of the timer-wheel timeout
+    bool tickArmed;                   // Whether a timer-wheel timeout is in flight
+    uint64_t tickArmedAt;             // Deadline (TimerWheel::now() ms) of the timeout in flight
+
+    // Queues a multishot accept on the listen socket
+    void armAccept();
+    // Queues a multishot buffer-select receive on a client socket
+    void armRecv(SOCKET s);
+    // Cancels the multishot receive of a client whose reads are paused
+    void cancelRecv(SOCKET s);
+    // Queues a gathered send of the client's queued responses
+    void armSend(Client& client);
+    // Queues or moves the timeout that wakes the loop for the next timer-wheel deadline
+    void armTick();
+    // Queues a multishot poll on the content cache's inotify descriptor
+    void armWatch();
+    // Queues a multishot poll on the server's I/O pool completion eventfd
+    void armJobs();
+    // Queues a one-shot poll on the socket a parked coroutine handler waits on
+    void armAwait(Client& client);
+    // Cancels the polls of socket waits the server abandoned
+    void cancelAwaits();
+
+    // Routes one completion to its handler
+    void handleCompletion(const io_uring_cqe& cqe);
+    // Registers an accepted socket as a new client
+    void onAccept(const io_uring_cqe& cqe);
+    // Feeds received bytes into the client FSM
+    void onRecv(SOCKET s, uint32_t generation, const io_uring_cqe& cqe);
+    // Feeds a send result into the client FSM
+    void onSend(SOCKET s, uint32_t generation, const io_uring_cqe& cqe);
+    // Advances the client FSM after a completion (dispatch, send or close)
+    void advance(Client& client);
+    // Returns the client for a completion, or nullptr if the completion is stale
+    Client* findClient(SOCKET s, uint32_t generation);
+
+    // Packs an operation, descriptor and generation into SQE user_data
+    static uint64_t pack(Op op, SOCKET s, uint32_t generation);
+};
+#endif
@@ -0,0 +1,208 @@
+#include "uring.h"
+#ifdef __linux__
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cstring>
+#include <cerrno>
+
+/**
+ * @brief Sets up the ring and maps the submission/completion queues.
+ * @param entries Number of submission queue entries
+ */
+IoUring::IoUring(unsigned entries)
+    : ringFd(-1), sqRing(MAP_FAILED), cqRing(MAP_FAILED), sqRingSize(0), cqRingSize(0),
+      sqes(nullptr), sqesSize(0), sqHead(nullptr), sqTail(nullptr), sqArray(nullptr), sqMask(0), sqEntries(0),
+      sqeTail(0), sqeSubmitted(0), cqHead(nullptr), cqTail(nullptr), cqMask(0), cqes(nullptr),
+      bufRing(nullptr), bufRingSize(0), bufMemory(nullptr), bufCount(0), bufSize(0), bufTail(0) {
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    ringFd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+    if (ringFd < 0) {
+        ringFd = -1;
+        return;
+    }
+    sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    bool singleMmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (singleMmap) {
+        sqRingSize = cqRingSize = (sqRingSize > cqRingSize) ? sqRingSize : cqRingSize;
+    }
+    sqRing = mmap(nullptr, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQ_RING);
+    if (sqRing == MAP_FAILED) {
+        ::close(ringFd);
+        ringFd = -1;
+        return;
+    }
+    cqRing = singleMmap ? sqRing
+        : mmap(nullptr, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_CQ_RING);
+    sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+    void* sqeMap = mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQES);
+    if (sqeMap != MAP_FAILED) {
+        sqes = static_cast<io_uring_sqe*>(sqeMap);
+    }
+    if (cqRing == MAP_FAILED || sqes == nullptr) {
+        // The destructor unmaps whatever was mapped
+        ::close(ringFd);
+        ringFd = -1;
+        return;
+    }
+
+    char* sq = static_cast<char*>(sqRing);
+    sqHead = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+    sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    sqMask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    sqEntries = params.sq_entries;
+    sqeTail = sqeSubmitted = *sqTail;
+
+    char* cq = static_cast<char*>(cqRing);
+    cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    cqMask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+    // SQEs are always used in ring order, so the index array is the identity mapping
+    for (unsigned i = 0; i < sqEntries; ++i) {
+        sqArray[i] = i;
+    }
+}
+
+/**
+ * @brief Unmaps all rings and closes the ring descriptor.
+ * @details Goes by the mappings rather than ringFd, so a constructor that failed halfway
+ *          (descriptor already closed) still releases what it mapped.
+ */
+IoUring::~IoUring() {
+    if (bufRing != nullptr) {
+        munmap(bufRing, bufRingSize);
+    }
+    delete[] bufMemory;
+    if (sqes != nullptr) {
+        munmap(sqes, sqesSize);
+    }
+    if (cqRing != MAP_FAILED && cqRing != sqRing) {
+        munmap(cqRing, cqRingSize);
+    }
+    if (sqRing != MAP_FAILED) {
+        munmap(sqRing, sqRingSize);
+    }
+    if (ringFd != -1) {
+        ::close(ringFd);
+    }
+}
+
+/**
+ * @brief Returns true if io_uring_setup() and the mappings succeeded.
+ */
+bool IoUring::isValid() const {
+    return ringFd != -1;
+}
+
+/**
+ * @brief Returns the next free SQE, zeroed.
+ * @details If the submission queue is full, queued SQEs are submitted first.
+ * @return SQE pointer, or nullptr if the queue is still full
+ */
+io_uring_sqe* IoUring::getSqe() {
+    unsigned head = __atomic_load_n(sqHead, __ATOMIC_ACQUIRE);
+    if (sqeTail - head >= sqEntries) {
+        submitAndWait(0);
+        head = __atomic_load_n(sqHead, __ATOMIC_ACQUIRE);
+        if (sqeTail - head >= sqEntries) {
+            return nullptr;
+        }
+    }
+    io_uring_sqe* sqe = &sqes[sqeTail & sqMask];
+    std::memset(sqe, 0, sizeof(*sqe));
+    sqeTail++;
+    return sqe;
+}
+
+/**
+ * @brief Publishes queued SQEs and enters the kernel.
+ * @param waitNr Minimum number of completions to wait for
+ * @return Number of SQEs consumed, or -errno on failure
+ */
+int IoUring::submitAndWait(unsigned waitNr) {
+    unsigned toSubmit = sqeTail - sqeSubmitted;
+    __atomic_store_n(sqTail, sqeTail, __ATOMIC_RELEASE);
+    sqeSubmitted = sqeTail;
+    // GETEVENTS is always set so overflowed completions get flushed into the CQ ring
+    int ret = static_cast<int>(syscall(__NR_io_uring_enter, ringFd, toSubmit, waitNr, IORING_ENTER_GETEVENTS, nullptr, 0));
+    return ret < 0 ? -errno : ret;
+}
+
+/**
+ * @brief Returns the next pending completion without consuming it.
+ * @return CQE pointer, or nullptr if the completion queue is empty
+ */
+io_uring_cqe* IoUring::peekCqe() {
+    unsigned head = *cqHead;
+    if (head == __atomic_load_n(cqTail, __ATOMIC_ACQUIRE)) {
+        return nullptr;
+    }
+    return &cqes[head & cqMask];
+}
+
+/**
+ * @brief Consumes the completion returned by peekCqe().
+ */
+void IoUring::advanceCqe() {
+    __atomic_store_n(cqHead, *cqHead + 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Registers a ring of provided buffers for buffer-select receives.
+ * @param count Number of buffers (power of two, at most 32768)
+ * @param size Size of each buffer in bytes
+ * @param group Buffer group id referenced by SQEs
+ * @return True if successful, false otherwise
+ */
+bool IoUring::registerBuffers(unsigned count, unsigned size, uint16_t group) {
+    bufRingSize = count * sizeof(io_uring_buf);
+    void* ringMem = mmap(nullptr, bufRingSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+    if (ringMem == MAP_FAILED) {
+        return false;
+    }
+    bufRing = static_cast<io_uring_buf_ring*>(ringMem);
+    io_uring_buf_reg reg;
+    std::memset(&reg, 0, sizeof(reg));
+    reg.ring_addr = reinterpret_cast<uint64_t>(bufRing);
+    reg.ring_entries = count;
+    reg.bgid = group;
+    if (syscall(__NR_io_uring_register, ringFd, IORING_REGISTER_PBUF_RING, &reg, 1) < 0) {
+        munmap(bufRing, bufRingSize);
+        bufRing = nullptr;
+        return false;
+    }
+    bufCount = count;
+    bufSize = size;
+    bufMemory = new char[static_cast<size_t>(count) * size];
+    bufTail = 0;
+    for (unsigned i = 0; i < count; ++i) {
+        recycleBuffer(static_cast<uint16_t>(i));
+    }
+    return true;
+}
+
+/**
+ * @brief Returns the memory backing provided buffer `id`.
+ */
+char* IoUring::buffer(uint16_t id) const {
+    return bufMemory + static_cast<size_t>(id) * bufSize;
+}
+
+/**
+ * @brief Returns provided buffer `id` to the kernel so later receives can use it.
+ */
+void IoUring::recycleBuffer(uint16_t id) {
+    // Index from the ring base: in C++ the header's empty flex-array wrapper shifts `bufs` by 8 bytes
+    io_uring_buf* buf = reinterpret_cast<io_uring_buf*>(bufRing) + (bufTail & (bufCount - 1));
+    buf->addr = reinterpret_cast<uint64_t>(buffer(id));
+    buf->len = bufSize;
+    buf->bid = id;
+    bufTail++;
+    __atomic_store_n(&bufRing->tail, bufTail, __ATOMIC_RELEASE);
+}
+#endif
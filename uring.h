@@ -0,0 +1,69 @@
+#pragma once
+#ifdef __linux__
+#include <linux/io_uring.h>
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * @brief Minimal io_uring ring wrapper (raw syscalls, no liburing dependency).
+ * @details Owns the submission/completion rings and one provided-buffer ring used by
+ *          multishot receives. Not thread-safe: one ring per event-loop thread.
+ */
+class IoUring {
+public:
+    // Sets up a ring with the given number of submission entries
+    explicit IoUring(unsigned entries);
+    // Unmaps the rings and closes the ring descriptor
+    ~IoUring();
+
+    IoUring(const IoUring&) = delete;
+    IoUring& operator=(const IoUring&) = delete;
+
+    // Returns true if the ring was set up successfully
+    bool isValid() const;
+
+    // Returns a zeroed SQE, submitting queued ones first if the queue is full (nullptr on failure)
+    io_uring_sqe* getSqe();
+    // Submits queued SQEs and waits for at least waitNr completions
+    int submitAndWait(unsigned waitNr);
+
+    // Returns the next completion or nullptr if none is pending
+    io_uring_cqe* peekCqe();
+    // Marks the completion returned by peekCqe() as consumed
+    void advanceCqe();
+
+    // Registers `count` provided buffers of `size` bytes under buffer group `group`
+    bool registerBuffers(unsigned count, unsigned size, uint16_t group);
+    // Returns the memory of provided buffer `id`
+    char* buffer(uint16_t id) const;
+    // Hands provided buffer `id` back to the kernel
+    void recycleBuffer(uint16_t id);
+
+private:
+    int ringFd;               // io_uring descriptor
+    void* sqRing;             // Mapped submission ring
+    void* cqRing;             // Mapped completion ring (may alias sqRing)
+    size_t sqRingSize;        // Size of the sqRing mapping
+    size_t cqRingSize;        // Size of the cqRing mapping
+    io_uring_sqe* sqes;       // Mapped SQE array
+    size_t sqesSize;          // Size of the SQE mapping
+    unsigned* sqHead;         // Kernel-owned submission head
+    unsigned* sqTail;         // Our submission tail
+    unsigned* sqArray;        // SQE index array
+    unsigned sqMask;          // Submission ring mask
+    unsigned sqEntries;       // Submission ring size
+    unsigned sqeTail;         // SQEs handed out but not yet published
+    unsigned sqeSubmitted;    // SQEs published to the kernel
+    unsigned* cqHead;         // Our completion head
+    unsigned* cqTail;         // Kernel-owned completion tail
+    unsigned cqMask;          // Completion ring mask
+    io_uring_cqe* cqes;       // Mapped CQE array
+
+    io_uring_buf_ring* bufRing; // Provided-buffer ring shared with the kernel
+    size_t bufRingSize;       // Size of the bufRing mapping
+    char* bufMemory;          // Backing memory for provided buffers
+    unsigned bufCount;        // Number of provided buffers
+    unsigned bufSize;         // Size of each provided buffer
+    uint16_t bufTail;         // Local tail of the provided-buffer ring
+};
+#endif
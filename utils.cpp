@@ -1,7 +1,21 @@
 #include "utils.h"
 
-void ensureLogDir() {
-    _mkdir("log"); // Creates log directory if it doesn't exist
+// Log directory of the calling thread; each reactor thread gets its own sink
+static thread_local std::string logDir = "log";
+
+/**
+ * @brief Redirects the calling thread's log files into log/<name>/.
+ * @param name Sink name (e.g. "reactor-2"), empty to log directly into log/
+ */
+void setLogSink(const std::string& name) {
+    logDir = name.empty() ? "log" : "log/" + name;
+}
+
+/**
+ * @brief Returns the calling thread's log directory.
+ */
+const std::string& logSink() {
+    return logDir;
 }
 
 /**
@@ -13,7 +27,11 @@ std::string getTimestamp() {
     auto now = system_clock::now();
     std::time_t now_c = system_clock::to_time_t(now);
     tm timeInfo;
+#ifdef _WIN32
     localtime_s(&timeInfo, &now_c);
+#else
+    localtime_r(&now_c, &timeInfo);
+#endif
 
     char timeBuf[32];
     std::strftime(timeBuf, sizeof(timeBuf), "%Y-%m-%d %H:%M:%S", &timeInfo);
@@ -49,15 +67,20 @@ std::string trim(const std::string& str) {
  * @param port Optional port number related to the error (default -1 means not provided)
  */
 void logError(const std::string& message, int errorCode, const std::string& clientAddr) {
-	// Currently disabled to avoid file I/O overhead in high-frequency error scenarios
-    ensureLogDir();
-    std::ofstream logFile("log/web-server-error.log", std::ios::app);
-    logFile << "[" << getTimestamp() << "] ";
-    logFile << message << " (WSAError: " << errorCode << ")";
+    Logger& logger = Logger::instance();
+    if (!logger.shouldLog(LogCategory::Error)) {
+        return;
+    }
+    LogRecord record;
+    record.path = logDir + "/web-server-error.log";
+    record.text = "[] " + message + " (WSAError: " + std::to_string(errorCode) + ")";
     if (!clientAddr.empty()) {
-		logFile << " [Client: " << clientAddr << "]";
+        record.text += " [Client: " + clientAddr + "]";
     }
-    logFile << std::endl;
+    record.text += "\n";
+    record.timestampPos = 1;
+    record.time = std::chrono::system_clock::now();
+    logger.submit(std::move(record));
 }
 
 /**
@@ -67,29 +90,46 @@ void logError(const std::string& message, int errorCode, const std::string& clie
  * @param data Data to log
  */
 void logEvent(const std::string& filename, const std::string& clientAddr, const std::string& data) {
-    ensureLogDir();
-    std::ofstream logFile("log/" + filename, std::ios::app);
-    if (logFile.is_open()) {
-        logFile << "--------------------" << std::endl;
-        logFile << "[" << getTimestamp() << "] [" << clientAddr << "]" << std::endl;
-        logFile << data << std::endl;
-        logFile << "--------------------" << std::endl;
-        logFile.close();
-    }
+    logEvent(filename, clientAddr, data.data(), data.size());
 }
 
 /**
- * @brief Logs sent or received data with timestamp and client address to a file.
+ * @brief Logs sent or received bytes with timestamp and client address to a file.
+ * @details Takes a raw range so callers need not copy the payload when the record is sampled out.
  * @param filename Log file name
  * @param clientAddr Client address string
  * @param data Data to log
+ * @param length Number of bytes to log
+ */
+void logEvent(const std::string& filename, const std::string& clientAddr, const char* data, size_t length) {
+    Logger& logger = Logger::instance();
+    if (!logger.shouldLog(LogCategory::Payload)) {
+        return;
+    }
+    static const std::string rule = "--------------------\n";
+    LogRecord record;
+    record.path = logDir + "/" + filename;
+    record.text.reserve(2 * rule.size() + clientAddr.size() + length + 8);
+    record.text.append(rule).append("[] [").append(clientAddr).append("]\n").append(data, length).append("\n").append(rule);
+    record.timestampPos = rule.size() + 1;
+    record.time = std::chrono::system_clock::now();
+    logger.submit(std::move(record));
+}
+
+/**
+ * @brief Logs arbitrary data to a file.
+ * @param filename Log file name
+ * @param data Data to log
  */
 void logData(const std::string& filename, const std::string& data) {
-    ensureLogDir();
-    std::ofstream logFile("log/" + filename, std::ios::app);
-    if (logFile.is_open()) {
-        logFile << data << std::endl;
+    Logger& logger = Logger::instance();
+    if (!logger.shouldLog(LogCategory::Data)) {
+        return;
     }
+    LogRecord record;
+    record.path = logDir + "/" + filename;
+    record.text = data + "\n";
+    logger.submit(std::move(record));
 }
 
 /**
@@ -99,20 +139,33 @@ void logData(const std::string& filename, const std::string& data) {
  * @param newState New state
  */
 void logClientState(const std::string& clientAddr, const std::string& oldState, const std::string& newState) {
-    ensureLogDir();
-    std::ofstream logFile("log/web-server-clientstate.log", std::ios::app);
-    if (logFile.is_open()) {
-        logFile << "[" << getTimestamp() << "] [" << clientAddr << "] "
-                << "State transition: " << oldState << " -> " << newState << std::endl;
-        logFile.close();
+    Logger& logger = Logger::instance();
+    if (!logger.shouldLog(LogCategory::State)) {
+        return;
     }
+    LogRecord record;
+    record.path = logDir + "/web-server-clientstate.log";
+    record.text = "[] [" + clientAddr + "] State transition: " + oldState + " -> " + newState + "\n";
+    record.timestampPos = 1;
+    record.time = std::chrono::system_clock::now();
+    logger.submit(std::move(record));
+}
+
+/**
+ * @brief Checks if records of the given category pass the level filter.
+ * @details Lets callers skip building strings when their category is switched off.
+ * @param category Record category
+ * @return True if the category is enabled
+ */
+bool logEnabled(LogCategory category) {
+    return Logger::instance().isEnabled(category);
 }
 
-bool isValidPutPath(const std::string& path, std::string& baseName, std::string& extension) {
+bool isValidPutPath(std::string_view path, std::string& baseName, std::string& extension) {
     if (path.empty() || path[0] != '/' || path.size() < 2) {
         return false;
     }
-    std::string candidate = path.substr(1); // remove leading '/'
+    std::string candidate(path.substr(1)); // remove leading '/'
     size_t dotPos = candidate.find_last_of('.');
     if (dotPos == std::string::npos || dotPos == 0 || dotPos == candidate.size() - 1) {
         // No extension or invalid position
@@ -1,12 +1,13 @@
 #pragma once
 #include <string>
+#include <string_view>
 #include <algorithm>
 #include <cctype>
 #include <fstream>
 #include <ctime>
 #include <chrono>
-#include <direct.h> 
-#include <winsock2.h>
+#include "platform.h"
+#include "logger.h"
 
 // Returns the current timestamp as a formatted string
 std::string getTimestamp();
@@ -14,17 +15,29 @@ std::string getTimestamp();
 // Trims whitespace from both ends of a string
 std::string trim(const std::string& str);
 
+// Redirects the calling thread's log files into log/<name>/ (empty name = log/)
+void setLogSink(const std::string& name);
+
+// Returns the calling thread's log directory (log or log/<name>)
+const std::string& logSink();
+
 // Logs an error message with timestamp to a file in the working directory
 void logError(const std::string& message, int wsaError = -1, const std::string& clientAddr = "");
 
 // Logs sent or received data with timestamp and client address to a file
 void logEvent(const std::string& filename, const std::string& clientAddr, const std::string& data);
 
+// Logs a raw byte range with timestamp and client address to a file (no copy if sampled out)
+void logEvent(const std::string& filename, const std::string& clientAddr, const char* data, size_t length);
+
 // Logs arbitrary data with timestamp to a file
 void logData(const std::string& filename, const std::string& data);
 
 // Logs client state transitions with timestamp
 void logClientState(const std::string& clientAddr, const std::string& oldState, const std::string& newState);
 
+// Returns true if records of this category pass the level filter
+bool logEnabled(LogCategory category);
+
 // Validates and sanitizes PUT path, returns true if valid and sets baseName
-bool isValidPutPath(const std::string& path, std::string& baseName, std::string& extension);
\ No newline at end of file
+bool isValidPutPath(std::string_view path, std::string& baseName, std::string& extension);
\ No newline at end of file